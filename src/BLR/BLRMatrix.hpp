@@ -33,6 +33,7 @@
 #define BLR_MATRIX_HPP
 
 #include <cassert>
+#include <algorithm>
 
 #include "../dense/DenseMatrix.hpp"
 #include "BLROptions.hpp"
@@ -207,6 +208,8 @@ namespace strumpack {
           // V_ = Vt.transpose();
         }
       }
+      LRTile(DenseM_t&& U, DenseM_t&& V)
+        : U_(std::move(U)), V_(std::move(V)) {}
 
       std::size_t rows() const { return U_.rows(); }
       std::size_t cols() const { return V_.cols(); }
@@ -347,6 +350,189 @@ namespace strumpack {
     }
 
 
+    /**
+     * Accumulator for low-rank Schur complement updates targeting a
+     * single tile, used in the LUAR and CUFS variants of the BLR
+     * factorization. The sum of the updates is stored as U*V, with
+     * the low-rank products concatenated in U and V. When the
+     * accumulated rank becomes too large, or before the update is
+     * applied, U*V is recompressed.
+     */
+    template<typename scalar_t> class LRUpdate {
+      using DenseM_t = DenseMatrix<scalar_t>;
+      using Opts_t = BLROptions<scalar_t>;
+
+    public:
+      std::size_t rank() const { return U_.cols(); }
+
+      /**
+       * Accumulate the update -a*b, where at least one of a and b
+       * is low-rank, or the target is a low-rank tile (CUFS).
+       */
+      void add(const BLRTile<scalar_t>& a, const BLRTile<scalar_t>& b,
+               const Opts_t& /*opts*/) {
+        const auto depth = params::task_recursion_cutoff_level;
+        DenseM_t U, V;
+        if (a.is_low_rank()) {
+          if (b.is_low_rank()) {
+            DenseM_t T(a.rank(), b.rank());
+            gemm(Trans::N, Trans::N, scalar_t(1.), a.V(), b.U(),
+                 scalar_t(0.), T, depth);
+            if (a.rank() <= b.rank()) {
+              U = a.U();
+              V = DenseM_t(T.rows(), b.cols());
+              gemm(Trans::N, Trans::N, scalar_t(-1.), T, b.V(),
+                   scalar_t(0.), V, depth);
+            } else {
+              U = DenseM_t(a.rows(), T.cols());
+              gemm(Trans::N, Trans::N, scalar_t(-1.), a.U(), T,
+                   scalar_t(0.), U, depth);
+              V = b.V();
+            }
+          } else {
+            U = a.U();
+            V = DenseM_t(a.rank(), b.cols());
+            gemm(Trans::N, Trans::N, scalar_t(-1.), a.V(), b.D(),
+                 scalar_t(0.), V, depth);
+          }
+        } else if (b.is_low_rank()) {
+          U = DenseM_t(a.rows(), b.rank());
+          gemm(Trans::N, Trans::N, scalar_t(-1.), a.D(), b.U(),
+               scalar_t(0.), U, depth);
+          V = b.V();
+        } else {
+          U = a.D();
+          V = b.D();
+          V.scale(scalar_t(-1.), depth);
+        }
+        add(U, V);
+      }
+
+      /**
+       * Whether the accumulated rank is so large that the update
+       * should be applied (or merged) now, rather than accumulated
+       * further.
+       */
+      bool full() const {
+        return rank() && rank() >= std::min(U_.rows(), V_.cols());
+      }
+
+      /**
+       * Add the accumulated update to the dense matrix C, and clear
+       * the accumulator. If the accumulated rank is small compared
+       * to the size of C, the update is first recompressed, which
+       * pays off when the accumulated products are (nearly) linearly
+       * dependent.
+       */
+      void apply(DenseM_t& C, const Opts_t& opts) {
+        if (!rank()) return;
+        if (nr_updates_ > 1 && 2*rank() < std::min(C.rows(), C.cols()))
+          recompress(opts);
+        gemm(Trans::N, Trans::N, scalar_t(1.), U_, V_, scalar_t(1.), C,
+             params::task_recursion_cutoff_level);
+        clear();
+      }
+
+      /**
+       * Merge the accumulated update into the low-rank tile t,
+       * ie. t.U()*t.V() + U*V, recompress and clear the accumulator.
+       */
+      void merge(BLRTile<scalar_t>& t, const Opts_t& opts) {
+        if (!rank()) return;
+        assert(t.is_low_rank());
+        add(t.U(), t.V());
+        recompress(opts);
+        std::swap(t.U(), U_);
+        std::swap(t.V(), V_);
+        clear();
+      }
+
+      void clear() {
+        U_.clear();
+        V_.clear();
+        nr_updates_ = 0;
+      }
+
+    private:
+      DenseM_t U_, V_;
+      int nr_updates_ = 0;
+
+      // the products are counted by the BLAS wrappers, the
+      // concatenation only moves data. U and V can be wrappers,
+      // for which nonzeros() is 0, so count rows()*cols()
+      void add(const DenseM_t& U, const DenseM_t& V) {
+        if (!rank()) {
+          U_ = U;
+          V_ = V;
+        } else {
+          STRUMPACK_BYTES
+            (sizeof(scalar_t) * 2 *
+             (U_.rows()*U_.cols() + U.rows()*U.cols() +
+              V_.rows()*V_.cols() + V.rows()*V.cols()));
+          U_ = hconcat(U_, U);
+          V_ = vconcat(V_, V);
+        }
+        nr_updates_++;
+      }
+
+      /**
+       * Recompress U*V: with Q*R = U, compress R*V = U2*V2, so that
+       * U*V ~= (Q*U2)*V2. If the rank is not smaller than the tile
+       * dimensions, compress the product U*V directly. The (rank
+       * revealing) QR factorizations are not counted by the BLAS
+       * wrappers, so they are counted here.
+       */
+      void recompress(const Opts_t& opts) {
+        const auto depth = params::task_recursion_cutoff_level;
+        const long long c = is_complex<scalar_t>() ? 4 : 1;
+        auto m = U_.rows(), n = V_.cols(), r = rank();
+        if (r >= std::min(m, n)) {
+          DenseM_t UV(m, n);
+          gemm(Trans::N, Trans::N, scalar_t(1.), U_, V_,
+               scalar_t(0.), UV, depth);
+          UV.low_rank(U_, V_, opts.rel_tol(), opts.abs_tol(),
+                      opts.max_rank(), depth);
+          STRUMPACK_FLOPS(c * blas::geqp3_flops(m, n));
+        } else {
+          DenseM_t Q(U_), U2;
+          scalar_t rmax, rmin;
+          Q.orthogonalize(rmax, rmin, depth);
+          STRUMPACK_FLOPS(c * blas::geqrf_flops(m, r));
+          DenseM_t R(r, r), RV(r, n);
+          gemm(Trans::C, Trans::N, scalar_t(1.), Q, U_,
+               scalar_t(0.), R, depth);
+          gemm(Trans::N, Trans::N, scalar_t(1.), R, V_,
+               scalar_t(0.), RV, depth);
+          RV.low_rank(U2, V_, opts.rel_tol(), opts.abs_tol(),
+                      opts.max_rank(), depth);
+          STRUMPACK_FLOPS(c * blas::geqp3_flops(r, n));
+          U_ = DenseM_t(m, U2.cols());
+          gemm(Trans::N, Trans::N, scalar_t(1.), Q, U2,
+               scalar_t(0.), U_, depth);
+        }
+        nr_updates_ = 1;
+      }
+    };
+
+    /**
+     * Schur complement update C -= a*b. With the RL algorithm, or if
+     * both a and b are dense, the update is applied directly to the
+     * dense C, otherwise it is accumulated in acc.
+     */
+    template<typename scalar_t> void
+    Schur_update(const BLRTile<scalar_t>& a, const BLRTile<scalar_t>& b,
+                 DenseMatrix<scalar_t>& C, LRUpdate<scalar_t>& acc,
+                 const BLROptions<scalar_t>& opts) {
+      if (opts.factor_algorithm() == FactorAlgorithm::RL ||
+          (!a.is_low_rank() && !b.is_low_rank()))
+        gemm(Trans::N, Trans::N, scalar_t(-1.), a, b, scalar_t(1.), C);
+      else {
+        acc.add(a, b, opts);
+        if (acc.full()) acc.apply(C, opts);
+      }
+    }
+
+
     template<typename scalar_t> class BLRMatrix {
       using DenseM_t = DenseMatrix<scalar_t>;
       using DenseMW_t = DenseMatrixWrapper<scalar_t>;
@@ -366,6 +552,26 @@ namespace strumpack {
               (new LRTile<scalar_t>(tile(A, i, j), opts));
       }
 
+      /**
+       * Compress A as a BLR matrix, with low-rank tiles for the
+       * admissible blocks, and dense tiles for the others.
+       */
+      BLRMatrix(DenseM_t& A,
+                const std::vector<std::size_t>& rowtiles,
+                const std::vector<std::size_t>& coltiles,
+                const std::function<bool(std::size_t,std::size_t)>& admissible,
+                const Opts_t& opts)
+        : BLRMatrix<scalar_t>(A.rows(), rowtiles, A.cols(), coltiles) {
+#if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
+#pragma omp taskloop collapse(2) default(shared)
+#endif
+        for (std::size_t j=0; j<colblocks(); j++)
+          for (std::size_t i=0; i<rowblocks(); i++) {
+            if (admissible(i, j)) create_LR_tile(i, j, A, opts);
+            else create_dense_tile(i, j, A);
+          }
+      }
+
       BLRMatrix(const std::vector<std::size_t>& tiles,
                 const std::function<bool(std::size_t,std::size_t)>& admissible,
                 DenseM_t& A, std::vector<int>& piv, const Opts_t& opts)
@@ -373,6 +579,10 @@ namespace strumpack {
         assert(rowblocks() == colblocks());
         piv.resize(rows());
         auto rb = rowblocks();
+        std::vector<LRUpdate<scalar_t>> acc(rb*rb);
+        compress_admissible
+          (A, [&](std::size_t i, std::size_t j) {
+            return i != j && admissible(i, j); }, opts);
 #if defined(STRUMPACK_USE_OPENMP_TASK_DEPEND)
         auto B = new int[rb*rb](); // dummy for task synchronization
 #pragma omp taskgroup
@@ -384,7 +594,7 @@ namespace strumpack {
 #pragma omp task default(shared) firstprivate(i,ii) depend(inout:B[ii])
 #endif
             {
-              create_dense_tile(i, i, A);
+              compress_tile(i, i, A, acc[i+rb*i], false, opts);
               auto tpiv = tile(i, i).LU();
               std::copy(tpiv.begin(), tpiv.end(), piv.begin()+tileroff(i));
             }
@@ -395,8 +605,7 @@ namespace strumpack {
   depend(in:B[ii]) depend(inout:B[ij])
 #endif
               { // these blocks have received all updates, compress now
-                if (admissible(i, j)) create_LR_tile(i, j, A, opts);
-                else create_dense_tile(i, j, A);
+                compress_tile(i, j, A, acc[i+rb*j], admissible(i, j), opts);
                 // permute and solve with L, blocks right from the diagonal block
                 std::vector<int> tpiv
                   (piv.begin()+tileroff(i), piv.begin()+tileroff(i+1));
@@ -410,8 +619,7 @@ namespace strumpack {
   depend(in:B[ii]) depend(inout:B[ji])
 #endif
               {
-                if (admissible(j, i)) create_LR_tile(j, i, A, opts);
-                else create_dense_tile(j, i, A);
+                compress_tile(j, i, A, acc[j+rb*i], admissible(j, i), opts);
                 // solve with U, the blocks under the diagonal block
                 trsm(Side::R, UpLo::U, Trans::N, Diag::N,
                      scalar_t(1.), tile(i, i), tile(j, i));
@@ -424,10 +632,10 @@ namespace strumpack {
 #pragma omp task default(shared) firstprivate(i,j,k,ij,ki,kj)   \
   depend(in:B[ij],B[ki]) depend(inout:B[kj])
 #endif
-                { // Schur complement updates, always into full rank
-                  DenseMW_t Akj = tile(A, k, j);
-                  gemm(Trans::N, Trans::N, scalar_t(-1.),
-                       tile(k, i), tile(i, j), scalar_t(1.), Akj);
+                { // Schur complement updates, accumulated in low-rank
+                  // for LUAR/CUFS, see BLR::Schur_update
+                  Schur_update_tile
+                    (k, j, A, tile(k, i), tile(i, j), acc[k+rb*j], opts);
                 }
               }
           }
@@ -459,6 +667,81 @@ namespace strumpack {
         return mrank;
       }
 
+      /**
+       * Add the elements (I[i],J[j]) of this matrix to B(oI[i],oJ[j]).
+       * The rows and columns are grouped per tile, so every tile is
+       * visited once: a dense tile is read directly, for a low-rank
+       * tile only the selected rows of U and columns of V are
+       * multiplied.
+       */
+      void extract_add
+      (const std::vector<std::size_t>& I, const std::vector<std::size_t>& J,
+       DenseM_t& B, const std::vector<std::size_t>& oI,
+       const std::vector<std::size_t>& oJ) const {
+        std::vector<std::vector<std::size_t>> ti(rowblocks()), tj(colblocks());
+        for (std::size_t i=0; i<I.size(); i++)
+          ti[std::upper_bound(roff_.begin(), roff_.end(), I[i])
+             - roff_.begin() - 1].push_back(i);
+        for (std::size_t j=0; j<J.size(); j++)
+          tj[std::upper_bound(coff_.begin(), coff_.end(), J[j])
+             - coff_.begin() - 1].push_back(j);
+        for (std::size_t c=0; c<colblocks(); c++) {
+          if (tj[c].empty()) continue;
+          for (std::size_t r=0; r<rowblocks(); r++) {
+            if (ti[r].empty()) continue;
+            auto& t = tile(r, c);
+            const auto& tr = ti[r];
+            const auto& tc = tj[c];
+            const auto r0 = tileroff(r), c0 = tilecoff(c);
+            if (t.is_low_rank()) {
+              const auto k = t.rank();
+              if (!k) continue;
+              DenseM_t Ur(tr.size(), k), Vc(k, tc.size()),
+                T(tr.size(), tc.size());
+              for (std::size_t l=0; l<k; l++)
+                for (std::size_t i=0; i<tr.size(); i++)
+                  Ur(i, l) = t.U()(I[tr[i]]-r0, l);
+              for (std::size_t j=0; j<tc.size(); j++)
+                for (std::size_t l=0; l<k; l++)
+                  Vc(l, j) = t.V()(l, J[tc[j]]-c0);
+              gemm(Trans::N, Trans::N, scalar_t(1.), Ur, Vc, scalar_t(0.), T);
+              for (std::size_t j=0; j<tc.size(); j++)
+                for (std::size_t i=0; i<tr.size(); i++)
+                  B(oI[tr[i]], oJ[tc[j]]) += T(i, j);
+            } else {
+              for (std::size_t j=0; j<tc.size(); j++)
+                for (std::size_t i=0; i<tr.size(); i++)
+                  B(oI[tr[i]], oJ[tc[j]]) +=
+                    t.D()(I[tr[i]]-r0, J[tc[j]]-c0);
+            }
+          }
+        }
+      }
+
+      /**
+       * Expand the matrix one tile at a time, and call op(D, r, c)
+       * for each tile, with D the dense tile and (r, c) the offset of
+       * the tile in this matrix. This avoids allocating the full
+       * dense matrix. The tiles are processed in parallel, so op
+       * should be safe to call concurrently for different tiles.
+       */
+      template<typename op_t> void
+      for_each_dense_tile(const op_t& op, int task_depth) const {
+#if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
+#pragma omp taskloop collapse(2) default(shared)                        \
+  if(task_depth < params::task_recursion_cutoff_level)
+#endif
+        for (std::size_t j=0; j<colblocks(); j++)
+          for (std::size_t i=0; i<rowblocks(); i++) {
+            auto& t = tile(i, j);
+            if (t.is_low_rank()) {
+              DenseM_t D(t.rows(), t.cols());
+              t.dense(D);
+              op(D, tileroff(i), tilecoff(j));
+            } else op(t.D(), tileroff(i), tilecoff(j));
+          }
+      }
+
       DenseM_t dense() const {
         DenseM_t A(rows(), cols());
 #if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
@@ -509,10 +792,10 @@ namespace strumpack {
       }
 
     private:
-      std::size_t m_;
-      std::size_t n_;
-      std::size_t nbrows_;
-      std::size_t nbcols_;
+      std::size_t m_ = 0;
+      std::size_t n_ = 0;
+      std::size_t nbrows_ = 0;
+      std::size_t nbcols_ = 0;
       std::vector<std::size_t> roff_;
       std::vector<std::size_t> coff_;
       std::vector<std::unique_ptr<BLRTile<scalar_t>>> blocks_;
@@ -569,6 +852,68 @@ namespace strumpack {
           create_dense_tile(i, j, A);
       }
 
+      /**
+       * CUFS: compress the tiles which are admissible before they
+       * receive any Schur complement updates.
+       */
+      void compress_admissible
+      (DenseM_t& A, const std::function<bool(std::size_t,std::size_t)>& adm,
+       const Opts_t& opts) {
+        if (opts.factor_algorithm() != FactorAlgorithm::CUFS) return;
+#if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
+#pragma omp taskloop collapse(2) default(shared)
+#endif
+        for (std::size_t j=0; j<colblocks(); j++)
+          for (std::size_t i=0; i<rowblocks(); i++)
+            if (adm(i, j)) create_LR_tile(i, j, A, opts);
+      }
+
+      /**
+       * Schur complement update -a*b to tile (i,j). If the tile was
+       * already compressed (CUFS), the update goes into the tile,
+       * otherwise into the corresponding block of A.
+       */
+      void Schur_update_tile
+      (std::size_t i, std::size_t j, DenseM_t& A,
+       const BLRTile<scalar_t>& a, const BLRTile<scalar_t>& b,
+       LRUpdate<scalar_t>& acc, const Opts_t& opts) {
+        if (!block(i, j)) {
+          DenseMW_t Aij = tile(A, i, j);
+          Schur_update(a, b, Aij, acc, opts);
+        } else if (tile(i, j).is_low_rank()) {
+          acc.add(a, b, opts);
+          if (acc.full()) acc.merge(tile(i, j), opts);
+        } else gemm(Trans::N, Trans::N, scalar_t(-1.), a, b,
+                  scalar_t(1.), tile(i, j).D());
+      }
+
+      /**
+       * Tile (i,j) has received all Schur complement updates. Apply
+       * the accumulated low-rank updates and compress the tile if it
+       * is admissible. If the tile was already compressed (CUFS), the
+       * accumulated updates are merged into the tile.
+       */
+      void compress_tile
+      (std::size_t i, std::size_t j, DenseM_t& A, LRUpdate<scalar_t>& acc,
+       bool admissible, const Opts_t& opts) {
+        if (block(i, j)) {
+          auto& t = tile(i, j);
+          if (!t.is_low_rank()) return;
+          acc.merge(t, opts);
+          if (t.rank()*(t.rows() + t.cols()) > t.rows()*t.cols()) {
+            DenseM_t D(t.rows(), t.cols());
+            t.dense(D);
+            block(i, j) = std::unique_ptr<DenseTile<scalar_t>>
+              (new DenseTile<scalar_t>(D));
+          }
+          return;
+        }
+        DenseMW_t Aij = tile(A, i, j);
+        acc.apply(Aij, opts);
+        if (admissible) create_LR_tile(i, j, A, opts);
+        else create_dense_tile(i, j, A);
+      }
+
       template<typename T> friend void
       trsm(Side s, UpLo ul, Trans ta, Diag d, T alpha,
            const BLRMatrix<T>& a, BLRMatrix<T>& b, int task_depth);
@@ -579,6 +924,9 @@ namespace strumpack {
       gemm(Trans ta, Trans tb, T alpha, const BLRMatrix<T>& a,
            const BLRMatrix<T>& b, T beta, DenseMatrix<T>& c, int task_depth);
       template<typename T> friend void
+      gemm(Trans ta, Trans tb, T alpha, const BLRMatrix<T>& a,
+           const DenseMatrix<T>& b, T beta, DenseMatrix<T>& c, int task_depth);
+      template<typename T> friend void
       trsv(UpLo ul, Trans ta, Diag d, const BLRMatrix<T>& a,
            DenseMatrix<T>& b, int task_depth);
       template<typename T> friend void
@@ -620,6 +968,16 @@ namespace strumpack {
       piv.resize(B11.rows());
       auto rb = B11.rowblocks();
       auto rb2 = B21.rowblocks();
+      // accumulated low-rank updates, only used for LUAR and CUFS
+      std::vector<LRUpdate<scalar_t>> acc11(rb*rb), acc12(rb*rb2),
+        acc21(rb2*rb), acc22(rb2*rb2);
+      B11.compress_admissible
+        (A11, [&](std::size_t i, std::size_t j) {
+          return i != j && admissible(i, j); }, opts);
+      B12.compress_admissible
+        (A12, [](std::size_t, std::size_t) { return true; }, opts);
+      B21.compress_admissible
+        (A21, [](std::size_t, std::size_t) { return true; }, opts);
 #if defined(STRUMPACK_USE_OPENMP_TASK_DEPEND)
       auto lrb = rb+rb2;
       auto B = new int[lrb*lrb](); // dummy for task synchronization
@@ -632,7 +990,7 @@ namespace strumpack {
 #pragma omp task default(shared) firstprivate(i,ii) depend(inout:B[ii])
 #endif
           {
-            B11.create_dense_tile(i, i, A11);
+            B11.compress_tile(i, i, A11, acc11[i+rb*i], false, opts);
             auto tpiv = B11.tile(i, i).LU();
             std::copy(tpiv.begin(), tpiv.end(), piv.begin()+B11.tileroff(i));
           }
@@ -643,8 +1001,8 @@ namespace strumpack {
   depend(in:B[ii]) depend(inout:B[ij]) priority(rb-j)
 #endif
             { // these blocks have received all updates, compress now
-              if (admissible(i, j)) B11.create_LR_tile(i, j, A11, opts);
-              else B11.create_dense_tile(i, j, A11);
+              B11.compress_tile
+                (i, j, A11, acc11[i+rb*j], admissible(i, j), opts);
               // permute and solve with L, blocks right from the diagonal block
               std::vector<int> tpiv
                 (piv.begin()+B11.tileroff(i), piv.begin()+B11.tileroff(i+1));
@@ -658,8 +1016,8 @@ namespace strumpack {
   depend(in:B[ii]) depend(inout:B[ji]) priority(rb-j)
 #endif
             {
-              if (admissible(j, i)) B11.create_LR_tile(j, i, A11, opts);
-              else B11.create_dense_tile(j, i, A11);
+              B11.compress_tile
+                (j, i, A11, acc11[j+rb*i], admissible(j, i), opts);
               // solve with U, the blocks under the diagonal block
               trsm(Side::R, UpLo::U, Trans::N, Diag::N,
                    scalar_t(1.), B11.tile(i, i), B11.tile(j, i));
@@ -672,7 +1030,7 @@ namespace strumpack {
   depend(in:B[ii]) depend(inout:B[ij2])
 #endif
             {
-              B12.create_LR_tile(i, j, A12, opts);
+              B12.compress_tile(i, j, A12, acc12[i+rb*j], true, opts);
               // permute and solve with L  blocks right from the diagonal block
               std::vector<int> tpiv
                 (piv.begin()+B11.tileroff(i), piv.begin()+B11.tileroff(i+1));
@@ -686,7 +1044,7 @@ namespace strumpack {
   depend(in:B[ii]) depend(inout:B[j2i])
 #endif
             {
-              B21.create_LR_tile(j, i, A21, opts);
+              B21.compress_tile(j, i, A21, acc21[j+rb2*i], true, opts);
               // solve with U, the blocks under the diagonal block
               trsm(Side::R, UpLo::U, Trans::N, Diag::N,
                    scalar_t(1.), B11.tile(i, i), B21.tile(j, i));
@@ -699,10 +1057,11 @@ namespace strumpack {
 #pragma omp task default(shared) firstprivate(i,j,k,ij,ki,kj)   \
   depend(in:B[ij],B[ki]) depend(inout:B[kj]) priority(rb-j)
 #endif
-              { // Schur complement updates, always into full rank
-                auto Akj = B11.tile(A11, k, j);
-                gemm(Trans::N, Trans::N, scalar_t(-1.),
-                     B11.tile(k, i), B11.tile(i, j), scalar_t(1.), Akj);
+              { // Schur complement updates, accumulated in low-rank
+                // for LUAR/CUFS, see BLR::Schur_update
+                B11.Schur_update_tile
+                  (k, j, A11, B11.tile(k, i), B11.tile(i, j),
+                   acc11[k+rb*j], opts);
               }
             }
           for (std::size_t k=i+1; k<rb; k++)
@@ -712,20 +1071,20 @@ namespace strumpack {
 #pragma omp task default(shared) firstprivate(i,k,j,ki,ij2,kj2) \
   depend(in:B[ki],B[ij2]) depend(inout:B[kj2])
 #endif
-              { // Schur complement updates, always into full rank
-                auto Akj = B12.tile(A12, k, j);
-                gemm(Trans::N, Trans::N, scalar_t(-1.),
-                     B11.tile(k, i), B12.tile(i, j), scalar_t(1.), Akj);
+              {
+                B12.Schur_update_tile
+                  (k, j, A12, B11.tile(k, i), B12.tile(i, j),
+                   acc12[k+rb*j], opts);
               }
 #if defined(STRUMPACK_USE_OPENMP_TASK_DEPEND)
               std::size_t ik = i+lrb*k, j2i = (j+rb)+lrb*i, j2k = (rb+j)+lrb*k;
 #pragma omp task default(shared) firstprivate(i,k,j,ik,j2i,j2k)      \
   depend(in:B[ik],B[j2i]) depend(inout:B[j2k])
 #endif
-              { // Schur complement updates, always into full rank
-                auto Ajk = B21.tile(A21, j, k);
-                gemm(Trans::N, Trans::N, scalar_t(-1.),
-                     B21.tile(j, i), B11.tile(i, k), scalar_t(1.), Ajk);
+              {
+                B21.Schur_update_tile
+                  (j, k, A21, B21.tile(j, i), B11.tile(i, k),
+                   acc21[j+rb2*k], opts);
               }
             }
 
@@ -736,15 +1095,31 @@ namespace strumpack {
 #pragma omp task default(shared) firstprivate(i,j,k,ij2,k2i,k2j2)       \
   depend(in:B[ij2],B[k2i]) depend(inout:B[k2j2])
 #endif
-              { // Schur complement updates, always into full rank
+              { // Schur complement updates, into full rank F22,
+                // possibly accumulated in low-rank first
                 DenseMatrixWrapper<scalar_t> Akj
                   (B21.tilerows(k), B12.tilecols(j), A22,
                    B21.tileroff(k), B12.tilecoff(j));
-                gemm(Trans::N, Trans::N, scalar_t(-1.),
-                     B21.tile(k, i), B12.tile(i, j), scalar_t(1.), Akj);
+                Schur_update
+                  (B21.tile(k, i), B12.tile(i, j), Akj, acc22[k+rb2*j], opts);
               }
             }
         }
+        if (opts.factor_algorithm() != FactorAlgorithm::RL)
+          for (std::size_t j=0; j<rb2; j++)
+            for (std::size_t k=0; k<rb2; k++) {
+#if defined(STRUMPACK_USE_OPENMP_TASK_DEPEND)
+              std::size_t k2j2 = (rb+k)+lrb*(rb+j);
+#pragma omp task default(shared) firstprivate(j,k,k2j2) \
+  depend(inout:B[k2j2])
+#endif
+              { // apply the accumulated updates to F22
+                DenseMatrixWrapper<scalar_t> Akj
+                  (B21.tilerows(k), B12.tilecols(j), A22,
+                   B21.tileroff(k), B12.tilecoff(j));
+                acc22[k+rb2*j].apply(Akj, opts);
+              }
+            }
       }
       for (std::size_t i=0; i<rb; i++)
         for (std::size_t l=B11.tileroff(i); l<B11.tileroff(i+1); l++)
@@ -902,6 +1277,16 @@ namespace strumpack {
                  scalar_t(1.), bj, task_depth);
           trsm(s, ul, ta, d, alpha, a.tile(j, j), bj, task_depth);
         }
+      } else if (s == Side::L && ul == UpLo::U) {
+        for (int j=int(a.colblocks())-1; j>=0; j--) {
+          DMW_t bj(a.tilecols(j), b.cols(), b, a.tilecoff(j), 0);
+          for (std::size_t k=j+1; k<a.colblocks(); k++)
+            gemm(ta, Trans::N, scalar_t(-1.),
+                 ta==Trans::N ? a.tile(j, k) : a.tile(k, j),
+                 DMW_t(a.tilecols(k), b.cols(), b, a.tilecoff(k), 0),
+                 scalar_t(1.), bj, task_depth);
+          trsm(s, ul, ta, d, alpha, a.tile(j, j), bj, task_depth);
+        }
       } else { assert(false); }
     }
 
@@ -994,10 +1379,29 @@ namespace strumpack {
     }
 
     template<typename scalar_t> void
-    gemm(Trans ta, Trans tb, scalar_t alpha, const BLRMatrix<scalar_t>& A,
-         const DenseMatrix<scalar_t>& B, scalar_t beta,
-         DenseMatrix<scalar_t>& C, int task_depth) {
-      std::cout << "TODO gemm BLR*Dense+Dense" << std::endl;
+    gemm(Trans ta, Trans tb, scalar_t alpha, const BLRMatrix<scalar_t>& a,
+         const DenseMatrix<scalar_t>& b, scalar_t beta,
+         DenseMatrix<scalar_t>& c, int task_depth) {
+      assert(tb == Trans::N);
+      using DMW_t = DenseMatrixWrapper<scalar_t>;
+      const auto imax = ta == Trans::N ? a.rowblocks() : a.colblocks();
+      const auto kmax = ta == Trans::N ? a.colblocks() : a.rowblocks();
+#if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
+#pragma omp taskloop default(shared)                            \
+  if(task_depth < params::task_recursion_cutoff_level)
+#endif
+      for (std::size_t i=0; i<imax; i++) {
+        DMW_t ci(ta==Trans::N ? a.tilerows(i) : a.tilecols(i), c.cols(), c,
+                 ta==Trans::N ? a.tileroff(i) : a.tilecoff(i), 0);
+        for (std::size_t k=0; k<kmax; k++) {
+          DMW_t bk(ta==Trans::N ? a.tilecols(k) : a.tilerows(k), b.cols(),
+                   const_cast<DenseMatrix<scalar_t>&>(b),
+                   ta==Trans::N ? a.tilecoff(k) : a.tileroff(k), 0);
+          gemm(ta, tb, alpha, ta==Trans::N ? a.tile(i, k) : a.tile(k, i),
+               bk, k==0 ? beta : scalar_t(1.), ci,
+               params::task_recursion_cutoff_level);
+        }
+      }
     }
 
   } // end namespace BLR
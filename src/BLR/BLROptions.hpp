@@ -70,6 +70,27 @@ namespace strumpack {
       }
     }
 
+    /**
+     * Variant of the BLR LU factorization. RL (right-looking) applies
+     * every Schur complement update immediately in full rank, and
+     * only compresses a tile once it has received all updates. LUAR
+     * (LU with accumulation and recompression) accumulates the
+     * low-rank products targeting a tile, recompresses the
+     * accumulated update and applies it just before the tile is
+     * needed. CUFS (compress, update, factor, solve) additionally
+     * compresses all off-diagonal tiles upfront, so the updates are
+     * merged into the low-rank tiles instead of into full rank.
+     */
+    enum class FactorAlgorithm { RL, LUAR, CUFS };
+    inline std::string get_name(FactorAlgorithm a) {
+      switch (a) {
+      case FactorAlgorithm::RL: return "RL"; break;
+      case FactorAlgorithm::LUAR: return "LUAR"; break;
+      case FactorAlgorithm::CUFS: return "CUFS"; break;
+      default: return "unknown";
+      }
+    }
+
     template<typename scalar_t> class BLROptions {
       using real_t = typename RealType<scalar_t>::value_type;
 
@@ -81,8 +102,25 @@ namespace strumpack {
       bool verbose_ = true;
       LowRankAlgorithm lr_algo_ = LowRankAlgorithm::RRQR;
       Admissibility adm_ = Admissibility::STRONG;
+      FactorAlgorithm factor_algo_ = FactorAlgorithm::RL;
+      bool compress_CB_ = false;
+
+      template<typename other_t> friend class BLROptions;
 
     public:
+      BLROptions() = default;
+
+      /**
+       * Copy the options from a BLROptions object with a different
+       * scalar type. The tolerances are converted to real_t.
+       */
+      template<typename other_t> explicit
+      BLROptions(const BLROptions<other_t>& o)
+        : rel_tol_(o.rel_tol_), abs_tol_(o.abs_tol_),
+          leaf_size_(o.leaf_size_), max_rank_(o.max_rank_),
+          verbose_(o.verbose_), lr_algo_(o.lr_algo_), adm_(o.adm_),
+          factor_algo_(o.factor_algo_), compress_CB_(o.compress_CB_) {}
+
       /*! \brief For Pieter to complete
        * \param rel_tol
        */
@@ -109,6 +147,15 @@ namespace strumpack {
         lr_algo_ = a;
       }
       void set_admissibility(Admissibility adm) { adm_ = adm; }
+      void set_factor_algorithm(FactorAlgorithm a) { factor_algo_ = a; }
+      /**
+       * Store the contribution block (F22) of a BLR front as a BLR
+       * matrix, with tiles aligned with the update tiles, instead of
+       * as a dense matrix. This reduces the memory of the
+       * contribution blocks waiting to be assembled in the parent,
+       * at the cost of an additional compression.
+       */
+      void set_CB_compression(bool b) { compress_CB_ = b; }
       void set_verbose(bool verbose) { verbose_ = verbose; }
 
       real_t rel_tol() const { return rel_tol_; }
@@ -117,6 +164,8 @@ namespace strumpack {
       int max_rank() const { return max_rank_; }
       LowRankAlgorithm low_rank_algorithm() const { return lr_algo_; }
       Admissibility admissibility() const { return adm_; }
+      FactorAlgorithm factor_algorithm() const { return factor_algo_; }
+      bool CB_compression() const { return compress_CB_; }
       bool verbose() const { return verbose_; }
 
       void set_from_command_line(int argc, const char* const* argv) {
@@ -132,6 +181,9 @@ namespace strumpack {
           {"blr_max_rank",              required_argument, 0, 4},
           {"blr_low_rank_algorithm",    required_argument, 0, 5},
           {"blr_admissibility",         required_argument, 0, 6},
+          {"blr_factor_algorithm",      required_argument, 0, 7},
+          {"blr_enable_CB_compression", no_argument, 0, 8},
+          {"blr_disable_CB_compression", no_argument, 0, 9},
           {"blr_verbose",               no_argument, 0, 'v'},
           {"blr_quiet",                 no_argument, 0, 'q'},
           {"help",                      no_argument, 0, 'h'},
@@ -185,6 +237,22 @@ namespace strumpack {
                         << ", use 'weak' or 'strong'."
                         << std::endl;
           } break;
+          case 7: {
+            std::istringstream iss(optarg);
+            std::string s; iss >> s;
+            if (s.compare("RL") == 0)
+              set_factor_algorithm(FactorAlgorithm::RL);
+            else if (s.compare("LUAR") == 0)
+              set_factor_algorithm(FactorAlgorithm::LUAR);
+            else if (s.compare("CUFS") == 0)
+              set_factor_algorithm(FactorAlgorithm::CUFS);
+            else
+              std::cerr << "# WARNING: BLR factorization algorithm not"
+                        << " recognized, use 'RL', 'LUAR' or 'CUFS'."
+                        << std::endl;
+          } break;
+          case 8: set_CB_compression(true); break;
+          case 9: set_CB_compression(false); break;
 
           case 'v': set_verbose(true); break;
           case 'q': set_verbose(false); break;
@@ -210,6 +278,13 @@ namespace strumpack {
                   << "#   --blr_admissibility (default "
                   << get_name(adm_) << ")" << std::endl
                   << "       should be one of [weak|strong]" << std::endl
+                  << "#   --blr_factor_algorithm (default "
+                  << get_name(factor_algo_) << ")" << std::endl
+                  << "       should be one of [RL|LUAR|CUFS]" << std::endl
+                  << "#   --blr_enable_CB_compression (default "
+                  << CB_compression() << ")" << std::endl
+                  << "#   --blr_disable_CB_compression (default "
+                  << !CB_compression() << ")" << std::endl
                   << "#   --blr_verbose or -v (default "
                   << verbose() << ")" << std::endl
                   << "#   --blr_quiet or -q (default "
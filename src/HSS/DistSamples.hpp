@@ -61,7 +61,9 @@ namespace strumpack {
           _hard_restart(hard_restart),
           R(g, _hss.cols(), d), Sr(g, _hss.cols(), d),
           Sc(g, _hss.cols(), d) {
-        _rgen->seed(R.prow(), R.pcol());
+        // a counter-based generator gives the same R on any grid
+        if (!_rgen->counter_based())
+          _rgen->seed(R.prow(), R.pcol());
         R.random(*_rgen);
         STRUMPACK_RANDOM_FLOPS
           (_rgen->flops_per_prng() * R.lrows() * R.lcols());
@@ -41,6 +41,47 @@ namespace strumpack {
 
     template<typename scalar_t> void HSSMatrix<scalar_t>::compress_original
     (const mult_t& Amult, const elem_t& Aelem, const opts_t& opts) {
+      compress_original_sampling
+        (Amult, opts, "original",
+         [&](DenseM_t& Rr, DenseM_t& Rc, DenseM_t& Sr, DenseM_t& Sc,
+             WorkCompress<scalar_t>& w, int dd) {
+#pragma omp parallel if(!omp_in_parallel())
+#pragma omp single nowait
+          compress_recursive_original
+            (Rr, Rc, Sr, Sc, Aelem, opts, w, dd,
+             this->_openmp_task_depth);
+        });
+    }
+
+    template<typename scalar_t> void HSSMatrix<scalar_t>::compress_original
+    (const mult_t& Amult, const elem_blocks_t& Aelem, const opts_t& opts) {
+      const int nr_lvls = this->levels();
+      compress_original_sampling
+        (Amult, opts, "original, by level",
+         [&](DenseM_t& Rr, DenseM_t& Rc, DenseM_t& Sr, DenseM_t& Sc,
+             WorkCompress<scalar_t>& w, int dd) {
+          for (int lvl=nr_lvls-1; lvl>=0; lvl--) {
+            extract_level(Aelem, opts, w, lvl);
+#pragma omp parallel if(!omp_in_parallel())
+#pragma omp single nowait
+            compress_level_original
+              (Rr, Rc, Sr, Sc, opts, w, dd, lvl,
+               this->_openmp_task_depth);
+          }
+        });
+    }
+
+    /**
+     * Adaptive random sampling loop of the original compression
+     * algorithm. The number of samples is doubled until the matrix is
+     * compressed, after each round of sampling compress is called
+     * with the samples and the number dd of new columns.
+     */
+    template<typename scalar_t> void
+    HSSMatrix<scalar_t>::compress_original_sampling
+    (const mult_t& Amult, const opts_t& opts, const std::string& label,
+     const std::function<void(DenseM_t&, DenseM_t&, DenseM_t&, DenseM_t&,
+                              WorkCompress<scalar_t>&, int)>& compress) {
       int d_old = 0, d = opts.d0() + opts.p();
       auto n = this->cols();
       DenseM_t Rr, Rc, Sr, Sc;
@@ -67,12 +108,9 @@ namespace strumpack {
         Amult(Rr_new, Rc_new, Sr_new, Sc_new);
         if (opts.verbose())
           std::cout << "# compressing with d = " << d-opts.p()
-                    << " + " << opts.p() << " (original)" << std::endl;
-#pragma omp parallel if(!omp_in_parallel())
-#pragma omp single nowait
-        compress_recursive_original
-          (Rr, Rc, Sr, Sc, Aelem, opts, w, d-d_old,
-           this->_openmp_task_depth);
+                    << " + " << opts.p() << " (" << label << ")"
+                    << std::endl;
+        compress(Rr, Rc, Sr, Sc, w, d-d_old);
         if (!this->is_compressed()) {
           d_old = d;
           d = 2 * (d_old - opts.p()) + opts.p();
@@ -313,7 +351,8 @@ namespace strumpack {
           this->_ch[1]->get_extraction_indices(I, J, B, off, w.c[1], self, lvl);
           return;
         }
-        if (this->is_untouched()) {
+        if (this->is_untouched() && this->_ch[0]->is_compressed() &&
+            this->_ch[1]->is_compressed()) {
           self += 2;
           I.push_back(w.c[0].Ir);  J.push_back(w.c[1].Ic);
           for (auto& i : I.back()) i += off.first;
@@ -360,6 +399,26 @@ namespace strumpack {
       }
     }
 
+    /**
+     * Collect the D blocks of the leafs and the B01/B10 blocks of the
+     * internal nodes at level lvl which can be extracted, and get them
+     * all with a single call to Aelem.
+     */
+    template<typename scalar_t> void HSSMatrix<scalar_t>::extract_level
+    (const elem_blocks_t& Aelem, const opts_t& /*opts*/,
+     WorkCompress<scalar_t>& w, int lvl) {
+      std::vector<std::vector<std::size_t>> I, J;
+      std::vector<DenseM_t*> B;
+      int self = 0;
+      get_extraction_indices(I, J, B, {0, 0}, w, self, lvl);
+      if (B.empty()) return;
+      std::vector<DenseMW_t> Bw;
+      Bw.reserve(B.size());
+      for (auto Bk : B)
+        Bw.emplace_back(Bk->rows(), Bk->cols(), *Bk, 0, 0);
+      Aelem(I, J, Bw);
+    }
+
     template<typename scalar_t> void
     HSSMatrix<scalar_t>::compute_local_samples
     (DenseM_t& Rr, DenseM_t& Rc, DenseM_t& Sr, DenseM_t& Sc,
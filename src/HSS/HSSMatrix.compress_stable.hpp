@@ -41,6 +41,47 @@ namespace strumpack {
 
     template<typename scalar_t> void HSSMatrix<scalar_t>::compress_stable
     (const mult_t& Amult, const elem_t& Aelem, const opts_t& opts) {
+      compress_stable_sampling
+        (Amult, opts, "stable",
+         [&](DenseM_t& Rr, DenseM_t& Rc, DenseM_t& Sr, DenseM_t& Sc,
+             WorkCompress<scalar_t>& w, int d, int dd) {
+#pragma omp parallel if(!omp_in_parallel())
+#pragma omp single nowait
+          compress_recursive_stable
+            (Rr, Rc, Sr, Sc, Aelem, opts, w,
+             d, dd, this->_openmp_task_depth);
+        });
+    }
+
+    template<typename scalar_t> void HSSMatrix<scalar_t>::compress_stable
+    (const mult_t& Amult, const elem_blocks_t& Aelem, const opts_t& opts) {
+      const int nr_lvls = this->levels();
+      compress_stable_sampling
+        (Amult, opts, "stable, by level",
+         [&](DenseM_t& Rr, DenseM_t& Rc, DenseM_t& Sr, DenseM_t& Sc,
+             WorkCompress<scalar_t>& w, int d, int dd) {
+          for (int lvl=nr_lvls-1; lvl>=0; lvl--) {
+            extract_level(Aelem, opts, w, lvl);
+#pragma omp parallel if(!omp_in_parallel())
+#pragma omp single nowait
+            compress_level_stable
+              (Rr, Rc, Sr, Sc, opts, w, d, dd, lvl,
+               this->_openmp_task_depth);
+          }
+        });
+    }
+
+    /**
+     * Adaptive random sampling loop of the stable compression
+     * algorithm. Samples are added dd at a time until the matrix is
+     * compressed, after each round of sampling compress is called
+     * with the samples, the number d of old and dd of new columns.
+     */
+    template<typename scalar_t> void
+    HSSMatrix<scalar_t>::compress_stable_sampling
+    (const mult_t& Amult, const opts_t& opts, const std::string& label,
+     const std::function<void(DenseM_t&, DenseM_t&, DenseM_t&, DenseM_t&,
+                              WorkCompress<scalar_t>&, int, int)>& compress) {
       auto d = opts.d0();
       auto dd = opts.dd();
       // assert(dd <= d);
@@ -72,12 +113,8 @@ namespace strumpack {
         Amult(Rr_new, Rc_new, Sr_new, Sc_new);
         if (opts.verbose())
           std::cout << "# compressing with d+dd = " << d << "+" << dd
-                    << " (stable)" << std::endl;
-#pragma omp parallel if(!omp_in_parallel())
-#pragma omp single nowait
-        compress_recursive_stable
-          (Rr, Rc, Sr, Sc, Aelem, opts, w,
-           d, dd, this->_openmp_task_depth);
+                    << " (" << label << ")" << std::endl;
+        compress(Rr, Rc, Sr, Sc, w, d, dd);
         if (!this->is_compressed()) {
           d += dd;
           dd = std::min(dd, opts.max_rank()-d);
@@ -43,6 +43,42 @@ namespace strumpack {
       extract_bwd(B, w, this->_openmp_task_depth);
     }
 
+    template<typename scalar_t> std::vector<DenseMatrix<scalar_t>>
+    HSSMatrix<scalar_t>::extract
+    (const std::vector<std::vector<std::size_t>>& I,
+     const std::vector<std::vector<std::size_t>>& J) const {
+      std::vector<DenseM_t> B;
+      std::vector<DenseMW_t> Bw;
+      B.reserve(I.size());
+      Bw.reserve(I.size());
+      for (std::size_t k=0; k<I.size(); k++) {
+        B.emplace_back(I[k].size(), J[k].size());
+        B[k].zero();
+        Bw.emplace_back(B[k].rows(), B[k].cols(), B[k], 0, 0);
+      }
+      extract_add(I, J, Bw);
+      return B;
+    }
+
+    template<typename scalar_t> void HSSMatrix<scalar_t>::extract_add
+    (const std::vector<std::vector<std::size_t>>& I,
+     const std::vector<std::vector<std::size_t>>& J,
+     std::vector<DenseMW_t>& B) const {
+      assert(I.size() == J.size() && I.size() == B.size());
+      const auto depth = this->_openmp_task_depth;
+#pragma omp parallel if(!omp_in_parallel())
+#pragma omp single nowait
+      {
+        for (std::size_t k=0; k<I.size(); k++) {
+          if (I[k].empty() || J[k].empty()) continue;
+#pragma omp task default(shared) firstprivate(k)                        \
+  if(depth < params::task_recursion_cutoff_level)
+          extract_add(I[k], J[k], B[k]);
+        }
+#pragma omp taskwait
+      }
+    }
+
     template<typename scalar_t> void HSSMatrix<scalar_t>::extract_fwd
     (WorkExtract<scalar_t>& w, bool odiag, int depth) const {
       if (w.J.empty()) return;
@@ -76,6 +76,10 @@ namespace strumpack {
       using elem_t = typename std::function
         <void(const std::vector<std::size_t>& I,
               const std::vector<std::size_t>& J, DenseM_t& B)>;
+      using elem_blocks_t = typename std::function
+        <void(const std::vector<std::vector<std::size_t>>& I,
+              const std::vector<std::vector<std::size_t>>& J,
+              std::vector<DenseMW_t>& B)>;
       using mult_t = typename std::function
         <void(DenseM_t& Rr, DenseM_t& Rc, DenseM_t& Sr, DenseM_t& Sc)>;
       using opts_t = HSSOptions<scalar_t>;
@@ -223,6 +227,23 @@ namespace strumpack {
       void compress
       (const mult_t& Amult, const elem_t& Aelem, const opts_t& opts);
 
+      /**
+       * Same as compress(mult_t, elem_t, opts_t), but the compression
+       * proceeds level by level, and all the submatrices (the D and
+       * B01/B10 blocks) required at one level of the HSS tree are
+       * requested with a single call to Aelem, so that the element
+       * extraction routine can work on all of them together.
+       *
+       * \param Amult random sampling routine
+       * \param Aelem batched element extraction routine, should fill
+       * B[k] with A(I[k],J[k]), for all blocks k
+       * \param opts compression options. The HARD_RESTART algorithm
+       * has no level by level variant, it calls compress_hard_restart
+       * and extracts the blocks one at a time through Aelem.
+       */
+      void compress
+      (const mult_t& Amult, const elem_blocks_t& Aelem, const opts_t& opts);
+
       /**
        * Reset the matrix to an empty, 0 x 0 matrix, freeing up all
        * it's memory.
@@ -310,6 +331,20 @@ namespace strumpack {
       void extract_add
       (const std::vector<std::size_t>& I, const std::vector<std::size_t>& J,
        DenseM_t& B) const;
+      /**
+       * Extract multiple submatrices, B[k] = H(I[k],J[k]), at once.
+       * The blocks are extracted concurrently.
+       */
+      std::vector<DenseM_t> extract
+      (const std::vector<std::vector<std::size_t>>& I,
+       const std::vector<std::vector<std::size_t>>& J) const;
+      /**
+       * Add multiple submatrices, B[k] += H(I[k],J[k]).
+       */
+      void extract_add
+      (const std::vector<std::vector<std::size_t>>& I,
+       const std::vector<std::vector<std::size_t>>& J,
+       std::vector<DenseMW_t>& B) const;
 
       /**
        * Compute a Schur complement update... TODO
@@ -365,6 +400,18 @@ namespace strumpack {
       void compress_stable(const DenseM_t& A, const opts_t& opts);
       void compress_stable
       (const mult_t& Amult, const elem_t& Aelem, const opts_t& opts);
+      void compress_original
+      (const mult_t& Amult, const elem_blocks_t& Aelem, const opts_t& opts);
+      void compress_stable
+      (const mult_t& Amult, const elem_blocks_t& Aelem, const opts_t& opts);
+      void compress_original_sampling
+      (const mult_t& Amult, const opts_t& opts, const std::string& label,
+       const std::function<void(DenseM_t&, DenseM_t&, DenseM_t&, DenseM_t&,
+                                WorkCompress<scalar_t>&, int)>& compress);
+      void compress_stable_sampling
+      (const mult_t& Amult, const opts_t& opts, const std::string& label,
+       const std::function<void(DenseM_t&, DenseM_t&, DenseM_t&, DenseM_t&,
+                                WorkCompress<scalar_t>&, int, int)>& compress);
       void compress_hard_restart(const DenseM_t& A, const opts_t& opts);
       void compress_hard_restart
       (const mult_t& Amult, const elem_t& Aelem, const opts_t& opts);
@@ -420,6 +467,9 @@ namespace strumpack {
       void extract_D_B
       (const elem_t& Aelem, const opts_t& opts,
        WorkCompress<scalar_t>& w, int lvl);
+      void extract_level
+      (const elem_blocks_t& Aelem, const opts_t& opts,
+       WorkCompress<scalar_t>& w, int lvl);
 
       void factor_recursive
       (HSSFactors<scalar_t>& ULV, WorkFactor<scalar_t>& w,
@@ -587,6 +637,31 @@ namespace strumpack {
       };
     }
 
+    template<typename scalar_t> void HSSMatrix<scalar_t>::compress
+    (const mult_t& Amult, const elem_blocks_t& Aelem, const opts_t& opts) {
+      TIMER_TIME(TaskType::HSS_COMPRESS, 0, t_compress);
+      switch (opts.compression_algorithm()) {
+      case CompressionAlgorithm::ORIGINAL:
+        compress_original(Amult, Aelem, opts); break;
+      case CompressionAlgorithm::STABLE:
+        compress_stable(Amult, Aelem, opts); break;
+      case CompressionAlgorithm::HARD_RESTART: {
+        // hard restart has no level-by-level variant, extract the
+        // blocks one at a time
+        elem_t Aelem1 =
+          [&Aelem](const std::vector<std::size_t>& I,
+                   const std::vector<std::size_t>& J, DenseM_t& B) {
+            std::vector<DenseMW_t> Bw;
+            Bw.emplace_back(B.rows(), B.cols(), B, 0, 0);
+            Aelem({I}, {J}, Bw);
+          };
+        compress_hard_restart(Amult, Aelem1, opts);
+      } break;
+      default:
+        std::cout << "Compression algorithm not recognized!" << std::endl;
+      };
+    }
+
     template<typename scalar_t> void HSSMatrix<scalar_t>::reset() {
       _U.clear();
       _V.clear();
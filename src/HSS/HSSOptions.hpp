@@ -129,6 +129,22 @@ namespace strumpack {
        */
       using real_t = typename RealType<scalar_t>::value_type;
 
+      HSSOptions() = default;
+
+      /**
+       * Copy the options from an HSSOptions object with a different
+       * scalar type. The tolerances are converted to real_t.
+       */
+      template<typename other_t> explicit
+      HSSOptions(const HSSOptions<other_t>& o)
+        : _rel_tol(o._rel_tol), _abs_tol(o._abs_tol),
+          _leaf_size(o._leaf_size), _d0(o._d0), _dd(o._dd), _p(o._p),
+          _max_rank(o._max_rank), _random_engine(o._random_engine),
+          _random_distribution(o._random_distribution),
+          _user_defined_random(o._user_defined_random),
+          _log_ranks(o._log_ranks), _compress_algo(o._compress_algo),
+          _sync(o._sync), _verbose(o._verbose) {}
+
       /**
        * Set the relative tolerance to be used for HSS
        * compression. Tuning this parameter is very important for
@@ -194,7 +210,11 @@ namespace strumpack {
       }
 
       /**
-       * Set the random engine, used in randomized compression.
+       * Set the random engine, used in randomized compression. The
+       * default is the counter-based RandomEngine::PHILOX, for which
+       * the random matrices do not depend on the number of threads or
+       * processes. Use RandomEngine::LINEAR to get the random numbers
+       * of previous versions.
        * \see RandomEngine, RandomDistribution, set_random_distribution()
        */
       void set_random_engine(random::RandomEngine random_engine) {
@@ -400,9 +420,12 @@ namespace strumpack {
               set_random_engine(random::RandomEngine::LINEAR);
             else if (s.compare("mersenne") == 0)
               set_random_engine(random::RandomEngine::MERSENNE);
+            else if (s.compare("philox") == 0)
+              set_random_engine(random::RandomEngine::PHILOX);
             else
               std::cerr << "# WARNING: random number engine not recognized,"
-                        << " use 'linear' or 'mersenne'." << std::endl;
+                        << " use 'linear', 'mersenne' or 'philox'."
+                        << std::endl;
           } break;
           case 10: {
             std::istringstream iss(optarg);
@@ -445,7 +468,7 @@ namespace strumpack {
                   << max_rank() << ")" << std::endl
                   << "#   --hss_random_distribution normal|uniform (default "
                   << get_name(random_distribution()) << ")" << std::endl
-                  << "#   --hss_random_engine linear|mersenne (default "
+                  << "#   --hss_random_engine linear|mersenne|philox (default "
                   << get_name(random_engine()) << ")" << std::endl
                   << "#   --hss_compression_algorithm original|stable|hard_restart (default "
                   << get_name(compression_algorithm())<< ")" << std::endl
@@ -473,7 +496,7 @@ namespace strumpack {
       int _p = 10;
       int _max_rank = 5000;
       random::RandomEngine _random_engine =
-        random::RandomEngine::LINEAR;
+        random::RandomEngine::PHILOX;
       random::RandomDistribution _random_distribution =
         random::RandomDistribution::NORMAL;
       bool _user_defined_random = false;
@@ -481,6 +504,8 @@ namespace strumpack {
       CompressionAlgorithm _compress_algo = CompressionAlgorithm::STABLE;
       bool _sync = false;
       bool _verbose = true;
+
+      template<typename other_t> friend class HSSOptions;
     };
 
   } // end namespace HSS
@@ -49,9 +49,10 @@ namespace strumpack {
         int pid = n-1;
         de_serialize_rec(buf.data(), buf.data()+n, buf.data()+2*n, pid);
       }
-      HSSPartitionTree(const HSSPartitionTree& h)
-        : size(h.size), c(h.c) {
-      }
+      HSSPartitionTree(const HSSPartitionTree& h) = default;
+      HSSPartitionTree(HSSPartitionTree&& h) = default;
+      HSSPartitionTree& operator=(const HSSPartitionTree& h) = default;
+      HSSPartitionTree& operator=(HSSPartitionTree&& h) = default;
       void refine(int leaf_size) {
         assert(c.empty());
         if (size > 2*leaf_size) {
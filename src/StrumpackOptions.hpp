@@ -33,6 +33,7 @@
 #define SPOPTIONS_HPP
 
 #include <cstring>
+#include <algorithm>
 
 // this is needed for RealType, put that somewhere else?
 #include "dense/BLASLAPACKWrapper.hpp"
@@ -279,6 +280,45 @@ namespace strumpack {
       _blr_opts.set_verbose(false);
     }
 
+    /**
+     * Copy all options from an SPOptions object with a different
+     * scalar type. This is used for the mixed precision
+     * factorization, which factors in single precision. The
+     * tolerances are converted to real_t. A new option should be
+     * added here, and to test/test_options_seq.cpp, which checks
+     * that every option survives the conversion.
+     *
+     * \param o options object to copy
+     * \see enable_mixed_precision()
+     */
+    template<typename other_t> explicit SPOptions(const SPOptions<other_t>& o)
+      : _verbose(o._verbose), _maxit(o._maxit), _rel_tol(o._rel_tol),
+        _abs_tol(o._abs_tol), _Krylov_solver(o._Krylov_solver),
+        _gmres_restart(o._gmres_restart),
+        _Gram_Schmidt_type(o._Gram_Schmidt_type),
+        _solve_batch_size(o._solve_batch_size),
+        _reordering_method(o._reordering_method), _nd_param(o._nd_param),
+        _nx(o._nx), _ny(o._ny), _nz(o._nz), _components(o._components),
+        _separator_width(o._separator_width),
+        _use_METIS_NodeNDP(o._use_METIS_NodeNDP),
+        _use_MUMPS_SYMQAMD(o._use_MUMPS_SYMQAMD),
+        _use_agg_amalg(o._use_agg_amalg), _matching_job(o._matching_job),
+        _log_assembly_tree(o._log_assembly_tree), _comp(o._comp),
+        _hss_min_front_size(o._hss_min_front_size),
+        _hss_min_sep_size(o._hss_min_sep_size),
+        _sep_order_level(o._sep_order_level),
+        _indirect_sampling(o._indirect_sampling),
+        _HSS_rank_estimate(o._HSS_rank_estimate),
+        _HSS_regenerate_random(o._HSS_regenerate_random),
+        _replace_tiny_pivots(o._replace_tiny_pivots),
+        _use_DAG_scheduler(o._use_DAG_scheduler),
+        _mixed_precision(o._mixed_precision),
+        _lookahead_LU(o._lookahead_LU), _trace_file(o._trace_file),
+        _hss_opts(o._hss_opts), _blr_opts(o._blr_opts),
+        _blr_min_front_size(o._blr_min_front_size),
+        _blr_min_sep_size(o._blr_min_sep_size),
+        _argc(o._argc), _argv(o._argv) {}
+
     /**
      * Set verbose to true/false, ie, allow the sparse solver to print
      * out progress information, statistics on time, flops, memory
@@ -339,6 +379,16 @@ namespace strumpack {
      */
     void set_GramSchmidt_type(GramSchmidtType t) { _Gram_Schmidt_type = t; }
 
+    /**
+     * Set the number of right-hand sides that are collected by
+     * StrumpackSparseSolver::submit_solve before they are solved
+     * together as a single multiple right-hand side solve.
+     *
+     * \param b batch size, values smaller than 1 are replaced by 1
+     * \see StrumpackSparseSolver::submit_solve
+     */
+    void set_solve_batch_size(int b) { _solve_batch_size = std::max(1, b); }
+
     /**
      * Set the sparse fill-reducing reordering. This can greatly
      * affect the memory usage and factorization time. However, note
@@ -675,6 +725,50 @@ namespace strumpack {
     void disable_indirect_sampling() { _indirect_sampling = false; }
 #endif // DOXYGEN_SHOULD_SKIP_THIS
 
+    /**
+     * Choose the initial number of random samples (d0) for every HSS
+     * front separately, from the HSS ranks of its children, instead
+     * of using the same HSS_options().d0() for all fronts. The rank
+     * of a front is typically close to the ranks of its children, so
+     * this avoids oversampling fronts with small rank, and restarting
+     * the adaptive sampling many times for fronts with a larger
+     * rank. Fronts without HSS children use HSS_options().d0().
+     * This is disabled by default, since the estimate replaces any
+     * d0 set by the user (for instance with --hss_d0) for the fronts
+     * with HSS children.
+     *
+     * \see disable_HSS_rank_estimate()
+     */
+    void enable_HSS_rank_estimate() { _HSS_rank_estimate = true; }
+
+    /**
+     * Use HSS_options().d0() as the initial number of random samples
+     * for all HSS fronts.
+     *
+     * \see enable_HSS_rank_estimate()
+     */
+    void disable_HSS_rank_estimate() { _HSS_rank_estimate = false; }
+
+    /**
+     * With indirect sampling, do not keep the random vectors used to
+     * compress an HSS front until the parent front is compressed,
+     * but regenerate them from their seeds (the global row index and
+     * the sample index) when they are needed. This lowers the memory
+     * kept between the compression of a front and of its parent, at
+     * the cost of generating the random numbers twice.
+     *
+     * \see disable_HSS_regenerate_random()
+     */
+    void enable_HSS_regenerate_random() { _HSS_regenerate_random = true; }
+
+    /**
+     * Store the random vectors used to compress an HSS front until
+     * the parent front is compressed (default).
+     *
+     * \see enable_HSS_regenerate_random()
+     */
+    void disable_HSS_regenerate_random() { _HSS_regenerate_random = false; }
+
     /**
      * Enable replacing of small pivot values with a larger
      * value. This can prevent to numerical factorization to fail
@@ -701,6 +795,92 @@ namespace strumpack {
      */
     void disable_replace_tiny_pivots() { _replace_tiny_pivots = false; }
 
+    /**
+     * Schedule the numerical factorization of the elimination tree
+     * as a task dependency graph: a front becomes ready as soon as
+     * both its children are done, instead of recursively forking
+     * and joining. Small subtrees, determined from their estimated
+     * work and the number of threads, are still factored
+     * sequentially. This only affects the shared memory part of the
+     * tree. This is the default, the task recursion cutoff level then
+     * no longer limits the parallelism over the elimination tree in
+     * the factorization. It is still used for the tasks within the
+     * fronts, in the symbolic phase and the solve, for the
+     * distributed memory fronts, and when the DAG scheduler is
+     * disabled.
+     *
+     * \see disable_DAG_scheduler()
+     */
+    void enable_DAG_scheduler() { _use_DAG_scheduler = true; }
+
+    /**
+     * Use recursive fork/join tasking, controlled by the task
+     * recursion cutoff level, for the numerical factorization.
+     *
+     * \see enable_DAG_scheduler()
+     */
+    void disable_DAG_scheduler() { _use_DAG_scheduler = false; }
+
+    /**
+     * Compute the multifrontal factorization (dense, HSS and BLR
+     * fronts) in single precision, while the sparse matrix, the
+     * residuals and the outer iterative solver (iterative refinement
+     * or GMRES/BiCGStab) stay in the precision of scalar_t. This
+     * halves the memory for the factors. This has no effect when
+     * scalar_t is already single precision, and is currently only
+     * supported in the shared memory StrumpackSparseSolver. Only
+     * use this with KrylovSolver::DIRECT if single precision is
+     * accurate enough.
+     *
+     * \see disable_mixed_precision()
+     */
+    void enable_mixed_precision() { _mixed_precision = true; }
+
+    /**
+     * Factor in the same precision as scalar_t.
+     *
+     * \see enable_mixed_precision()
+     */
+    void disable_mixed_precision() { _mixed_precision = false; }
+
+    /**
+     * For the distributed memory dense fronts, replace the
+     * ScaLAPACK partial factorization by a tiled, right-looking LU
+     * with tournament pivoting and a lookahead of one panel. Each
+     * panel is factored with a single reduction of pivot candidates
+     * over the process column that owns it, instead of a reduction
+     * per column, and the processes owning the next panel factor it
+     * before finishing the trailing update of the current one.
+     *
+     * \see disable_lookahead_LU()
+     */
+    void enable_lookahead_LU() { _lookahead_LU = true; }
+
+    /**
+     * Use ScaLAPACK to factor the distributed memory dense fronts
+     * (default).
+     *
+     * \see enable_lookahead_LU()
+     */
+    void disable_lookahead_LU() { _lookahead_LU = false; }
+
+    /**
+     * Record a trace of the reordering, factorization and solve,
+     * including a span for every frontal matrix (with its
+     * separator, elimination tree level, size, flops and bytes),
+     * and write it to the given file in the Chrome trace (JSON)
+     * format. This does not require STRUMPACK to be built with
+     * STRUMPACK_TASK_TIMERS. The trace is (re)written at the end of
+     * every factor and solve call. Open the file with
+     * chrome://tracing or https://ui.perfetto.dev. For the
+     * distributed memory solvers, all ranks write to the same file,
+     * using pid for the MPI rank. An empty name disables tracing.
+     *
+     * \param fname name of the trace file
+     * \see trace_file()
+     */
+    void set_trace_file(const std::string& fname) { _trace_file = fname; }
+
 
     /**
      * Check if verbose output is enabled.
@@ -744,6 +924,13 @@ namespace strumpack {
      */
     GramSchmidtType GramSchmidt_type() const { return _Gram_Schmidt_type; }
 
+    /**
+     * Get the number of right-hand sides solved together by
+     * StrumpackSparseSolver::submit_solve.
+     * \see set_solve_batch_size()
+     */
+    int solve_batch_size() const { return _solve_batch_size; }
+
     /**
      * Get the currently set fill reducing reordering method.
      * \see set_reordering_method()
@@ -880,11 +1067,49 @@ namespace strumpack {
      */
     bool indirect_sampling() const { return _indirect_sampling; }
 
+    /**
+     * Is the per front estimate of the initial number of HSS random
+     * samples enabled?
+     * \see enable_HSS_rank_estimate()
+     */
+    bool HSS_rank_estimate() const { return _HSS_rank_estimate; }
+
+    /**
+     * Are the HSS random vectors regenerated instead of stored?
+     * \see enable_HSS_regenerate_random()
+     */
+    bool HSS_regenerate_random() const { return _HSS_regenerate_random; }
+
     /**
      * Check whether replacement of tiny pivots is enabled.
      */
     bool replace_tiny_pivots() const { return _replace_tiny_pivots; }
 
+    /**
+     * Check whether the factorization uses the DAG scheduler.
+     * \see enable_DAG_scheduler()
+     */
+    bool use_DAG_scheduler() const { return _use_DAG_scheduler; }
+
+    /**
+     * Check whether the factorization is done in single precision.
+     * \see enable_mixed_precision()
+     */
+    bool mixed_precision() const { return _mixed_precision; }
+
+    /**
+     * Are distributed dense fronts factored with tournament pivoting
+     * and lookahead?
+     * \see enable_lookahead_LU()
+     */
+    bool lookahead_LU() const { return _lookahead_LU; }
+
+    /**
+     * Get the name of the trace file, empty if tracing is disabled.
+     * \see set_trace_file()
+     */
+    const std::string& trace_file() const { return _trace_file; }
+
     /**
      * Get a (const) reference to an object holding various options
      * pertaining to the HSS code, and data structures.
@@ -971,6 +1196,18 @@ namespace strumpack {
         {"sp_nz",                        required_argument, 0, 35},
         {"sp_components",                required_argument, 0, 36},
         {"sp_separator_width",           required_argument, 0, 37},
+        {"sp_solve_batch_size",          required_argument, 0, 38},
+        {"sp_enable_DAG_scheduler",      no_argument, 0, 39},
+        {"sp_disable_DAG_scheduler",     no_argument, 0, 40},
+        {"sp_enable_mixed_precision",    no_argument, 0, 41},
+        {"sp_disable_mixed_precision",   no_argument, 0, 42},
+        {"sp_trace_file",                required_argument, 0, 43},
+        {"sp_enable_HSS_rank_estimate",  no_argument, 0, 44},
+        {"sp_disable_HSS_rank_estimate", no_argument, 0, 45},
+        {"sp_enable_HSS_regenerate_random",  no_argument, 0, 46},
+        {"sp_disable_HSS_regenerate_random", no_argument, 0, 47},
+        {"sp_enable_lookahead_LU",       no_argument, 0, 48},
+        {"sp_disable_lookahead_LU",      no_argument, 0, 49},
         {"sp_verbose",                   no_argument, 0, 'v'},
         {"sp_quiet",                     no_argument, 0, 'q'},
         {"help",                         no_argument, 0, 'h'},
@@ -1132,6 +1369,26 @@ namespace strumpack {
           iss >> _separator_width;
           set_separator_width(_separator_width);
         } break;
+        case 38: {
+          std::istringstream iss(optarg);
+          iss >> _solve_batch_size;
+          set_solve_batch_size(_solve_batch_size);
+        } break;
+        case 39: { enable_DAG_scheduler(); } break;
+        case 40: { disable_DAG_scheduler(); } break;
+        case 41: { enable_mixed_precision(); } break;
+        case 42: { disable_mixed_precision(); } break;
+        case 43: {
+          std::istringstream iss(optarg);
+          iss >> _trace_file;
+          set_trace_file(_trace_file);
+        } break;
+        case 44: { enable_HSS_rank_estimate(); } break;
+        case 45: { disable_HSS_rank_estimate(); } break;
+        case 46: { enable_HSS_regenerate_random(); } break;
+        case 47: { disable_HSS_regenerate_random(); } break;
+        case 48: { enable_lookahead_LU(); } break;
+        case 49: { disable_lookahead_LU(); } break;
         case 'h': { describe_options(); } break;
         case 'v': set_verbose(true); break;
         case 'q': set_verbose(false); break;
@@ -1174,6 +1431,10 @@ namespace strumpack {
       std::cout << "#   --sp_GramSchmidt_type [modified|classical]"
                 << std::endl;
       std::cout << "#          Gram-Schmidt type for GMRES" << std::endl;
+      std::cout << "#   --sp_solve_batch_size int (default "
+                << solve_batch_size() << ")" << std::endl;
+      std::cout << "#          number of right-hand sides solved together"
+                << " with submit_solve" << std::endl;
       std::cout << "#   --sp_reordering_method natural|metis|scotch|parmetis|"
                 << "ptscotch|rcm|geometric" << std::endl;
       std::cout << "#          Code for nested dissection." << std::endl;
@@ -1245,8 +1506,34 @@ namespace strumpack {
                 << separator_ordering_level() << ")" << std::endl;
       std::cout << "#   --sp_enable_indirect_sampling" << std::endl;
       std::cout << "#   --sp_disable_indirect_sampling" << std::endl;
+      std::cout << "#   --sp_enable_HSS_rank_estimate (default "
+                << HSS_rank_estimate() << ")" << std::endl;
+      std::cout << "#   --sp_disable_HSS_rank_estimate" << std::endl;
+      std::cout << "#          estimate the initial number of HSS random"
+                << " samples per front" << std::endl;
+      std::cout << "#   --sp_enable_HSS_regenerate_random (default "
+                << HSS_regenerate_random() << ")" << std::endl;
+      std::cout << "#   --sp_disable_HSS_regenerate_random" << std::endl;
+      std::cout << "#          regenerate, instead of store, the random"
+                << " vectors for indirect sampling" << std::endl;
       std::cout << "#   --sp_enable_replace_tiny_pivots" << std::endl;
       std::cout << "#   --sp_disable_replace_tiny_pivots" << std::endl;
+      std::cout << "#   --sp_enable_DAG_scheduler (default "
+                << use_DAG_scheduler() << ")" << std::endl;
+      std::cout << "#   --sp_disable_DAG_scheduler" << std::endl;
+      std::cout << "#          schedule the factorization of the tree"
+                << " as a task graph, instead of recursive tasks"
+                << std::endl;
+      std::cout << "#   --sp_enable_mixed_precision" << std::endl;
+      std::cout << "#   --sp_disable_mixed_precision" << std::endl;
+      std::cout << "#   --sp_enable_lookahead_LU (default "
+                << lookahead_LU() << ")" << std::endl;
+      std::cout << "#   --sp_disable_lookahead_LU" << std::endl;
+      std::cout << "#          factor distributed dense fronts with"
+                << " tournament pivoting and lookahead" << std::endl;
+      std::cout << "#   --sp_trace_file file (default none)" << std::endl;
+      std::cout << "#          write a Chrome trace (JSON) of the"
+                << " factorization and solve" << std::endl;
       std::cout << "#   --sp_verbose or -v (default " << verbose() << ")"
                 << std::endl;
       std::cout << "#   --sp_quiet or -q (default " << !verbose() << ")"
@@ -1265,6 +1552,7 @@ namespace strumpack {
     KrylovSolver _Krylov_solver = KrylovSolver::AUTO;
     int _gmres_restart = 30;
     GramSchmidtType _Gram_Schmidt_type = GramSchmidtType::MODIFIED;
+    int _solve_batch_size = 16;
     /** Reordering options */
     ReorderingStrategy _reordering_method = ReorderingStrategy::METIS;
     int _nd_param = 8;
@@ -1287,7 +1575,13 @@ namespace strumpack {
     int _hss_min_sep_size = 256;
     int _sep_order_level = 1;
     bool _indirect_sampling = false;
+    bool _HSS_rank_estimate = false;
+    bool _HSS_regenerate_random = false;
     bool _replace_tiny_pivots = false;
+    bool _use_DAG_scheduler = true;
+    bool _mixed_precision = false;
+    bool _lookahead_LU = false;
+    std::string _trace_file;
     HSS::HSSOptions<scalar_t> _hss_opts;
 
     /** BLR options */
@@ -1297,6 +1591,8 @@ namespace strumpack {
 
     int _argc = 0;
     char** _argv = nullptr;
+
+    template<typename other_t> friend class SPOptions;
   };
 
 } // end namespace strumpack
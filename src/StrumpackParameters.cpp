@@ -67,5 +67,9 @@ namespace strumpack {
     std::atomic<long long int> update_sample_flops(0);
     std::atomic<long long int> hss_solve_flops(0);
 
+    std::atomic<long long int> memory(0);
+    std::atomic<long long int> peak_memory(0);
+    std::atomic<long long int> phase_peak_memory(0);
+
   } // end namespace params
 } // end namespace strumpack
@@ -60,7 +60,20 @@ namespace strumpack { // these are all global variables
   enum class ReturnCode {
     SUCCESS,          /*!< Operation completed successfully. */
     MATRIX_NOT_SET,   /*!< The input matrix was not set.     */
-    REORDERING_ERROR  /*!< The matrix reordering failed.     */
+    REORDERING_ERROR, /*!< The matrix reordering failed.     */
+    NOT_SUPPORTED     /*!< Not supported with these options.  */
+  };
+
+  /**
+   * \brief Enumeration of the phases of the sparse solver, used to
+   * report the peak memory usage per phase.
+   * \ingroup Enumerations
+   */
+  enum class SolverPhase {
+    REORDER,   /*!< Matching, nested dissection and separator reordering */
+    SYMBOLIC,  /*!< Symbolic factorization, construct the tree   */
+    FACTOR,    /*!< Numerical factorization                      */
+    SOLVE      /*!< Solve, including iterative refinement/Krylov */
   };
 
   namespace params {
@@ -87,6 +100,23 @@ namespace strumpack { // these are all global variables
     extern std::atomic<long long int> update_sample_flops;
     extern std::atomic<long long int> hss_solve_flops;
 
+    // bytes currently allocated, and the high water mark, since the
+    // start of the program and since the start of the current solver
+    // phase (this one is reset by the solver)
+    extern std::atomic<long long int> memory;
+    extern std::atomic<long long int> peak_memory;
+    extern std::atomic<long long int> phase_peak_memory;
+
+    inline void update_peak(std::atomic<long long int>& peak, long long int m) {
+      auto p = peak.load();
+      while (m > p && !peak.compare_exchange_weak(p, m)) {}
+    }
+    inline void add_memory(long long int n) {
+      auto m = (memory += n);
+      update_peak(peak_memory, m);
+      update_peak(phase_peak_memory, m);
+    }
+
 #endif //DOXYGEN_SHOULD_SKIP_THIS
 
   } //end namespace params
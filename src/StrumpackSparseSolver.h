@@ -95,9 +95,17 @@ typedef enum {
 typedef enum {
   STRUMPACK_SUCCESS=0,
   STRUMPACK_MATRIX_NOT_SET=1,
-  STRUMPACK_REORDERING_ERROR=2
+  STRUMPACK_REORDERING_ERROR=2,
+  STRUMPACK_NOT_SUPPORTED=3
 } STRUMPACK_RETURN_CODE;
 
+typedef enum {
+  STRUMPACK_PHASE_REORDER=0,
+  STRUMPACK_PHASE_SYMBOLIC=1,
+  STRUMPACK_PHASE_FACTOR=2,
+  STRUMPACK_PHASE_SOLVE=3
+} STRUMPACK_SOLVER_PHASE;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -120,6 +128,14 @@ extern "C" {
    const void* d_ind, const void* d_val, const void* o_ptr,
    const void* o_ind, const void* o_val, const void* garray);
 
+  void STRUMPACK_update_csr_matrix_values
+  (STRUMPACK_SparseSolver S, const void* N, const void* row_ptr,
+   const void* col_ind, const void* values, int symmetric_pattern);
+  void STRUMPACK_update_distributed_csr_matrix_values
+  (STRUMPACK_SparseSolver S, const void* local_rows, const void* row_ptr,
+   const void* col_ind, const void* values, const void* dist,
+   int symmetric_pattern);
+
   STRUMPACK_RETURN_CODE STRUMPACK_solve
   (STRUMPACK_SparseSolver S, const void* b, void* x, int use_initial_guess);
 
@@ -192,6 +208,13 @@ extern "C" {
   int STRUMPACK_rank(STRUMPACK_SparseSolver S);
   long long STRUMPACK_factor_nonzeros(STRUMPACK_SparseSolver S);
   long long STRUMPACK_factor_memory(STRUMPACK_SparseSolver S);
+  void STRUMPACK_factor_memory_by_front_type
+  (STRUMPACK_SparseSolver S, long long* dense, long long* HSS,
+   long long* BLR);
+  long long STRUMPACK_current_memory(STRUMPACK_SparseSolver S);
+  long long STRUMPACK_peak_memory(STRUMPACK_SparseSolver S);
+  long long STRUMPACK_phase_peak_memory
+  (STRUMPACK_SparseSolver S, STRUMPACK_SOLVER_PHASE phase);
 
 #ifdef __cplusplus
 }
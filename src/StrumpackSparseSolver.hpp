@@ -37,6 +37,11 @@
 #include <getopt.h>
 #include <new>
 #include <cmath>
+#include <future>
+#include <mutex>
+#include <type_traits>
+#include <array>
+#include <numeric>
 #include "StrumpackConfig.hpp"
 #if defined(STRUMPACK_USE_TBB_MALLOC)
 #include <tbb/scalable_allocator.h>
@@ -96,6 +101,7 @@ namespace strumpack {
     using Reord_t = MatrixReordering<scalar_t,integer_t>;
     using DenseM_t = DenseMatrix<scalar_t>;
     using DenseMW_t = DenseMatrixWrapper<scalar_t>;
+    using scalar_sp_t = typename SinglePrecisionType<scalar_t>::value_type;
 
   public:
 
@@ -171,6 +177,50 @@ namespace strumpack {
     (integer_t N, const integer_t* row_ptr, const integer_t* col_ind,
      const scalar_t* values, bool symmetric_pattern=false);
 
+    /**
+     * Update the nonzero values of the matrix associated with this
+     * solver, keeping the sparsity pattern. When the solver has
+     * already been reordered (see reorder), the matching (column
+     * permutation and scaling), the fill-reducing ordering, the
+     * separator tree, the symbolic factorization and the HSS/BLR
+     * partitionings are all reused. Only the numerical factorization
+     * will be redone, on the next call to factor or solve. The
+     * matching scaling is not recomputed, it is based on the values
+     * passed to the original set_matrix.
+     *
+     * If the solver was not reordered yet, or if the sparsity
+     * pattern of A differs from the pattern of the current matrix,
+     * this behaves as set_matrix, and the next call to factor or
+     * solve will redo the reordering. For the
+     * StrumpackSparseSolverMPIDist solver, this routine is collective
+     * on the MPI communicator associated with the solver.
+     *
+     * \param A A CSRMatrix<scalar_t,integer_t> object with the same
+     * sparsity pattern as the matrix that was previously set, will
+     * internally be duplicated
+     * \see set_matrix, update_csr_matrix_values
+     */
+    virtual void update_matrix_values(const CSRMatrix<scalar_t,integer_t>& A);
+
+    /**
+     * Update the nonzero values of the matrix associated with this
+     * solver, keeping the sparsity pattern. The row_ptr and col_ind
+     * arrays should be the same as in the call to set_csr_matrix,
+     * only the values can change. See update_matrix_values.
+     *
+     * \param N number of rows and columns of the CSR input matrix.
+     * \param row_ptr indices in col_ind and values for the start of
+     * each row. Nonzeros for row r are in [row_ptr[r],row_ptr[r+1])
+     * \param col_ind column indices of each nonzero
+     * \param values nonzero values
+     * \param symmetric_pattern denotes whether the sparsity
+     * __pattern__ of the input matrix is symmetric
+     * \see update_matrix_values, set_csr_matrix
+     */
+    virtual void update_csr_matrix_values
+    (integer_t N, const integer_t* row_ptr, const integer_t* col_ind,
+     const scalar_t* values, bool symmetric_pattern=false);
+
     /**
      * Compute matrix reorderings for numerical stability and to
      * reduce fill-in.
@@ -274,6 +324,112 @@ namespace strumpack {
     virtual ReturnCode solve
     (const DenseM_t& b, DenseM_t& x, bool use_initial_guess=false);
 
+    /**
+     * Submit a single right-hand side for a batched solve, and return
+     * immediately. The right-hand sides submitted by (possibly
+     * different) threads are collected, and as soon as
+     * options().solve_batch_size() of them are queued, they are
+     * solved together as one multiple right-hand side solve (by the
+     * thread submitting the last one). This replaces many
+     * matrix-vector operations in the triangular solves over the
+     * elimination tree by matrix-matrix operations. Pending
+     * right-hand sides are solved by flush_solves.
+     *
+     * The arrays b and x should remain valid until the returned
+     * future is ready. b is not modified. For the
+     * StrumpackSparseSolverMPIDist solver, all processes should
+     * submit the same number of right-hand sides, in the same order,
+     * since the batched solve is collective.
+     *
+     * \param b right-hand side, same size as for solve
+     * \param x solution, same size as for solve, will be written
+     * when the batch containing this right-hand side is solved
+     * \return future holding the error code of the batched solve,
+     * or the exception thrown by it
+     * \see flush_solves, solve, SPOptions::set_solve_batch_size
+     */
+    std::future<ReturnCode> submit_solve(const scalar_t* b, scalar_t* x);
+
+    /**
+     * Solve all right-hand sides submitted with submit_solve that are
+     * still pending. This makes all futures returned by submit_solve
+     * ready. An exception thrown by the batched solve is stored in
+     * all futures of the batch, and rethrown.
+     *
+     * \return error code of the batched solve, SUCCESS if nothing
+     * was pending
+     * \see submit_solve
+     */
+    ReturnCode flush_solves();
+
+    /**
+     * Solve with sparse right-hand sides, and optionally compute only
+     * some components of the solution. The forward solve only visits
+     * the fronts on the paths from the nonzero rows of the
+     * right-hand side to the root, and the backward solve only the
+     * fronts on the paths from the root to the requested components.
+     * The right-hand sides are sorted by the position of their
+     * nonzeros in the elimination tree and solved in batches of at
+     * most options().solve_batch_size(), so that right-hand sides
+     * with a similar support are solved together. This uses the
+     * (approximate) factorization directly, no iterative solver. It
+     * will call factor() if the matrix was not factored yet.
+     *
+     * \param nrhs number of right-hand sides
+     * \param b_ptr column pointers of the right-hand sides, in CSC
+     * format, size nrhs+1
+     * \param b_ind row indices of the nonzeros of the right-hand sides
+     * \param b_val values of the nonzeros of the right-hand sides
+     * \param x on output the solution, N x nrhs, column major, with
+     * leading dimension ldx. Only the requested components are set,
+     * the others are set to zero.
+     * \param ldx leading dimension of x, >= N
+     * \param nsol number of requested solution components, 0 means
+     * the full solution
+     * \param sol the indices of the requested solution components
+     * \return error code
+     * \see solve, SPOptions::set_solve_batch_size
+     */
+    virtual ReturnCode sparse_solve
+    (integer_t nrhs, const integer_t* b_ptr, const integer_t* b_ind,
+     const scalar_t* b_val, scalar_t* x, integer_t ldx,
+     integer_t nsol=0, const integer_t* sol=nullptr);
+
+    /**
+     * Compute the diagonal of the inverse of the matrix, using
+     * selected inversion with the multifrontal factors, instead of N
+     * solves. This will call factor() if the matrix was not factored
+     * yet. The dense and BLR fronts support selected inversion (for
+     * BLR, this is the inverse of the approximate factorization),
+     * HSS fronts do not. An entry (i,j) of the inverse is found if
+     * the factored matrix has a (structural) nonzero at position
+     * (j,i) of the input matrix. With the matching disabled, or with
+     * a symmetric sparsity pattern, position (i,j) is also fine.
+     *
+     * \param d on output holds the diagonal of inv(A), should have
+     * space for N values
+     * \return error code, NOT_SUPPORTED if an entry could not be
+     * computed
+     * \see inverse_on_pattern
+     */
+    virtual ReturnCode inverse_diagonal(scalar_t* d);
+
+    /**
+     * Compute the entries of the inverse of the matrix on a given
+     * sparsity pattern (typically that of the input matrix), using
+     * selected inversion, see inverse_diagonal.
+     *
+     * \param row_ptr row pointers of the sparsity pattern, CSR
+     * format, size N+1
+     * \param col_ind column indices of the sparsity pattern
+     * \param values on output holds inv(A) on the sparsity pattern,
+     * size row_ptr[N]-row_ptr[0]
+     * \return error code
+     * \see inverse_diagonal
+     */
+    virtual ReturnCode inverse_on_pattern
+    (const integer_t* row_ptr, const integer_t* col_ind, scalar_t* values);
+
     /**
      * Return the object holding the options for this sparse solver.
      */
@@ -311,7 +467,9 @@ namespace strumpack {
      * distributed memory solvers, this routine is collective on the
      * MPI communicator.
      */
-    int maximum_rank() const { return tree()->maximum_rank(); }
+    int maximum_rank() const {
+      return tree_sp_ ? tree_sp_->maximum_rank() : tree()->maximum_rank();
+    }
 
     /**
      * Return the number of nonzeros in the (sparse) factors. This is
@@ -320,20 +478,72 @@ namespace strumpack {
      * StrumpackSparseSolverMPIDist distributed memory solvers, this
      * routine is collective on the MPI communicator.
      */
-    std::size_t factor_nonzeros() const { return tree()->factor_nonzeros(); }
+    std::size_t factor_nonzeros() const {
+      return tree_sp_ ? tree_sp_->factor_nonzeros() : tree()->factor_nonzeros();
+    }
 
     /**
      * Return the amount of memory taken by the sparse factorization
      * factors. This is the fill-in. It is simply computed as
-     * factor_nonzeros() * sizeof(scalar_t), so it does not include
-     * any overhead from the metadata for the datastructures. This
-     * should be called after the factorization. For the
-     * StrumpackSparseSolverMPI and StrumpackSparseSolverMPIDist
-     * distributed memory solvers, this routine is collective on the
-     * MPI communicator.
+     * factor_nonzeros() * sizeof(scalar_t), or sizeof the single
+     * precision type with SPOptions::enable_mixed_precision(), so it
+     * does not include any overhead from the metadata for the
+     * datastructures. This should be called after the
+     * factorization. For the StrumpackSparseSolverMPI and
+     * StrumpackSparseSolverMPIDist distributed memory solvers, this
+     * routine is collective on the MPI communicator.
      */
     std::size_t factor_memory() const
-    { return tree()->factor_nonzeros() * sizeof(scalar_t); }
+    { return factor_nonzeros() * factor_scalar_size(); }
+
+    /**
+     * Return the factor memory, see factor_memory(), split by the
+     * type of the frontal matrices. This should be called after the
+     * factorization. For the StrumpackSparseSolverMPI and
+     * StrumpackSparseSolverMPIDist distributed memory solvers, this
+     * routine is collective on the MPI communicator.
+     *
+     * \param dense memory of the factors of the dense fronts
+     * \param HSS memory of the factors of the HSS fronts
+     * \param BLR memory of the factors of the BLR fronts
+     */
+    void factor_memory_by_front_type
+    (std::size_t& dense, std::size_t& HSS, std::size_t& BLR) const {
+      auto nnz = tree_sp_ ? tree_sp_->factor_nonzeros_by_type() :
+        tree()->factor_nonzeros_by_type();
+      dense = nnz[0] * factor_scalar_size();
+      HSS = nnz[1] * factor_scalar_size();
+      BLR = nnz[2] * factor_scalar_size();
+    }
+
+    /**
+     * Return the number of bytes currently allocated for dense
+     * matrices (this includes the frontal matrices, the factors,
+     * BLR tiles and HSS generators, but not the sparse matrix or
+     * the reordering vectors) on this process. This requires
+     * STRUMPACK to be built with STRUMPACK_COUNT_MEMORY, otherwise
+     * this returns 0. The counter is global, so it includes all
+     * solver objects.
+     */
+    std::size_t current_memory() const { return params::memory; }
+
+    /**
+     * Return the maximum, over the lifetime of the program, of
+     * current_memory(). This is for this process only, see
+     * current_memory().
+     */
+    std::size_t peak_memory() const { return params::peak_memory; }
+
+    /**
+     * Return the maximum of current_memory() during the last call to
+     * the given phase of this solver, on this process.
+     *
+     * \param p the solver phase, reordering, symbolic or numerical
+     * factorization or solve
+     * \see current_memory()
+     */
+    std::size_t peak_memory(SolverPhase p) const
+    { return phase_peak_memory_[static_cast<int>(p)]; }
 
     /**
      * Return the number of iterations performed by the outer (Krylov)
@@ -349,7 +559,10 @@ namespace strumpack {
      * \verbatim gnuplot plotname.gnuplot \endverbatim will generate a
      * pdf file.
      */
-    void draw(const std::string& name) const { tree()->draw(*matrix(), name); }
+    void draw(const std::string& name) const {
+      if (tree_sp_) tree_sp_->draw(*mat_sp_, name);
+      else tree()->draw(*matrix(), name);
+    }
 
   protected:
     virtual void setup_tree();
@@ -364,15 +577,38 @@ namespace strumpack {
     virtual const SpMat_t* matrix() const { return mat_.get(); }
     virtual const Reord_t* reordering() const { return nd_.get(); }
     virtual const Tree_t* tree() const { return tree_.get(); }
+    /** number of rows of the right-hand side on this process */
+    virtual integer_t local_rhs_rows() const { return matrix()->size(); }
 
     void papi_initialize();
     inline long long dense_factor_nonzeros() const {
-      return tree()->dense_factor_nonzeros();
+      return tree_sp_ ? tree_sp_->dense_factor_nonzeros() :
+        tree()->dense_factor_nonzeros();
     }
     inline long long dense_factor_memory() const {
-      return tree()->dense_factor_nonzeros() * sizeof(scalar_t);
+      return dense_factor_nonzeros() * factor_scalar_size();
+    }
+    inline std::size_t factor_scalar_size() const {
+      return tree_sp_ ? sizeof(scalar_sp_t) : sizeof(scalar_t);
     }
     void print_solve_stats(TaskTimer& t) const;
+    void memory_phase_start() const
+    { params::phase_peak_memory = params::memory.load(); }
+    void memory_phase_stop(SolverPhase p)
+    { phase_peak_memory_[static_cast<int>(p)] = params::phase_peak_memory; }
+    /**
+     * Print the peak memory usage of phase p. For the distributed
+     * memory solvers this prints the total, min and max over all
+     * processes, and is collective.
+     */
+    virtual void print_peak_memory(SolverPhase p) const;
+    void trace_start() const
+    { if (!opts_.trace_file().empty()) Tracer::enable(); }
+    /**
+     * Write the trace, if enabled, see SPOptions::set_trace_file().
+     * For the distributed memory solvers, this is collective.
+     */
+    virtual void trace_write() const;
     virtual void perf_counters_start();
     virtual void perf_counters_stop(const std::string& s);
     virtual void synchronize() {}
@@ -390,12 +626,54 @@ namespace strumpack {
     std::vector<integer_t> matching_cperm_;
     std::vector<scalar_t> matching_Dr_; // row scaling
     std::vector<scalar_t> matching_Dc_; // column scaling
+
+    /**
+     * Permutation and scaling of the right-hand side and solution in
+     * solve, combining the matching and the fill reducing ordering
+     * in a single pass, see setup_solve_plan. Row i of the permuted
+     * right-hand side is rhs_scale_[i] * b(rhs_perm_[i]), and row
+     * sol_perm_[i] of the solution is sol_scale_[i] * x(i). The
+     * scalings are empty when no scaling is used.
+     */
+    std::vector<integer_t> rhs_perm_, sol_perm_;
+    std::vector<scalar_t> rhs_scale_, sol_scale_;
+    /**
+     * workspace for the permuted right-hand side and solution, used
+     * by one solve at a time, see solve_mtx_
+     */
+    DenseM_t solve_b_, solve_x_;
+    virtual void setup_solve_plan();
+    void permute_rhs(const DenseM_t& b, DenseM_t& bp) const;
+    void permute_solution(const DenseM_t& xp, DenseM_t& x) const;
+    void permute_initial_guess(const DenseM_t& x, DenseM_t& xp) const;
+
     std::new_handler old_handler_;
     std::ostream* rank_out_ = nullptr;
     bool factored_ = false;
     bool reordered_ = false;
     int Krylov_its_ = 0;
 
+    /** right-hand sides queued by submit_solve */
+    struct QueuedSolve {
+      const scalar_t* b;
+      scalar_t* x;
+      std::promise<ReturnCode> done;
+    };
+    std::vector<QueuedSolve> solve_queue_;
+    std::mutex solve_queue_mtx_, batched_solve_mtx_, solve_mtx_;
+    ReturnCode solve_batch(std::vector<QueuedSolve>& batch);
+
+    void inverse_solve_plan
+    (std::vector<integer_t>& rhs_iperm,
+     std::vector<integer_t>& sol_iperm) const;
+    ReturnCode selected_inverse
+    (const std::vector<integer_t>& I, const std::vector<integer_t>& J,
+     scalar_t* values);
+    template<typename T> bool selected_inverse
+    (const EliminationTree<T,integer_t>& tree,
+     const std::vector<integer_t>& I, const std::vector<integer_t>& J,
+     scalar_t* values) const;
+
 #if defined(STRUMPACK_USE_PAPI)
     float rtime_ = 0., ptime_ = 0.;
     long_long _flpops = 0;
@@ -404,10 +682,21 @@ namespace strumpack {
     long long int f0_ = 0, ftot_ = 0, fmin_ = 0, fmax_ = 0;
     long long int b0_ = 0, btot_ = 0, bmin_ = 0, bmax_ = 0;
 #endif
+    std::array<long long int,4> phase_peak_memory_ = {{0, 0, 0, 0}};
   private:
     std::unique_ptr<CSRMatrix<scalar_t,integer_t>> mat_;
     std::unique_ptr<MatrixReordering<scalar_t,integer_t>> nd_;
     std::unique_ptr<EliminationTree<scalar_t,integer_t>> tree_;
+    // single precision copy of the matrix and single precision tree,
+    // used instead of tree_ for the mixed precision factorization
+    std::unique_ptr<CSRMatrix<scalar_sp_t,integer_t>> mat_sp_;
+    std::unique_ptr<EliminationTree<scalar_sp_t,integer_t>> tree_sp_;
+    // single precision work copy of the right-hand side in the solve
+    mutable DenseMatrix<scalar_sp_t> solve_sp_;
+
+    void copy_matrix_to_single_precision();
+    void multifrontal_solve
+    (DenseM_t& x, const SolvePruning* prune=nullptr) const;
   };
 
   template<typename scalar_t,typename integer_t>
@@ -462,8 +751,69 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t> void
   StrumpackSparseSolver<scalar_t,integer_t>::setup_tree() {
-    tree_ = std::unique_ptr<EliminationTree<scalar_t,integer_t>>
-      (new EliminationTree<scalar_t,integer_t>(opts_, *mat_, nd_->tree()));
+    if (opts_.mixed_precision() &&
+        !std::is_same<scalar_sp_t,scalar_t>::value) {
+      tree_.reset();
+      copy_matrix_to_single_precision();
+      tree_sp_ = std::unique_ptr<EliminationTree<scalar_sp_t,integer_t>>
+        (new EliminationTree<scalar_sp_t,integer_t>
+         (SPOptions<scalar_sp_t>(opts_), *mat_sp_, nd_->tree()));
+    } else {
+      tree_sp_.reset();
+      mat_sp_.reset();
+      tree_ = std::unique_ptr<EliminationTree<scalar_t,integer_t>>
+        (new EliminationTree<scalar_t,integer_t>(opts_, *mat_, nd_->tree()));
+    }
+  }
+
+  /**
+   * (Re)create the single precision copy of the (reordered) matrix,
+   * for the mixed precision factorization. The sparsity pattern is
+   * only copied when it changed.
+   */
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::copy_matrix_to_single_precision() {
+    const auto N = mat_->size();
+    const auto nnz = mat_->nnz();
+    if (!mat_sp_ || mat_sp_->size() != N || mat_sp_->nnz() != nnz ||
+        !std::equal(mat_->ptr(), mat_->ptr()+N+1, mat_sp_->ptr()) ||
+        !std::equal(mat_->ind(), mat_->ind()+nnz, mat_sp_->ind())) {
+      mat_sp_ = std::unique_ptr<CSRMatrix<scalar_sp_t,integer_t>>
+        (new CSRMatrix<scalar_sp_t,integer_t>(N, nnz));
+      std::copy(mat_->ptr(), mat_->ptr()+N+1, mat_sp_->ptr());
+      std::copy(mat_->ind(), mat_->ind()+nnz, mat_sp_->ind());
+    }
+    mat_sp_->set_symm_sparse(mat_->symm_sparse());
+    auto v = mat_->val();
+    auto vsp = mat_sp_->val();
+    for (integer_t i=0; i<nnz; i++)
+      vsp[i] = static_cast<scalar_sp_t>(v[i]);
+  }
+
+  /**
+   * Apply the multifrontal solve, in place, to x, which is in the
+   * permuted and scaled space. With the mixed precision
+   * factorization, x is rounded to single precision for the
+   * solve. If prune is given, the solve is pruned, see
+   * EliminationTree::prune_backward.
+   */
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::multifrontal_solve
+  (DenseM_t& x, const SolvePruning* prune) const {
+    if (tree_sp_) {
+      auto& xsp = solve_sp_;
+      if (xsp.rows() != x.rows() || xsp.cols() != x.cols())
+        xsp = DenseMatrix<scalar_sp_t>(x.rows(), x.cols());
+      for (std::size_t j=0; j<x.cols(); j++)
+        for (std::size_t i=0; i<x.rows(); i++)
+          xsp(i, j) = static_cast<scalar_sp_t>(x(i, j));
+      if (prune) tree_sp_->multifrontal_solve(xsp, *prune);
+      else tree_sp_->multifrontal_solve(xsp);
+      for (std::size_t j=0; j<x.cols(); j++)
+        for (std::size_t i=0; i<x.rows(); i++)
+          x(i, j) = xsp(i, j);
+    } else if (prune) tree()->multifrontal_solve(x, *prune);
+    else tree()->multifrontal_solve(x);
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -570,6 +920,22 @@ namespace strumpack {
 #endif
   }
 
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::print_peak_memory
+  (SolverPhase p) const {
+#if defined(STRUMPACK_COUNT_MEMORY)
+    if (opts_.verbose() && is_root_)
+      std::cout << "#   - peak memory = "
+                << peak_memory(p) / 1e6 << " MB" << std::endl;
+#endif
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::trace_write() const {
+    if (!opts_.trace_file().empty())
+      Tracer::write_chrome_trace(opts_.trace_file());
+  }
+
   template<typename scalar_t,typename integer_t> void
   StrumpackSparseSolver<scalar_t,integer_t>::print_solve_stats
   (TaskTimer& t) const {
@@ -598,6 +964,7 @@ namespace strumpack {
                 << " flop/byte" << std::endl;
 #endif
     }
+    if (opts_.verbose()) print_peak_memory(SolverPhase::SOLVE);
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -618,10 +985,54 @@ namespace strumpack {
     factored_ = reordered_ = false;
   }
 
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::update_matrix_values
+  (const CSRMatrix<scalar_t,integer_t>& A) {
+    if (!reordered_ || A.size() != matrix()->size()) {
+      set_matrix(A);
+      return;
+    }
+    // apply the same transformations as reorder did to the original
+    // matrix: matching, symmetrization and symmetric permutation
+    CSRMatrix<scalar_t,integer_t> Anew(A);
+    if (opts_.matching() != MatchingJob::NONE) {
+      if (opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
+        Anew.apply_scaling(matching_Dr_, matching_Dc_);
+      Anew.apply_column_permutation(matching_cperm_);
+      Anew.set_symm_sparse(false);
+    }
+    Anew.symmetrize_sparsity();
+    Anew.permute(reordering()->iperm(), reordering()->perm());
+    auto M = matrix();
+    if (Anew.nnz() != M->nnz() ||
+        !std::equal(Anew.ptr(), Anew.ptr()+Anew.size()+1, M->ptr()) ||
+        !std::equal(Anew.ind(), Anew.ind()+Anew.nnz(), M->ind())) {
+      if (opts_.verbose() && is_root_)
+        std::cout << "# WARNING: sparsity pattern has changed,"
+                  << " the matrix will be reordered again" << std::endl;
+      set_matrix(A);
+      return;
+    }
+    std::copy(Anew.val(), Anew.val()+Anew.nnz(), M->val());
+    factored_ = false;
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::update_csr_matrix_values
+  (integer_t N, const integer_t* row_ptr, const integer_t* col_ind,
+   const scalar_t* values, bool symmetric_pattern) {
+    update_matrix_values
+      (CSRMatrix<scalar_t,integer_t>
+       (N, row_ptr, col_ind, values, symmetric_pattern));
+  }
+
   template<typename scalar_t,typename integer_t> ReturnCode
   StrumpackSparseSolver<scalar_t,integer_t>::reorder
   (int nx, int ny, int nz, int components, int width) {
     if (!matrix()) return ReturnCode::MATRIX_NOT_SET;
+    trace_start();
+    memory_phase_start();
+    TraceSpan trace_reorder("reorder");
     TaskTimer t1("permute-scale");
     int ierr;
     if (opts_.matching() != MatchingJob::NONE) {
@@ -661,6 +1072,7 @@ namespace strumpack {
       return ReturnCode::REORDERING_ERROR;
     }
     matrix()->permute(reordering()->iperm(), reordering()->perm());
+    setup_solve_plan();
     t3.stop();
     if (opts_.verbose() && is_root_) {
       std::cout << "#   - nd time = " << t3.elapsed() << std::endl;
@@ -681,15 +1093,26 @@ namespace strumpack {
         std::cout << "#   - sep-reorder time = " << t4.elapsed() << std::endl;
       perf_counters_stop("separator reordering");
     }
+    trace_reorder.stop();
+    memory_phase_stop(SolverPhase::REORDER);
+    if (opts_.verbose()) print_peak_memory(SolverPhase::REORDER);
 
     perf_counters_start();
-    TaskTimer t0("symbolic-factorization", [&](){ setup_tree(); });
+    memory_phase_start();
+    TaskTimer t0("symbolic-factorization", [&](){
+        TraceSpan trace("symbolic");
+        setup_tree();
+      });
+    memory_phase_stop(SolverPhase::SYMBOLIC);
     reordering()->clear_tree_data();
     if (opts_.verbose()) {
       // this might require a reduction
-      auto nr_dense = tree()->nr_dense_fronts();
-      auto nr_HSS = tree()->nr_HSS_fronts();
-      auto nr_BLR = tree()->nr_BLR_fronts();
+      auto nr_dense = tree_sp_ ? tree_sp_->nr_dense_fronts() :
+        tree()->nr_dense_fronts();
+      auto nr_HSS = tree_sp_ ? tree_sp_->nr_HSS_fronts() :
+        tree()->nr_HSS_fronts();
+      auto nr_BLR = tree_sp_ ? tree_sp_->nr_BLR_fronts() :
+        tree()->nr_BLR_fronts();
       if (is_root_) {
         std::cout << "# symbolic factorization:" << std::endl;
         std::cout << "#   - nr of dense Frontal matrices = "
@@ -700,6 +1123,7 @@ namespace strumpack {
                   << number_format_with_commas(nr_BLR) << std::endl;
         std::cout << "#   - symb-factor time = " << t0.elapsed() << std::endl;
       }
+      print_peak_memory(SolverPhase::SYMBOLIC);
     }
     perf_counters_stop("symbolic factorization");
 
@@ -719,6 +1143,222 @@ namespace strumpack {
     return ReturnCode::SUCCESS;
   }
 
+  template<typename scalar_t,typename integer_t> std::future<ReturnCode>
+  StrumpackSparseSolver<scalar_t,integer_t>::submit_solve
+  (const scalar_t* b, scalar_t* x) {
+    std::vector<QueuedSolve> batch;
+    std::future<ReturnCode> f;
+    {
+      std::lock_guard<std::mutex> lock(solve_queue_mtx_);
+      solve_queue_.push_back(QueuedSolve{b, x, std::promise<ReturnCode>()});
+      f = solve_queue_.back().done.get_future();
+      if (solve_queue_.size() >= std::size_t(opts_.solve_batch_size()))
+        std::swap(batch, solve_queue_);
+    }
+    if (!batch.empty()) {
+      // an error is stored in the futures of the whole batch,
+      // including f, so it is not thrown here
+      try { solve_batch(batch); } catch (...) { }
+    }
+    return f;
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  StrumpackSparseSolver<scalar_t,integer_t>::flush_solves() {
+    std::vector<QueuedSolve> batch;
+    {
+      std::lock_guard<std::mutex> lock(solve_queue_mtx_);
+      std::swap(batch, solve_queue_);
+    }
+    return solve_batch(batch);
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  StrumpackSparseSolver<scalar_t,integer_t>::solve_batch
+  (std::vector<QueuedSolve>& batch) {
+    if (batch.empty()) return ReturnCode::SUCCESS;
+    // only one batch is solved at a time
+    std::lock_guard<std::mutex> lock(batched_solve_mtx_);
+    std::size_t n = local_rhs_rows(), nrhs = batch.size();
+    ReturnCode ierr = ReturnCode::SUCCESS;
+    try {
+      DenseM_t B(n, nrhs), X(n, nrhs);
+      for (std::size_t c=0; c<nrhs; c++)
+        std::copy(batch[c].b, batch[c].b+n, B.ptr(0, c));
+      ierr = solve(B, X);
+      for (std::size_t c=0; c<nrhs; c++)
+        std::copy(X.ptr(0, c), X.ptr(0, c)+n, batch[c].x);
+    } catch (...) {
+      // do not leave any of the futures waiting forever
+      for (auto& s : batch) s.done.set_exception(std::current_exception());
+      throw;
+    }
+    for (auto& s : batch) s.done.set_value(ierr);
+    return ierr;
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  StrumpackSparseSolver<scalar_t,integer_t>::sparse_solve
+  (integer_t nrhs, const integer_t* b_ptr, const integer_t* b_ind,
+   const scalar_t* b_val, scalar_t* x, integer_t ldx,
+   integer_t nsol, const integer_t* sol) {
+    if (!matrix()) return ReturnCode::MATRIX_NOT_SET;
+    if (!this->factored_) {
+      ReturnCode ierr = factor();
+      if (ierr != ReturnCode::SUCCESS) return ierr;
+    }
+    TaskTimer t("sparse_solve");
+    t.start();
+    const integer_t N = matrix()->size();
+    std::vector<integer_t> rhs_iperm, sol_iperm;
+    inverse_solve_plan(rhs_iperm, sol_iperm);
+    // requested solution rows, in the ordering of the factors
+    std::vector<integer_t> sol_rows(nsol);
+    for (integer_t i=0; i<nsol; i++)
+      sol_rows[i] = sol_iperm[sol[i]];
+    std::sort(sol_rows.begin(), sol_rows.end());
+    // the fronts needed for the requested solution rows, the same
+    // for all batches, the forward solve is pruned per batch
+    SolvePruning prune;
+    if (tree_sp_) tree_sp_->prune_backward(sol_rows, prune);
+    else tree()->prune_backward(sol_rows, prune);
+    // sort the right-hand sides by their first nonzero in the
+    // ordering of the factors, which is a postordering of the tree,
+    // so right-hand sides in the same subtree end up in one batch
+    std::vector<integer_t> rhs_order(nrhs), rhs_first(nrhs, N);
+    for (integer_t c=0; c<nrhs; c++) {
+      rhs_order[c] = c;
+      for (integer_t k=b_ptr[c]; k<b_ptr[c+1]; k++)
+        rhs_first[c] = std::min(rhs_first[c], rhs_iperm[b_ind[k]]);
+    }
+    std::stable_sort
+      (rhs_order.begin(), rhs_order.end(),
+       [&](integer_t a, integer_t b) { return rhs_first[a] < rhs_first[b]; });
+    const integer_t bs = opts_.solve_batch_size();
+    const bool rscale = !rhs_scale_.empty(), sscale = !sol_scale_.empty();
+    DenseMW_t X(N, nrhs, x, ldx);
+    X.zero();
+    std::vector<integer_t> rhs_rows;
+    for (integer_t c0=0; c0<nrhs; c0+=bs) {
+      const integer_t nb = std::min(bs, nrhs-c0);
+      DenseM_t B(N, nb);
+      B.zero();
+      rhs_rows.clear();
+      for (integer_t c=0; c<nb; c++) {
+        auto bc = rhs_order[c0+c];
+        for (integer_t k=b_ptr[bc]; k<b_ptr[bc+1]; k++) {
+          auto i = rhs_iperm[b_ind[k]];
+          B(i, c) += rscale ? rhs_scale_[i] * b_val[k] : b_val[k];
+          rhs_rows.push_back(i);
+        }
+      }
+      std::sort(rhs_rows.begin(), rhs_rows.end());
+      rhs_rows.erase(std::unique(rhs_rows.begin(), rhs_rows.end()),
+                     rhs_rows.end());
+      if (tree_sp_) tree_sp_->prune_forward(rhs_rows, prune);
+      else tree()->prune_forward(rhs_rows, prune);
+      multifrontal_solve(B, &prune);
+      for (integer_t c=0; c<nb; c++) {
+        auto xc = rhs_order[c0+c];
+        auto copy_row = [&](integer_t i) {
+          X(sol_perm_[i], xc) = sscale ? sol_scale_[i] * B(i, c) : B(i, c);
+        };
+        if (nsol) for (auto i : sol_rows) copy_row(i);
+        else for (integer_t i=0; i<N; i++) copy_row(i);
+      }
+    }
+    t.stop();
+    if (opts_.verbose() && is_root_)
+      std::cout << "# sparse solve, " << nrhs << " right-hand sides, time = "
+                << t.elapsed() << std::endl;
+    return ReturnCode::SUCCESS;
+  }
+
+  /**
+   * Inverse of the permutations rhs_perm_ and sol_perm_ of the
+   * solve plan.
+   */
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::inverse_solve_plan
+  (std::vector<integer_t>& rhs_iperm, std::vector<integer_t>& sol_iperm) const {
+    const integer_t N = matrix()->size();
+    rhs_iperm.resize(N);
+    sol_iperm.resize(N);
+    for (integer_t i=0; i<N; i++) {
+      rhs_iperm[rhs_perm_[i]] = i;
+      sol_iperm[sol_perm_[i]] = i;
+    }
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  StrumpackSparseSolver<scalar_t,integer_t>::inverse_diagonal(scalar_t* d) {
+    if (!matrix()) return ReturnCode::MATRIX_NOT_SET;
+    const integer_t N = matrix()->size();
+    std::vector<integer_t> I(N);
+    std::iota(I.begin(), I.end(), 0);
+    return selected_inverse(I, I, d);
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  StrumpackSparseSolver<scalar_t,integer_t>::inverse_on_pattern
+  (const integer_t* row_ptr, const integer_t* col_ind, scalar_t* values) {
+    if (!matrix()) return ReturnCode::MATRIX_NOT_SET;
+    const integer_t N = matrix()->size();
+    std::vector<integer_t> I, J(col_ind+row_ptr[0], col_ind+row_ptr[N]);
+    I.reserve(J.size());
+    for (integer_t r=0; r<N; r++)
+      I.insert(I.end(), row_ptr[r+1]-row_ptr[r], r);
+    return selected_inverse(I, J, values);
+  }
+
+  template<typename scalar_t,typename integer_t> ReturnCode
+  StrumpackSparseSolver<scalar_t,integer_t>::selected_inverse
+  (const std::vector<integer_t>& I, const std::vector<integer_t>& J,
+   scalar_t* values) {
+    if (!this->factored_) {
+      ReturnCode ierr = factor();
+      if (ierr != ReturnCode::SUCCESS) return ierr;
+    }
+    TaskTimer t("selected_inversion");
+    t.start();
+    bool ok = tree_sp_ ? selected_inverse(*tree_sp_, I, J, values) :
+      selected_inverse(*tree(), I, J, values);
+    t.stop();
+    if (opts_.verbose() && is_root_)
+      std::cout << "# selected inversion, " << I.size()
+                << " entries, time = " << t.elapsed() << std::endl;
+    return ok ? ReturnCode::SUCCESS : ReturnCode::NOT_SUPPORTED;
+  }
+
+  /**
+   * The solve computes x = inv(A) b as
+   *   x(sol_perm_[k]) = sol_scale_[k] sum_l Z(k,l) rhs_scale_[l] b(rhs_perm_[l]),
+   * with Z the inverse of the factored matrix, so
+   *   inv(A)(sol_perm_[k],rhs_perm_[l]) = sol_scale_[k] Z(k,l) rhs_scale_[l].
+   */
+  template<typename scalar_t,typename integer_t>
+  template<typename T> bool
+  StrumpackSparseSolver<scalar_t,integer_t>::selected_inverse
+  (const EliminationTree<T,integer_t>& tree,
+   const std::vector<integer_t>& I, const std::vector<integer_t>& J,
+   scalar_t* values) const {
+    std::vector<integer_t> rhs_iperm, sol_iperm;
+    inverse_solve_plan(rhs_iperm, sol_iperm);
+    std::vector<InverseEntry<T,integer_t>> e(I.size());
+    for (std::size_t k=0; k<I.size(); k++) {
+      e[k].i = sol_iperm[I[k]];
+      e[k].j = rhs_iperm[J[k]];
+      e[k].pos = k;
+    }
+    if (!tree.selected_inversion(e)) return false;
+    const bool scale = !sol_scale_.empty();
+    for (auto& ek : e)
+      values[ek.pos] = scale ?
+        sol_scale_[ek.i] * scalar_t(ek.v) * rhs_scale_[ek.j] :
+        scalar_t(ek.v);
+    return true;
+  }
+
   template<typename scalar_t,typename integer_t> void
   StrumpackSparseSolver<scalar_t,integer_t>::flop_breakdown() const {
 #if defined(STRUMPACK_COUNT_FLOPS)
@@ -823,19 +1463,39 @@ namespace strumpack {
     }
     perf_counters_start();
     flop_breakdown_reset();
+    memory_phase_start();
+    trace_start();
     TaskTimer t1("factorization", [&]() {
-        tree()->multifrontal_factorization(*matrix(), opts_);
+        TraceSpan trace("factor");
+        if (tree_sp_) {
+          copy_matrix_to_single_precision();
+          tree_sp_->multifrontal_factorization
+            (*mat_sp_, SPOptions<scalar_sp_t>(opts_));
+        } else tree()->multifrontal_factorization(*matrix(), opts_);
       });
     perf_counters_stop("numerical factorization");
+    memory_phase_stop(SolverPhase::FACTOR);
     if (opts_.verbose()) {
+      std::size_t dense_mem, HSS_mem, BLR_mem;
+      factor_memory_by_front_type(dense_mem, HSS_mem, BLR_mem);
       auto fnnz = factor_nonzeros();
       auto max_rank = maximum_rank();
+      auto cb_mem = tree_sp_ ? tree_sp_->CB_stack_memory() :
+        tree()->CB_stack_memory();
       if (is_root_) {
         std::cout << "#   - factor time = " << t1.elapsed() << std::endl;
         std::cout << "#   - factor nonzeros = "
                   << number_format_with_commas(fnnz) << std::endl;
         std::cout << "#   - factor memory = "
-                  << fnnz * sizeof(scalar_t) / 1e6 << " MB" << std::endl;
+                  << fnnz * factor_scalar_size() / 1e6 << " MB" << std::endl;
+        if (tree_sp_)
+          std::cout << "#   - mixed precision, factors stored in"
+                    << " single precision" << std::endl;
+        std::cout << "#   - factor memory dense/HSS/BLR fronts = "
+                  << dense_mem / 1e6 << " / " << HSS_mem / 1e6 << " / "
+                  << BLR_mem / 1e6 << " MB" << std::endl;
+        std::cout << "#   - contribution block stack memory = "
+                  << cb_mem / 1e6 << " MB" << std::endl;
 #if defined(STRUMPACK_COUNT_FLOPS)
         std::cout << "#   - total flops = " << double(ftot_) << ", min = "
                   << double(fmin_) << ", max = " << double(fmax_)
@@ -844,7 +1504,7 @@ namespace strumpack {
                   << " GFlop/s" << std::endl;
 #endif
         std::cout << "#   - factor memory/nonzeros = "
-                  << float(fnnz * sizeof(scalar_t)) / dfnnz * 100.0
+                  << float(fnnz * factor_scalar_size()) / dfnnz * 100.0
                   << " % of multifrontal" << std::endl;
         std::cout << "#   - maximum HSS rank = " << max_rank << std::endl;
         std::cout << "#   - HSS compression = " << std::boolalpha
@@ -870,10 +1530,15 @@ namespace strumpack {
         }
 
       }
+      print_peak_memory(SolverPhase::FACTOR);
       if (opts_.use_HSS())
         flop_breakdown();
     }
-    if (rank_out_) tree()->print_rank_statistics(*rank_out_);
+    if (rank_out_) {
+      if (tree_sp_) tree_sp_->print_rank_statistics(*rank_out_);
+      else tree()->print_rank_statistics(*rank_out_);
+    }
+    trace_write();
     factored_ = true;
     return ReturnCode::SUCCESS;
   }
@@ -887,6 +1552,72 @@ namespace strumpack {
     return solve(*B, X, use_initial_guess);
   }
 
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::setup_solve_plan() {
+    const auto& iperm = reordering()->iperm();
+    const integer_t N = matrix()->size();
+    bool scale =
+      opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING;
+    rhs_perm_.assign(iperm.begin(), iperm.begin()+N);
+    sol_perm_.resize(N);
+    rhs_scale_.clear();
+    sol_scale_.clear();
+    if (scale) {
+      rhs_scale_.resize(N);
+      sol_scale_.resize(N);
+    }
+    for (integer_t i=0; i<N; i++) {
+      sol_perm_[i] = (opts_.matching() != MatchingJob::NONE) ?
+        matching_cperm_[iperm[i]] : iperm[i];
+      if (scale) {
+        rhs_scale_[i] = matching_Dr_[iperm[i]];
+        sol_scale_[i] = matching_Dc_[sol_perm_[i]];
+      }
+    }
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::permute_rhs
+  (const DenseM_t& b, DenseM_t& bp) const {
+    const std::size_t n = bp.rows(), m = bp.cols();
+    const bool scale = !rhs_scale_.empty();
+#pragma omp parallel for if(n*m > 10000)
+    for (std::size_t i=0; i<n; i++) {
+      const auto pi = rhs_perm_[i];
+      const auto si = scale ? rhs_scale_[i] : scalar_t(1.);
+      for (std::size_t c=0; c<m; c++)
+        bp(i, c) = si * b(pi, c);
+    }
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::permute_solution
+  (const DenseM_t& xp, DenseM_t& x) const {
+    const std::size_t n = xp.rows(), m = xp.cols();
+    const bool scale = !sol_scale_.empty();
+#pragma omp parallel for if(n*m > 10000)
+    for (std::size_t i=0; i<n; i++) {
+      const auto pi = sol_perm_[i];
+      const auto si = scale ? sol_scale_[i] : scalar_t(1.);
+      for (std::size_t c=0; c<m; c++)
+        x(pi, c) = si * xp(i, c);
+    }
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolver<scalar_t,integer_t>::permute_initial_guess
+  (const DenseM_t& x, DenseM_t& xp) const {
+    const std::size_t n = xp.rows(), m = xp.cols();
+    const bool scale = !sol_scale_.empty();
+#pragma omp parallel for if(n*m > 10000)
+    for (std::size_t i=0; i<n; i++) {
+      const auto pi = sol_perm_[i];
+      const auto si = scale ? scalar_t(1.) / sol_scale_[i] : scalar_t(1.);
+      for (std::size_t c=0; c<m; c++)
+        xp(i, c) = si * x(pi, c);
+    }
+  }
+
   // TODO make this const
   //  Krylov its and flops, bytes, time are modified!!
   // pass those as a pointer to a struct ??
@@ -894,113 +1625,129 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> ReturnCode
   StrumpackSparseSolver<scalar_t,integer_t>::solve
   (const DenseM_t& b, DenseM_t& x, bool use_initial_guess) {
+    // solves from different threads share the workspace, and can
+    // trigger the factorization, so they are done one at a time
+    std::lock_guard<std::mutex> lock(solve_mtx_);
     if (!this->factored_ &&
         opts_.Krylov_solver() != KrylovSolver::GMRES &&
         opts_.Krylov_solver() != KrylovSolver::BICGSTAB) {
       ReturnCode ierr = factor();
       if (ierr != ReturnCode::SUCCESS) return ierr;
     }
+    // the unpreconditioned solvers do not need the factorization,
+    // but the solve plan is set up by reorder
+    if (!reordered_) {
+      ReturnCode ierr = reorder();
+      if (ierr != ReturnCode::SUCCESS) return ierr;
+    }
     TaskTimer t("solve");
     perf_counters_start();
+    memory_phase_start();
+    trace_start();
+    TraceSpan trace("solve");
     t.start();
 
-    integer_t N = matrix()->size();
-    assert(N < std::numeric_limits<int>::max());
-    std::vector<int> intIP(N);
-    for (integer_t i=0; i<N; i++)
-      intIP[i] = reordering()->iperm()[i] + 1;
-    std::vector<int> int_matching_cperm;
-    if (opts_.matching() != MatchingJob::NONE) {
-      int_matching_cperm.resize(N);
-      for (integer_t i=0; i<N; i++)
-        int_matching_cperm[i] = matching_cperm_[i] + 1;
+    // permuted and scaled right-hand side and solution, in the
+    // ordering of the factors, the workspace is kept between solves
+    const std::size_t N = matrix()->size(), nrhs = b.cols();
+    if (solve_b_.rows() != N || solve_b_.cols() != nrhs) {
+      solve_b_ = DenseM_t(N, nrhs);
+      solve_x_ = DenseM_t(N, nrhs);
     }
-
-    auto bloc = b;
-    if (opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
-      bloc.scale_rows(matching_Dr_);
-    bloc.lapmr(intIP, true);
-
+    auto& bloc = solve_b_;
+    auto& xloc = solve_x_;
+    permute_rhs(b, bloc);
     if (use_initial_guess &&
-        opts_.Krylov_solver() != KrylovSolver::DIRECT) {
-      if (opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
-        x.div_rows(matching_Dc_);
-      if (opts_.matching() != MatchingJob::NONE)
-        x.lapmr(int_matching_cperm, true);
-      x.lapmr(intIP, true);
-    }
+        opts_.Krylov_solver() != KrylovSolver::DIRECT)
+      permute_initial_guess(x, xloc);
 
     Krylov_its_ = 0;
 
     auto spmv = [&](const scalar_t* x, scalar_t* y) {
       matrix()->spmv(x, y);
     };
-
-    auto gmres_solve = [&](const std::function<void(scalar_t*)>& prec) {
-      GMRes<scalar_t>
-      (spmv, prec, x.rows(), x.data(), bloc.data(),
-       opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
-       opts_.gmres_restart(), opts_.GramSchmidt_type(),
-       use_initial_guess, opts_.verbose() && is_root_);
+    auto block_spmv = [&](const DenseM_t& x, DenseM_t& y) {
+      matrix()->spmv(x, y);
     };
-    auto bicgstab_solve = [&](const std::function<void(scalar_t*)>& prec) {
-      BiCGStab<scalar_t>
-      (spmv, prec, x.rows(), x.data(), bloc.data(),
-       opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
-       use_initial_guess, opts_.verbose() && is_root_);
+    std::function<void(scalar_t*)> MFsolve = [&](scalar_t* w) {
+      DenseMW_t X(xloc.rows(), 1, w, xloc.ld());
+      multifrontal_solve(X);
+    }, no_prec = [](scalar_t*) {};
+    std::function<void(DenseM_t&)> block_MFsolve =
+      [&](DenseM_t& w) { multifrontal_solve(w); },
+      block_no_prec = [](DenseM_t&) {};
+
+    // with multiple right-hand sides, the Krylov iterations are done
+    // in lockstep, and the preconditioner is applied to a block
+    auto gmres_solve = [&](bool prec) {
+      if (nrhs == 1)
+        GMRes<scalar_t>
+          (spmv, prec ? MFsolve : no_prec, N, xloc.data(), bloc.data(),
+           opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
+           opts_.gmres_restart(), opts_.GramSchmidt_type(),
+           use_initial_guess, opts_.verbose() && is_root_);
+      else
+        BlockGMRes<scalar_t>
+          (block_spmv, prec ? block_MFsolve : block_no_prec, xloc, bloc,
+           opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
+           opts_.gmres_restart(), opts_.GramSchmidt_type(),
+           use_initial_guess, opts_.verbose() && is_root_);
     };
-    auto MFsolve = [&](scalar_t* w) {
-      DenseMW_t X(x.rows(), 1, w, x.ld());
-      tree()->multifrontal_solve(X);
+    auto bicgstab_solve = [&](bool prec) {
+      if (nrhs == 1)
+        BiCGStab<scalar_t>
+          (spmv, prec ? MFsolve : no_prec, N, xloc.data(), bloc.data(),
+           opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
+           use_initial_guess, opts_.verbose() && is_root_);
+      else
+        BlockBiCGStab<scalar_t>
+          (block_spmv, prec ? block_MFsolve : block_no_prec, xloc, bloc,
+           opts_.rel_tol(), opts_.abs_tol(), Krylov_its_, opts_.maxit(),
+           use_initial_guess, opts_.verbose() && is_root_);
     };
     auto refine = [&]() {
       IterativeRefinement<scalar_t,integer_t>
-      (*matrix(), [&](DenseM_t& w) { tree()->multifrontal_solve(w); },
-       x, bloc, opts_.rel_tol(), opts_.abs_tol(),
+      (*matrix(), [&](DenseM_t& w) { multifrontal_solve(w); },
+       xloc, bloc, opts_.rel_tol(), opts_.abs_tol(),
        Krylov_its_, opts_.maxit(), use_initial_guess,
        opts_.verbose() && is_root_);
     };
 
     switch (opts_.Krylov_solver()) {
     case KrylovSolver::AUTO: {
-      if ((opts_.use_HSS() || opts_.use_BLR()) && x.cols() == 1)
-        gmres_solve(MFsolve);
+      if (opts_.use_HSS() || opts_.use_BLR()) gmres_solve(true);
       else refine();
     }; break;
     case KrylovSolver::DIRECT: {
-      x = bloc;
-      tree()->multifrontal_solve(x);
+      // solve in place, no need for the copy to xloc
+      multifrontal_solve(bloc);
     }; break;
     case KrylovSolver::REFINE: {
       refine();
     }; break;
     case KrylovSolver::PREC_GMRES: {
-      assert(x.cols() == 1);
-      gmres_solve(MFsolve);
+      gmres_solve(true);
     }; break;
     case KrylovSolver::GMRES: {
-      assert(x.cols() == 1);
-      gmres_solve([](scalar_t* x){});
+      gmres_solve(false);
     }; break;
     case KrylovSolver::PREC_BICGSTAB: {
-      assert(x.cols() == 1);
-      bicgstab_solve(MFsolve);
+      bicgstab_solve(true);
     }; break;
     case KrylovSolver::BICGSTAB: {
-      assert(x.cols() == 1);
-      bicgstab_solve([](scalar_t* x){});
+      bicgstab_solve(false);
     }; break;
     }
 
-    x.lapmr(intIP, false);
-    if (opts_.matching() != MatchingJob::NONE)
-      x.lapmr(int_matching_cperm, false);
-    if (opts_.matching() == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING)
-      x.scale_rows(matching_Dc_);
+    permute_solution
+      (opts_.Krylov_solver() == KrylovSolver::DIRECT ? bloc : xloc, x);
 
     t.stop();
+    trace.stop();
     perf_counters_stop("DIRECT/GMRES solve");
+    memory_phase_stop(SolverPhase::SOLVE);
     print_solve_stats(t);
+    trace_write();
     return ReturnCode::SUCCESS;
   }
 
@@ -33,6 +33,7 @@
 #ifndef STRUMPACK_SPARSE_SOLVER_MPI_H
 #define STRUMPACK_SPARSE_SOLVER_MPI_H
 
+#include <fstream>
 #include "StrumpackSparseSolver.hpp"
 #include "sparse/EliminationTreeMPI.hpp"
 #include "sparse/MatrixReorderingMPI.hpp"
@@ -154,7 +155,7 @@ namespace strumpack {
      * Return the MPI_Comm object associated with this solver.
      * \return MPI_Comm object for this solver.
      */
-    MPI_Comm comm() const { return comm_; }
+    MPI_Comm comm() const { return comm_.comm(); }
 
   protected:
     using StrumpackSparseSolver<scalar_t,integer_t>::is_root_;
@@ -174,6 +175,8 @@ namespace strumpack {
     (int nx, int ny, int nz, int components, int width) override;
     virtual void compute_separator_reordering() override;
     void perf_counters_stop(const std::string& s) override;
+    void print_peak_memory(SolverPhase p) const override;
+    void trace_write() const override;
     virtual void synchronize() override { comm_.barrier(); }
     virtual void flop_breakdown() const override;
 
@@ -287,6 +290,38 @@ namespace strumpack {
     }
   }
 
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolverMPI<scalar_t,integer_t>::print_peak_memory
+  (SolverPhase p) const {
+#if defined(STRUMPACK_COUNT_MEMORY)
+    long long int m = this->peak_memory(p);
+    auto mtot = comm_.all_reduce(m, MPI_SUM);
+    auto mmin = comm_.all_reduce(m, MPI_MIN);
+    auto mmax = comm_.all_reduce(m, MPI_MAX);
+    if (is_root_)
+      std::cout << "#   - peak memory = " << mtot / 1e6
+                << " MB, min = " << mmin / 1e6
+                << " MB, max = " << mmax / 1e6 << " MB" << std::endl;
+#endif
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolverMPI<scalar_t,integer_t>::trace_write() const {
+    if (opts_.trace_file().empty()) return;
+    // the ranks take turns appending their events to the same file
+    int P = comm_.size(), rank = comm_.rank();
+    for (int p=0; p<P; p++) {
+      if (p == rank) {
+        std::ofstream f(opts_.trace_file(), p ? std::ofstream::app :
+                        std::ofstream::out);
+        if (p == 0) f << "[\n";
+        Tracer::write_chrome_trace(f, rank, p == 0);
+        if (p == P-1) f << "\n]\n";
+      }
+      comm_.barrier();
+    }
+  }
+
   template<typename scalar_t,typename integer_t> void
   StrumpackSparseSolverMPI<scalar_t,integer_t>::flop_breakdown() const {
 #if defined(STRUMPACK_COUNT_FLOPS)
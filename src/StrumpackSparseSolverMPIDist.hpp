@@ -190,6 +190,48 @@ namespace strumpack {
      const integer_t* col_ind, const scalar_t* values,
      const integer_t* dist, bool symmetric_pattern=false);
 
+    /**
+     * Update the values of the matrix, keeping the sparsity
+     * pattern. This method overwrites the corresponding routine from
+     * the base class StrumpackSparseSolver. __Only the matrix
+     * provided by the root process (in comm()) will be
+     * referenced.__ This routine is collective on the MPI
+     * communicator from this solver.
+     *
+     * \param A input sparse matrix, should only be provided on the
+     * root process.
+     * \see set_matrix, StrumpackSparseSolver::update_matrix_values
+     */
+    void update_matrix_values(const CSRMatrix<scalar_t,integer_t>& A) override;
+
+    /**
+     * Update the values of the (distributed) matrix, keeping the
+     * sparsity pattern and the distribution. When the solver was
+     * already reordered, the matching, nested dissection, the
+     * proportional mapping and the symbolic factorization are reused,
+     * and the new values are redistributed to the fronts. Otherwise,
+     * or if the sparsity pattern changed, this behaves as set_matrix.
+     * This routine is collective on the MPI communicator associated
+     * with the solver.
+     *
+     * \param A input sparse matrix, should be provided on all ranks.
+     * \see set_matrix, StrumpackSparseSolver::update_matrix_values
+     */
+    virtual void update_matrix_values
+    (const CSRMatrixMPI<scalar_t,integer_t>& A);
+
+    /**
+     * Update the values of a block-row distributed CSR matrix
+     * previously set with set_distributed_csr_matrix. The sparsity
+     * pattern and distribution should not change.
+     *
+     * \see set_distributed_csr_matrix, update_matrix_values
+     */
+    void update_distributed_csr_matrix_values
+    (integer_t local_rows, const integer_t* row_ptr,
+     const integer_t* col_ind, const scalar_t* values,
+     const integer_t* dist, bool symmetric_pattern=false);
+
     /**
      * Associate a (PETSc) MPIAIJ block-row distributed CSR matrix
      * with the solver object. See the PETSc manual for a description
@@ -256,6 +298,26 @@ namespace strumpack {
     ReturnCode solve
     (const DenseM_t& b, DenseM_t& x, bool use_initial_guess=false);
 
+    /**
+     * The sparse solve and selected inversion are not supported
+     * (yet) for the distributed memory solver.
+     */
+    ReturnCode sparse_solve
+    (integer_t /*nrhs*/, const integer_t* /*b_ptr*/,
+     const integer_t* /*b_ind*/, const scalar_t* /*b_val*/,
+     scalar_t* /*x*/, integer_t /*ldx*/, integer_t /*nsol*/=0,
+     const integer_t* /*sol*/=nullptr) override {
+      return ReturnCode::NOT_SUPPORTED;
+    }
+    ReturnCode inverse_diagonal(scalar_t* /*d*/) override {
+      return ReturnCode::NOT_SUPPORTED;
+    }
+    ReturnCode inverse_on_pattern
+    (const integer_t* /*row_ptr*/, const integer_t* /*col_ind*/,
+     scalar_t* /*values*/) override {
+      return ReturnCode::NOT_SUPPORTED;
+    }
+
   protected:
     using StrumpackSparseSolverMPI<scalar_t,integer_t>::is_root_;
     using StrumpackSparseSolverMPI<scalar_t,integer_t>::opts_;
@@ -267,12 +329,17 @@ namespace strumpack {
     virtual const SpMat_t* matrix() const override { return mat_mpi_.get(); }
     virtual const Reord_t* reordering() const override { return nd_mpi_.get(); }
     virtual const Tree_t* tree() const override { return tree_mpi_dist_.get(); }
+    virtual integer_t local_rhs_rows() const override
+    { return mat_mpi_->local_rows(); }
 
     virtual void setup_tree() override;
     virtual void setup_reordering() override;
     virtual int compute_reordering
     (int nx, int ny, int nz, int components, int width) override;
     virtual void compute_separator_reordering() override;
+    // the right-hand side and solution are permuted with the
+    // distributed matrix in solve
+    virtual void setup_solve_plan() override {}
 
   private:
     std::unique_ptr<CSRMatrixMPI<scalar_t,integer_t>> mat_mpi_;
@@ -334,6 +401,71 @@ namespace strumpack {
     this->factored_ = this->reordered_ = false;
   }
 
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolverMPIDist<scalar_t,integer_t>::update_matrix_values
+  (const CSRMatrix<scalar_t,integer_t>& A) {
+    update_matrix_values
+      (CSRMatrixMPI<scalar_t,integer_t>(&A, comm_.comm(), true));
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolverMPIDist<scalar_t,integer_t>::update_matrix_values
+  (const CSRMatrixMPI<scalar_t,integer_t>& A) {
+    if (!this->reordered_ || A.size() != mat_mpi_->size() ||
+        A.dist() != mat_mpi_->dist()) {
+      set_matrix(A);
+      return;
+    }
+    CSRMatrixMPI<scalar_t,integer_t> Anew(A);
+    auto job = opts_.matching();
+    if (job != MatchingJob::NONE && job != MatchingJob::COMBBLAS) {
+      if (job == MatchingJob::MAX_DIAGONAL_PRODUCT_SCALING) {
+        // matching_Dc_ is local, apply_scaling needs the global Dc
+        auto P = comm_.size();
+        std::vector<int> rcnts(P), displs(P);
+        for (int p=0; p<P; p++) {
+          rcnts[p] = Anew.dist()[p+1] - Anew.dist()[p];
+          displs[p] = Anew.dist()[p];
+        }
+        std::vector<scalar_t> Dc_global(Anew.size());
+        MPI_Allgatherv
+          (this->matching_Dc_.data(), Anew.local_rows(),
+           mpi_type<scalar_t>(), Dc_global.data(), rcnts.data(),
+           displs.data(), mpi_type<scalar_t>(), comm_.comm());
+        Anew.apply_scaling(this->matching_Dr_, Dc_global);
+      }
+      Anew.apply_column_permutation(this->matching_cperm_);
+      Anew.set_symm_sparse(false);
+    }
+    Anew.symmetrize_sparsity();
+    int same = Anew.local_nnz() == mat_mpi_->local_nnz() &&
+      std::equal(Anew.ptr(), Anew.ptr()+Anew.local_rows()+1,
+                 mat_mpi_->ptr()) &&
+      std::equal(Anew.ind(), Anew.ind()+Anew.local_nnz(),
+                 mat_mpi_->ind());
+    if (!comm_.all_reduce(same, MPI_MIN)) {
+      if (opts_.verbose() && is_root_)
+        std::cout << "# WARNING: sparsity pattern has changed,"
+                  << " the matrix will be reordered again" << std::endl;
+      set_matrix(A);
+      return;
+    }
+    std::copy(Anew.val(), Anew.val()+Anew.local_nnz(), mat_mpi_->val());
+    tree_mpi_dist_->update_values(opts_, *mat_mpi_);
+    this->factored_ = false;
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  StrumpackSparseSolverMPIDist<scalar_t,integer_t>::
+  update_distributed_csr_matrix_values
+  (integer_t local_rows, const integer_t* row_ptr, const integer_t* col_ind,
+   const scalar_t* values, const integer_t* dist, bool symmetric_pattern) {
+    update_matrix_values
+      (CSRMatrixMPI<scalar_t,integer_t>
+       (local_rows, row_ptr, col_ind, values, dist,
+        comm_.comm(), symmetric_pattern));
+  }
+
   template<typename scalar_t,typename integer_t> void
   StrumpackSparseSolverMPIDist<scalar_t,integer_t>::set_MPIAIJ_matrix
   (integer_t local_rows, const integer_t* d_ptr, const integer_t* d_ind,
@@ -390,6 +522,9 @@ namespace strumpack {
     assert(b.cols() == x.cols());
     TaskTimer t("solve");
     this->perf_counters_start();
+    this->memory_phase_start();
+    this->trace_start();
+    TraceSpan trace("solve");
     t.start();
     auto n_local = x.rows();
     this->Krylov_its_ = 0;
@@ -401,25 +536,46 @@ namespace strumpack {
     auto spmv = [&](const scalar_t* x, scalar_t* y) {
       mat_mpi_->spmv(x, y);
     };
-
-    auto gmres = [&](const std::function<void(scalar_t*)>& prec) {
-      GMResMPI<scalar_t>
-      (comm_, spmv, prec, n_local, x.data(), bloc.data(),
-       opts_.rel_tol(), opts_.abs_tol(),
-       this->Krylov_its_, opts_.maxit(),
-       opts_.gmres_restart(), opts_.GramSchmidt_type(),
-       use_initial_guess, opts_.verbose() && is_root_);
-    };
-    auto bicgstab = [&](const std::function<void(scalar_t*)>& prec) {
-      BiCGStabMPI<scalar_t>
-      (comm_, spmv, prec, n_local, x.data(), bloc.data(),
-       opts_.rel_tol(), opts_.abs_tol(),
-       this->Krylov_its_, opts_.maxit(),
-       use_initial_guess, opts_.verbose() && is_root_);
+    auto block_spmv = [&](const DenseM_t& x, DenseM_t& y) {
+      mat_mpi_->spmv(x, y);
     };
-    auto MFsolve = [&](scalar_t* w) {
-      DenseMW_t X(n_local, x.cols(), w, x.ld());
+    std::function<void(scalar_t*)> MFsolve = [&](scalar_t* w) {
+      DenseMW_t X(n_local, 1, w, x.ld());
       tree()->multifrontal_solve_dist(X, mat_mpi_->dist());
+    }, no_prec = [](scalar_t*) {};
+    std::function<void(DenseM_t&)> block_MFsolve = [&](DenseM_t& w) {
+      tree()->multifrontal_solve_dist(w, mat_mpi_->dist());
+    }, block_no_prec = [](DenseM_t&) {};
+
+    auto gmres = [&](bool prec) {
+      if (x.cols() == 1)
+        GMResMPI<scalar_t>
+          (comm_, spmv, prec ? MFsolve : no_prec, n_local, x.data(),
+           bloc.data(), opts_.rel_tol(), opts_.abs_tol(),
+           this->Krylov_its_, opts_.maxit(),
+           opts_.gmres_restart(), opts_.GramSchmidt_type(),
+           use_initial_guess, opts_.verbose() && is_root_);
+      else
+        BlockGMResMPI<scalar_t>
+          (comm_, block_spmv, prec ? block_MFsolve : block_no_prec,
+           x, bloc, opts_.rel_tol(), opts_.abs_tol(),
+           this->Krylov_its_, opts_.maxit(),
+           opts_.gmres_restart(), opts_.GramSchmidt_type(),
+           use_initial_guess, opts_.verbose() && is_root_);
+    };
+    auto bicgstab = [&](bool prec) {
+      if (x.cols() == 1)
+        BiCGStabMPI<scalar_t>
+          (comm_, spmv, prec ? MFsolve : no_prec, n_local, x.data(),
+           bloc.data(), opts_.rel_tol(), opts_.abs_tol(),
+           this->Krylov_its_, opts_.maxit(),
+           use_initial_guess, opts_.verbose() && is_root_);
+      else
+        BlockBiCGStabMPI<scalar_t>
+          (comm_, block_spmv, prec ? block_MFsolve : block_no_prec,
+           x, bloc, opts_.rel_tol(), opts_.abs_tol(),
+           this->Krylov_its_, opts_.maxit(),
+           use_initial_guess, opts_.verbose() && is_root_);
     };
     auto refine = [&]() {
       IterativeRefinementMPI<scalar_t,integer_t>
@@ -432,28 +588,23 @@ namespace strumpack {
 
     switch (opts_.Krylov_solver()) {
     case KrylovSolver::AUTO: {
-      if ((opts_.use_HSS() || opts_.use_BLR()) && x.cols() == 1)
-        gmres(MFsolve);
+      if (opts_.use_HSS() || opts_.use_BLR()) gmres(true);
       else refine();
     }; break;
     case KrylovSolver::REFINE: {
       refine();
     }; break;
     case KrylovSolver::GMRES: {
-      assert(x.cols() == 1);
-      gmres([](scalar_t*){});
+      gmres(false);
     }; break;
     case KrylovSolver::PREC_GMRES: {
-      assert(x.cols() == 1);
-      gmres(MFsolve);
+      gmres(true);
     }; break;
     case KrylovSolver::BICGSTAB: {
-      assert(x.cols() == 1);
-      bicgstab([](scalar_t*){});
+      bicgstab(false);
     }; break;
     case KrylovSolver::PREC_BICGSTAB: {
-      assert(x.cols() == 1);
-      bicgstab(MFsolve);
+      bicgstab(true);
     }; break;
     case KrylovSolver::DIRECT: {
       // TODO bloc is already a copy, avoid extra copy?
@@ -471,8 +622,11 @@ namespace strumpack {
       x.scale_rows(this->matching_Dc_);
 
     t.stop();
+    trace.stop();
     this->perf_counters_stop("DIRECT/GMRES solve");
+    this->memory_phase_stop(SolverPhase::SOLVE);
     this->print_solve_stats(t);
+    this->trace_write();
     return ReturnCode::SUCCESS;
   }
 
@@ -55,6 +55,16 @@ namespace strumpack {
     typedef T value_type;
   };
 
+  template<class T> struct SinglePrecisionType {
+    typedef T value_type;
+  };
+  template<> struct SinglePrecisionType<double> {
+    typedef float value_type;
+  };
+  template<> struct SinglePrecisionType<std::complex<double>> {
+    typedef std::complex<float> value_type;
+  };
+
   namespace blas {
 
     inline float my_conj(float a) { return a; }
@@ -45,6 +45,7 @@
 
 #include "misc/RandomWrapper.hpp"
 #include "misc/TaskTimer.hpp"
+#include "misc/MemoryCounter.hpp"
 #include "BLASLAPACKWrapper.hpp"
 #include "BLASLAPACKOpenMPTask.hpp"
 
@@ -299,15 +300,18 @@ namespace strumpack {
     (std::string name, std::string filename, int width=8) const;
 
     /**
-     * Fill the matrix with random numbers, using random number
-     * generator/distribution
-     * random::make_default_random_generator<real_t>()
+     * Fill the matrix with normal(0,1) random numbers, using the
+     * counter-based random::PhiloxGenerator, so the matrix is filled
+     * in parallel, and the result does not depend on the number of
+     * threads.
      */
     void random();
 
     /**
      * Fill the matrix with random numbers, using the specified random
-     * number generator.
+     * number generator. The numbers are taken from the stream of the
+     * generator in column major order. For a counter-based
+     * generator this is done in parallel.
      */
     void random
     (random::RandomGeneratorBase<typename RealType<scalar_t>::
@@ -1074,12 +1078,12 @@ namespace strumpack {
 
   template<typename scalar_t> DenseMatrix<scalar_t>::DenseMatrix
   (std::size_t m, std::size_t n)
-    : data_(new scalar_t[m*n]), rows_(m),
+    : data_(new_array<scalar_t>(m*n)), rows_(m),
       cols_(n), ld_(std::max(std::size_t(1), m)) { }
 
   template<typename scalar_t> DenseMatrix<scalar_t>::DenseMatrix
   (std::size_t m, std::size_t n, const scalar_t* D, std::size_t ld)
-    : data_(new scalar_t[m*n]), rows_(m), cols_(n),
+    : data_(new_array<scalar_t>(m*n)), rows_(m), cols_(n),
       ld_(std::max(std::size_t(1), m)) {
     assert(ld >= m);
     for (std::size_t j=0; j<cols_; j++)
@@ -1090,7 +1094,7 @@ namespace strumpack {
   template<typename scalar_t> DenseMatrix<scalar_t>::DenseMatrix
   (std::size_t m, std::size_t n, const DenseMatrix<scalar_t>& D,
    std::size_t i, std::size_t j)
-    : data_(new scalar_t[m*n]), rows_(m), cols_(n),
+    : data_(new_array<scalar_t>(m*n)), rows_(m), cols_(n),
       ld_(std::max(std::size_t(1), m)) {
     for (std::size_t _j=0; _j<std::min(cols_, D.cols()-j); _j++)
       for (std::size_t _i=0; _i<std::min(rows_, D.rows()-i); _i++)
@@ -1099,7 +1103,7 @@ namespace strumpack {
 
   template<typename scalar_t>
   DenseMatrix<scalar_t>::DenseMatrix(const DenseMatrix<scalar_t>& D)
-    : data_(new scalar_t[D.rows()*D.cols()]), rows_(D.rows()),
+    : data_(new_array<scalar_t>(D.rows()*D.cols())), rows_(D.rows()),
       cols_(D.cols()), ld_(std::max(std::size_t(1), D.rows())) {
     for (std::size_t j=0; j<cols_; j++)
       for (std::size_t i=0; i<rows_; i++)
@@ -1116,7 +1120,7 @@ namespace strumpack {
   }
 
   template<typename scalar_t> DenseMatrix<scalar_t>::~DenseMatrix() {
-    delete[] data_;
+    delete_array(data_);
   }
 
   template<typename scalar_t> DenseMatrix<scalar_t>&
@@ -1125,8 +1129,8 @@ namespace strumpack {
     if (rows_ != D.rows() || cols_ != D.cols()) {
       rows_ = D.rows();
       cols_ = D.cols();
-      delete[] data_;
-      data_ = new scalar_t[rows_*cols_];
+      delete_array(data_);
+      data_ = new_array<scalar_t>(rows_*cols_);
       ld_ = std::max(std::size_t(1), rows_);
     }
     for (std::size_t j=0; j<cols_; j++)
@@ -1140,7 +1144,7 @@ namespace strumpack {
     rows_ = D.rows();
     cols_ = D.cols();
     ld_ = D.ld();
-    delete[] data_;
+    delete_array(data_);
     data_ = D.data();
     D.data_ = nullptr;
     return *this;
@@ -1179,19 +1183,30 @@ namespace strumpack {
   (random::RandomGeneratorBase<typename RealType<scalar_t>::
    value_type>& rgen) {
     TIMER_TIME(TaskType::RANDOM_GENERATE, 1, t_gen);
-    for (std::size_t j=0; j<cols(); j++)
-      for (std::size_t i=0; i<rows(); i++)
-        operator()(i,j) = rgen.get();
+    if (rgen.counter_based()) {
+      const std::size_t m = rows(), n = cols();
+#pragma omp parallel if(m*n > 10000)
+      {
+        // scalar_t can be complex
+        std::vector<real_t> v(m);
+#pragma omp for
+        for (std::size_t j=0; j<n; j++) {
+          rgen.get_at(j*m, m, v.data());
+          std::copy(v.begin(), v.end(), ptr(0,j));
+        }
+      }
+      rgen.discard(m*n);
+    } else {
+      for (std::size_t j=0; j<cols(); j++)
+        for (std::size_t i=0; i<rows(); i++)
+          operator()(i,j) = rgen.get();
+    }
     STRUMPACK_FLOPS(rgen.flops_per_prng()*cols()*rows());
   }
 
   template<typename scalar_t> void DenseMatrix<scalar_t>::random() {
-    TIMER_TIME(TaskType::RANDOM_GENERATE, 1, t_gen);
-    auto rgen = random::make_default_random_generator<real_t>();
-    for (std::size_t j=0; j<cols(); j++)
-      for (std::size_t i=0; i<rows(); i++)
-        operator()(i,j) = rgen->get();
-    STRUMPACK_FLOPS(rgen->flops_per_prng()*cols()*rows());
+    random::PhiloxGenerator<real_t> rgen;
+    random(rgen);
   }
 
   template<typename scalar_t> void DenseMatrix<scalar_t>::zero() {
@@ -1217,17 +1232,17 @@ namespace strumpack {
     rows_ = 0;
     cols_ = 0;
     ld_ = 1;
-    delete[] data_;
+    delete_array(data_);
     data_ = nullptr;
   }
 
   template<typename scalar_t> void
   DenseMatrix<scalar_t>::resize(std::size_t m, std::size_t n) {
-    auto tmp = new scalar_t[m*n];
+    auto tmp = new_array<scalar_t>(m*n);
     for (std::size_t j=0; j<std::min(cols(),n); j++)
       for (std::size_t i=0; i<std::min(rows(),m); i++)
         tmp[i+j*m] = operator()(i,j);
-    delete[] data_;
+    delete_array(data_);
     data_ = tmp;
     ld_ = std::max(std::size_t(1), m);
     rows_ = m;
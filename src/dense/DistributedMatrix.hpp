@@ -611,12 +611,12 @@ namespace strumpack {
       data_ = m.data_;
       m.data_ = nullptr;
     } else {
-      data_ = new scalar_t[lrows_*lcols_];
+      data_ = new_array<scalar_t>(lrows_*lcols_);
       for (int c=0; c<lcols_; c++)
         for (int r=0; r<lrows_; r++)
           operator()(r, c) = m(r, c);
     }
-    delete[] m.data_;
+    delete_array(m.data_);
     m.data_ = nullptr;
   }
 
@@ -631,7 +631,7 @@ namespace strumpack {
   (const DistributedMatrix<scalar_t>& m)
     : grid_(m.grid()), lrows_(m.lrows()), lcols_(m.lcols()) {
     std::copy(m.desc_, m.desc_+9, desc_);
-    data_ = new scalar_t[lrows_*lcols_];
+    data_ = new_array<scalar_t>(lrows_*lcols_);
     std::copy(m.data_, m.data_+lrows_*lcols_, data_);
   }
 
@@ -662,7 +662,7 @@ namespace strumpack {
     } else {
       lrows_ = scalapack::numroc(M, MB, prow(), 0, nprows());
       lcols_ = scalapack::numroc(N, NB, pcol(), 0, npcols());
-      data_ = new scalar_t[lrows_*lcols_];
+      data_ = new_array<scalar_t>(lrows_*lcols_);
       if (scalapack::descinit
           (desc_, M, N, MB, NB, 0, 0, ctxt(), std::max(lrows_,1))) {
         std::cerr << " ERROR: Could not create DistributedMatrix descriptor!"
@@ -683,7 +683,7 @@ namespace strumpack {
       lrows_ = scalapack::numroc(desc_[2], desc_[4], prow(), desc_[6], nprows());
       lcols_ = scalapack::numroc(desc_[3], desc_[5], pcol(), desc_[7], npcols());
       assert(lrows_==desc_[8]);
-      if (lrows_ && lcols_) data_ = new scalar_t[lrows_*lcols_];
+      if (lrows_ && lcols_) data_ = new_array<scalar_t>(lrows_*lcols_);
       else data_ = nullptr;
     }
   }
@@ -698,8 +698,8 @@ namespace strumpack {
   (const DistributedMatrix<scalar_t>& m) {
     if (lrows_ != m.lrows_ || lcols_ != m.lcols_) {
       lrows_ = m.lrows_;  lcols_ = m.lcols_;
-      delete[] data_;
-      data_ = new scalar_t[lrows_*lcols_];
+      delete_array(data_);
+      data_ = new_array<scalar_t>(lrows_*lcols_);
     }
     grid_ = m.grid();
     std::copy(m.data_, m.data_+lrows_*lcols_, data_);
@@ -712,7 +712,7 @@ namespace strumpack {
     grid_ = m.grid();
     lrows_ = m.lrows_;  lcols_ = m.lcols_;
     std::copy(m.desc_, m.desc_+9, desc_);
-    delete[] data_;
+    delete_array(data_);
     data_ = m.data_;
     m.data_ = nullptr;
     return *this;
@@ -726,7 +726,7 @@ namespace strumpack {
   }
 
   template<typename scalar_t> void DistributedMatrix<scalar_t>::clear() {
-    delete[] data_;
+    delete_array(data_);
     data_ = nullptr;
     lrows_ = lcols_ = 0;
     scalapack::descset(desc_, 0, 0, MB(), NB(), 0, 0, ctxt(), 1);
@@ -770,19 +770,23 @@ namespace strumpack {
         operator()(r,c) = a;
   }
 
+  /**
+   * Fill with normal(0,1) random numbers, using the counter-based
+   * random::PhiloxGenerator. The result does not depend on the
+   * process grid, and no communication is needed.
+   */
   template<typename scalar_t> void DistributedMatrix<scalar_t>::random() {
-    if (!active()) return;
-    TIMER_TIME(TaskType::RANDOM_GENERATE, 1, t_gen);
-    auto rgen = random::make_default_random_generator<real_t>();
-    rgen->seed(prow(), pcol());
-    int rlo, rhi, clo, chi;
-    lranges(rlo, rhi, clo, chi);
-    for (int c=clo; c<chi; ++c)
-      for (int r=rlo; r<rhi; ++r)
-        operator()(r,c) = rgen->get();
-    STRUMPACK_FLOPS(rgen->flops_per_prng()*(chi-clo)*(rhi-rlo));
+    random::PhiloxGenerator<real_t> rgen;
+    random(rgen);
   }
 
+  /**
+   * With a counter-based generator, element (i,j) of the global
+   * matrix gets number i+j*rows() of the stream, the same as a
+   * sequential DenseMatrix fill, and the stream is advanced by
+   * rows()*cols() on all processes. Other generators are used
+   * locally, and the result depends on the process grid.
+   */
   template<typename scalar_t> void DistributedMatrix<scalar_t>::random
   (random::RandomGeneratorBase<typename RealType<scalar_t>::
    value_type>& rgen) {
@@ -790,9 +794,31 @@ namespace strumpack {
     TIMER_TIME(TaskType::RANDOM_GENERATE, 1, t_gen);
     int rlo, rhi, clo, chi;
     lranges(rlo, rhi, clo, chi);
-    for (int c=clo; c<chi; ++c)
-      for (int r=rlo; r<rhi; ++r)
-        operator()(r,c) = rgen.get();
+    if (rgen.counter_based()) {
+      const std::uint64_t m = rows();
+#pragma omp parallel if((chi-clo)*(rhi-rlo) > 10000)
+      {
+        // scalar_t can be complex
+        std::vector<real_t> v(rhi-rlo);
+#pragma omp for
+        for (int c=clo; c<chi; ++c) {
+          const std::uint64_t gc = coll2g(c);
+          // local rows in the same row block are consecutive in the
+          // global matrix, and in the stream
+          for (int r=rlo, re; r<rhi; r=re) {
+            const std::uint64_t gr = rowl2g(r);
+            for (re=r+1; re<rhi && rowl2g(re) == int(gr)+(re-r); re++) ;
+            rgen.get_at(gr + gc*m, re-r, v.data());
+            std::copy(v.begin(), v.begin()+(re-r), &operator()(r,c));
+          }
+        }
+      }
+      rgen.discard(m*cols());
+    } else {
+      for (int c=clo; c<chi; ++c)
+        for (int r=rlo; r<rhi; ++r)
+          operator()(r,c) = rgen.get();
+    }
     STRUMPACK_FLOPS(rgen.flops_per_prng()*(chi-clo)*(rhi-rlo));
   }
 
@@ -483,6 +483,85 @@ namespace strumpack {
       delete[] sendbuf;
     }
 
+    /**
+     * Start a non-blocking, sparse all-to-all exchange, the
+     * point-to-point equivalent of all_to_all_v when the message
+     * sizes are known on the receiving side. This posts a receive
+     * for every rank i with rsizes[i] > 0 and a send of sbuf[i] for
+     * every non-empty sbuf[i], and returns immediately. No messages
+     * are exchanged with the other ranks, and there is no exchange of
+     * the message sizes. The exchange is completed with
+     * all_to_all_v_wait. sbuf and rbuf should not be modified until
+     * then.
+     *
+     * \tparam T type of data to send, this should have a
+     * corresponding mpi_type<T>() implementation
+     * \param sbuf send buffers (should be size this->size())
+     * \param rsizes number of elements to receive from each rank
+     * (should be size this->size())
+     * \param rbuf receive buffer, will be allocated
+     * \param pbuf pointers (to positions in rbuf) to where the data
+     * received from the different ranks will start
+     * \param req on output, the requests for the posted receives, in
+     * the order of the source ranks, followed by those for the sends
+     * \param tag tag to use for the messages
+     * \see all_to_all_v_wait, all_to_all_v
+     */
+    template<typename T> void all_to_all_v_post
+    (std::vector<std::vector<T>>& sbuf,
+     const std::vector<std::size_t>& rsizes, std::vector<T>& rbuf,
+     std::vector<T*>& pbuf, std::vector<MPI_Request>& req, int tag) const {
+      assert(sbuf.size() == std::size_t(size()));
+      assert(rsizes.size() == std::size_t(size()));
+      auto P = size();
+      rbuf.resize(std::accumulate(rsizes.begin(), rsizes.end(), std::size_t(0)));
+      pbuf.resize(P);
+      req.clear();
+      req.reserve(2*P);
+      std::size_t rdispl = 0;
+      for (int p=0; p<P; rdispl+=rsizes[p++]) {
+        pbuf[p] = rbuf.data() + rdispl;
+        if (!rsizes[p]) continue;
+        if (rsizes[p] > std::numeric_limits<int>::max()) {
+          std::cerr << "# ERROR: 32bit integer overflow in all_to_all_v_post!!"
+                    << std::endl;
+          MPI_Abort(comm_, 1);
+        }
+        req.emplace_back();
+        MPI_Irecv(pbuf[p], rsizes[p], mpi_type<T>(), p, tag, comm_, &req.back());
+      }
+      for (int p=0; p<P; p++) {
+        if (sbuf[p].empty()) continue;
+        if (sbuf[p].size() > std::numeric_limits<int>::max()) {
+          std::cerr << "# ERROR: 32bit integer overflow in all_to_all_v_post!!"
+                    << std::endl;
+          MPI_Abort(comm_, 1);
+        }
+        req.emplace_back();
+        MPI_Isend(sbuf[p].data(), sbuf[p].size(), mpi_type<T>(),
+                  p, tag, comm_, &req.back());
+      }
+    }
+
+    /**
+     * Complete an exchange started with all_to_all_v_post. This waits
+     * for all receives and sends to complete, and then clears the
+     * send buffers.
+     *
+     * \tparam T type of data to send, this should have a
+     * corresponding mpi_type<T>() implementation
+     * \param sbuf send buffers passed to all_to_all_v_post, will be
+     * cleared
+     * \param req requests returned by all_to_all_v_post
+     * \see all_to_all_v_post, all_to_all_v
+     */
+    template<typename T> void all_to_all_v_wait
+    (std::vector<std::vector<T>>& sbuf, std::vector<MPI_Request>& req) const {
+      MPI_Waitall(req.size(), req.data(), MPI_STATUSES_IGNORE);
+      req.clear();
+      std::vector<std::vector<T>>().swap(sbuf);
+    }
+
 
     /**
      * Return a subcommunicator with P ranks, starting from rank P0,
@@ -541,6 +620,24 @@ namespace strumpack {
       return c0;
     }
 
+    /**
+     * Split this communicator in disjoint subcommunicators, one for
+     * each value of color, see MPI_Comm_split. This is collective on
+     * the current communicator.
+     *
+     * \param color ranks with the same color end up in the same new
+     * communicator, or MPI_UNDEFINED to get an MPIComm wrapping
+     * MPI_COMM_NULL
+     * \param key determines the order of the ranks in the new
+     * communicator
+     * \return the new communicator containing this rank
+     */
+    MPIComm split(int color, int key) const {
+      MPIComm c;
+      MPI_Comm_split(comm_, color, key, &c.comm_);
+      return c;
+    }
+
     /**
      * Call MPI_Pcontrol with level 1, and string name
      */
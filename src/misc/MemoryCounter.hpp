@@ -0,0 +1,86 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+/**
+ * \file MemoryCounter.hpp
+ * \brief Allocation routines which keep track of the current and
+ * peak memory usage, see params::memory and params::peak_memory.
+ */
+#ifndef STRUMPACK_MEMORY_COUNTER_HPP
+#define STRUMPACK_MEMORY_COUNTER_HPP
+
+#include <new>
+#include <cstddef>
+#include <type_traits>
+#include "StrumpackConfig.hpp"
+#include "StrumpackParameters.hpp"
+
+namespace strumpack {
+
+  /**
+   * Allocate an (uninitialized) array of n elements of type T, to be
+   * freed with delete_array. When STRUMPACK_COUNT_MEMORY is defined,
+   * the size of the allocation is stored in front of the array, and
+   * added to the memory counters in params. This is used for the
+   * storage of DenseMatrix and DistributedMatrix, and hence covers
+   * the frontal matrices, BLR tiles and HSS generators.
+   */
+  template<typename T> T* new_array(std::size_t n) {
+#if defined(STRUMPACK_COUNT_MEMORY)
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "new_array requires a trivially destructible type");
+    const std::size_t offset = alignof(std::max_align_t);
+    const std::size_t bytes = n * sizeof(T);
+    auto raw = static_cast<char*>(::operator new(bytes + offset));
+    *reinterpret_cast<std::size_t*>(raw) = bytes;
+    params::add_memory(bytes);
+    auto p = reinterpret_cast<T*>(raw + offset);
+    for (std::size_t i=0; i<n; i++) new (p+i) T;
+    return p;
+#else
+    return new T[n];
+#endif
+  }
+
+  /**
+   * Free an array allocated with new_array, p can be null.
+   */
+  template<typename T> void delete_array(T* p) {
+#if defined(STRUMPACK_COUNT_MEMORY)
+    if (!p) return;
+    auto raw = reinterpret_cast<char*>(p) - alignof(std::max_align_t);
+    params::memory -= *reinterpret_cast<std::size_t*>(raw);
+    ::operator delete(raw);
+#else
+    delete[] p;
+#endif
+  }
+
+} // end namespace strumpack
+
+#endif // STRUMPACK_MEMORY_COUNTER_HPP
@@ -35,6 +35,11 @@
 
 #include <memory>
 #include <random>
+#include <array>
+#include <cmath>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
 
 namespace strumpack {
 
@@ -50,7 +55,9 @@ namespace strumpack {
      */
     enum class RandomEngine {
       LINEAR,   /*!< The C++11 std::minstd_rand random number generator. */
-      MERSENNE  /*!< The C++11 std::mt19937 random number generator.     */
+      MERSENNE, /*!< The C++11 std::mt19937 random number generator.     */
+      PHILOX    /*!< Counter-based Philox4x32-10 generator, every number
+                  of the stream can be computed independently.      */
     };
 
     /**
@@ -62,6 +69,7 @@ namespace strumpack {
       switch (e) {
       case RandomEngine::LINEAR: return "minstd_rand"; break;
       case RandomEngine::MERSENNE: return "mt19937"; break;
+      case RandomEngine::PHILOX: return "philox4x32-10"; break;
       }
       return "unknown";
     }
@@ -109,6 +117,34 @@ namespace strumpack {
       virtual real_t get() = 0;
       virtual real_t get(std::uint32_t i, std::uint32_t j) = 0;
       virtual int flops_per_prng() = 0;
+
+      /**
+       * Whether this is a counter-based generator, for which
+       * get_at(k) can be used, from multiple threads, to get the k-th
+       * next number of the stream without advancing the stream.
+       */
+      virtual bool counter_based() const { return false; }
+      /**
+       * The k-th next number, get_at(0) is what get() would return.
+       * Only for counter_based() generators.
+       */
+      virtual real_t get_at(std::uint64_t /*k*/) const {
+        assert(false);
+        return real_t(0.);
+      }
+      /**
+       * Write the k-th, ..., (k+n-1)-th next numbers to x. Only for
+       * counter_based() generators.
+       */
+      virtual void get_at(std::uint64_t k, std::size_t n, real_t* x) const {
+        for (std::size_t i=0; i<n; i++) x[i] = get_at(k+i);
+      }
+      /**
+       * Advance the stream by k numbers.
+       */
+      virtual void discard(std::uint64_t k) {
+        for (std::uint64_t i=0; i<k; i++) get();
+      }
     };
 
     /**
@@ -188,6 +224,146 @@ namespace strumpack {
       D d;
     };
 
+    /**
+     * \class PhiloxGenerator
+     * \brief Counter-based random number generator
+     *
+     * The Philox4x32-10 generator of Salmon et al., "Parallel random
+     * numbers: as easy as 1, 2, 3" (SC11). The k-th number of a
+     * stream is a function of the key (the seed) and the counter k
+     * only, so any block of a random matrix can be filled
+     * independently, by any number of threads or processes, with the
+     * same result as a sequential fill.
+     *
+     * Every counter gives 4 random 32 bit words, which are all used:
+     * 2 doubles or 4 floats per counter, for both the uniform and the
+     * normal distribution (Box-Muller gives 2 normal numbers per 2
+     * uniform numbers).
+     *
+     * \tparam real_t float or double
+     */
+    template<typename real_t>
+    class PhiloxGenerator : public RandomGeneratorBase<real_t> {
+    public:
+      /** Random numbers generated from a single counter. */
+      static const int per_counter =
+        std::is_same<real_t,float>::value ? 4 : 2;
+
+      PhiloxGenerator
+      (std::size_t s=0, RandomDistribution d=RandomDistribution::NORMAL)
+        : d_(d) { seed(s); }
+
+      void seed(std::size_t s) override {
+        key_ = {{std::uint32_t(s), std::uint32_t(std::uint64_t(s) >> 32)}};
+        reset();
+      }
+      void seed(std::seed_seq& s) override {
+        s.generate(key_.begin(), key_.end());
+        reset();
+      }
+      /**
+       * Use the stream with key (i,j), for instance a point in a
+       * matrix.
+       */
+      void seed(std::uint32_t i, std::uint32_t j) override {
+        key_ = {{i, j}};
+        reset();
+      }
+      real_t get() override {
+        const auto c = pos_ / per_counter;
+        if (c != cached_) {
+          numbers(c, cache_.data());
+          cached_ = c;
+        }
+        return cache_[pos_++ % per_counter];
+      }
+      real_t get(std::uint32_t i, std::uint32_t j) override {
+        seed(i, j);
+        return get();
+      }
+      int flops_per_prng() override {
+        return (d_ == RandomDistribution::NORMAL) ? 23 : 7;
+      }
+
+      bool counter_based() const override { return true; }
+      real_t get_at(std::uint64_t k) const override {
+        std::array<real_t,per_counter> v;
+        numbers((pos_ + k) / per_counter, v.data());
+        return v[(pos_ + k) % per_counter];
+      }
+      /**
+       * Write the k-th, ..., (k+n-1)-th next numbers of the stream to
+       * x, without advancing the stream. Each counter is evaluated
+       * only once.
+       */
+      void get_at
+      (std::uint64_t k, std::size_t n, real_t* x) const override {
+        std::array<real_t,per_counter> v;
+        for (auto p=pos_+k; n; ) {
+          numbers(p / per_counter, v.data());
+          for (int j=p%per_counter; j<per_counter && n; j++, n--, p++)
+            *x++ = v[j];
+        }
+      }
+      void discard(std::uint64_t k) override { pos_ += k; }
+
+      /**
+       * The Philox4x32-10 bijection of counter x with key k.
+       */
+      static std::array<std::uint32_t,4> philox
+      (std::array<std::uint32_t,4> x, std::array<std::uint32_t,2> k) {
+        for (int r=0; r<10; r++) {
+          if (r) { k[0] += 0x9E3779B9; k[1] += 0xBB67AE85; }
+          std::uint64_t p0 = std::uint64_t(0xD2511F53) * x[0];
+          std::uint64_t p1 = std::uint64_t(0xCD9E8D57) * x[2];
+          x = {{std::uint32_t(p1 >> 32) ^ x[1] ^ k[0], std::uint32_t(p1),
+                std::uint32_t(p0 >> 32) ^ x[3] ^ k[1], std::uint32_t(p0)}};
+        }
+        return x;
+      }
+
+    private:
+      RandomDistribution d_;
+      std::array<std::uint32_t,2> key_;
+      std::uint64_t pos_ = 0;
+      // the numbers of counter cached_, for get()
+      std::uint64_t cached_;
+      std::array<real_t,per_counter> cache_;
+
+      void reset() {
+        pos_ = 0;
+        cached_ = std::uint64_t(-1);
+      }
+      // uniform in [0,1), from 1 word for float, 2 words for double,
+      // with all the bits of the mantissa random
+      static real_t uniform(const std::uint32_t* w) {
+        if (std::is_same<real_t,float>::value)
+          return real_t((w[0] >> 8) * (1.f / 16777216.f));
+        return real_t(((std::uint64_t(w[0]) << 21) ^ (w[1] >> 11)) *
+                      (1. / 9007199254740992.));
+      }
+      // the per_counter numbers of counter c
+      void numbers(std::uint64_t c, real_t* v) const {
+        const auto x = philox
+          ({{std::uint32_t(c), std::uint32_t(c >> 32), 0, 0}}, key_);
+        const int w = 4 / per_counter;
+        if (d_ == RandomDistribution::UNIFORM) {
+          for (int i=0; i<per_counter; i++)
+            v[i] = uniform(x.data()+i*w);
+          return;
+        }
+        // Box-Muller, with u1 in (0,1]
+        const real_t twopi = real_t(6.283185307179586476925286766559);
+        for (int i=0; i<per_counter; i+=2) {
+          real_t u1 = real_t(1.) - uniform(x.data()+i*w);
+          real_t u2 = uniform(x.data()+(i+1)*w);
+          real_t r = std::sqrt(real_t(-2.) * std::log(u1));
+          v[i] = r * std::cos(twopi * u2);
+          v[i+1] = r * std::sin(twopi * u2);
+        }
+      }
+    };
+
     /**
      * Factory method to construct a RandomGeneratorBase with a
      * specified random engine and random distribution, with seed s.
@@ -219,7 +395,9 @@ namespace strumpack {
           return std::unique_ptr<RandomGeneratorBase<real_t>>
             (new RandomGenerator<real_t,std::mt19937,
              std::uniform_real_distribution<real_t>>(seed));
-      }
+      } else if (e == RandomEngine::PHILOX)
+        return std::unique_ptr<RandomGeneratorBase<real_t>>
+          (new PhiloxGenerator<real_t>(seed, d));
       return NULL;
     }
 
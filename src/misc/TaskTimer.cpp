@@ -30,6 +30,7 @@
 #include <iomanip>
 #include <fstream>
 #include <cassert>
+#include <algorithm>
 #if defined(_OPENMP)
 #include <omp.h>
 #endif
@@ -105,55 +106,52 @@ double TaskTimer::elapsed() {
 #endif
 }
 
-void TaskTimer::print_name(std::ostream& os) {
-  if (type == TaskType::EXPLICITLY_NAMED_TASK) {
-    os << t_name;
-  } else {
-    switch (type) {
-    case TaskType::RANDOM_SAMPLING:       os << "RANDOM_SAMPLING"; break;
-    case TaskType::RANDOM_GENERATE:       os << "RANDOM_GENERATE"; break;
-    case TaskType::FRONT_MULTIPLY_2D:     os << "FRONT_MULTIPLY_2D"; break;
-    case TaskType::UUTXR:                 os << "UUTXR"; break;
-    case TaskType::HSS_SCHUR_PRODUCT:
-      os << "HSS_SCHUR_PRODUCT"; break;
-    case TaskType::SKINNY_EXTEND_ADD_SEQSEQ:
-      os << "SKINNY_EXTEND_ADD_SEQSEQ"; break;
-    case TaskType::SKINNY_EXTEND_ADD_SEQ1:
-      os << "SKINNY_EXTEND_ADD_SEQ1"; break;
-    case TaskType::SKINNY_EXTEND_ADD_MPIMPI:
-      os << "SKINNY_EXTEND_ADD_MPIMPI"; break;
-    case TaskType::SKINNY_EXTEND_ADD_MPI1:
-      os << "SKINNY_EXTEND_ADD_MPI1"; break;
-    case TaskType::HSS_COMPRESS:          os << "HSS_COMPRESS"; break;
-    case TaskType::HSS_PARHQRINTERPOL:    os << "HSS_PARHQRINTERPOL"; break;
-    case TaskType::HSS_SEQHQRINTERPOL:    os << "HSS_SEQHQRINTERPOL"; break;
-    case TaskType::EXTRACT_2D:            os << "EXTRACT_2D"; break;
-    case TaskType::EXTRACT_SEP_2D:        os << "EXTRACT_SEP_2D"; break;
-    case TaskType::GET_SUBMATRIX_2D:      os << "GET_SUBMATRIX_2D"; break;
-    case TaskType::HSS_EXTRACT_SCHUR:     os << "HSS_EXTRACT_SCHUR"; break;
-    case TaskType::HSS_PARTIALLY_FACTOR:  os << "HSS_PARTIALLY_FACTOR"; break;
-    case TaskType::HSS_COMPUTE_SCHUR:     os << "HSS_COMPUTE_SCHUR"; break;
-    case TaskType::HSS_FACTOR:            os << "HSS_FACTOR"; break;
-    case TaskType::FORWARD_SOLVE:         os << "FORWARD_SOLVE"; break;
-    case TaskType::LOOK_LEFT:             os << "LOOK_LEFT"; break;
-    case TaskType::SOLVE_LOWER:           os << "SOLVE_LOWER"; break;
-    case TaskType::SOLVE_LOWER_ROOT:      os << "SOLVE_LOWER_ROOT"; break;
-    case TaskType::BACKWARD_SOLVE:        os << "BACKWARD_SOLVE"; break;
-    case TaskType::SOLVE_UPPER:           os << "SOLVE_UPPER"; break;
-    case TaskType::LOOK_RIGHT:            os << "LOOK_RIGHT"; break;
-    case TaskType::DISTMAT_EXTRACT_ROWS:  os << "DISTMAT_EXTRACT_ROWS"; break;
-    case TaskType::DISTMAT_EXTRACT_COLS:  os << "DISTMAT_EXTRACT_COLS"; break;
-    case TaskType::DISTMAT_EXTRACT:       os << "DISTMAT_EXTRACT"; break;
-    case TaskType::QR:                    os << "QR"; break;
-    case TaskType::REDUCE_SAMPLES:        os << "REDUCE_SAMPLES"; break;
-    case TaskType::COMPUTE_SAMPLES:       os << "COMPUTE_SAMPLES"; break;
-    case TaskType::ORTHO:                 os << "ORTHO"; break;
-    case TaskType::REDIST_2D_TO_HSS:      os << "REDIST_2D_TO_HSS"; break;
-    default: os << "SOMEOTHERTAKSNOTNAMED";
-    }
+const char* strumpack::task_name(TaskType t) {
+  switch (t) {
+  case TaskType::RANDOM_SAMPLING:          return "RANDOM_SAMPLING";
+  case TaskType::RANDOM_GENERATE:          return "RANDOM_GENERATE";
+  case TaskType::FRONT_MULTIPLY_2D:        return "FRONT_MULTIPLY_2D";
+  case TaskType::UUTXR:                    return "UUTXR";
+  case TaskType::HSS_SCHUR_PRODUCT:        return "HSS_SCHUR_PRODUCT";
+  case TaskType::SKINNY_EXTEND_ADD_SEQSEQ: return "SKINNY_EXTEND_ADD_SEQSEQ";
+  case TaskType::SKINNY_EXTEND_ADD_SEQ1:   return "SKINNY_EXTEND_ADD_SEQ1";
+  case TaskType::SKINNY_EXTEND_ADD_MPIMPI: return "SKINNY_EXTEND_ADD_MPIMPI";
+  case TaskType::SKINNY_EXTEND_ADD_MPI1:   return "SKINNY_EXTEND_ADD_MPI1";
+  case TaskType::HSS_COMPRESS:             return "HSS_COMPRESS";
+  case TaskType::HSS_PARHQRINTERPOL:       return "HSS_PARHQRINTERPOL";
+  case TaskType::HSS_SEQHQRINTERPOL:       return "HSS_SEQHQRINTERPOL";
+  case TaskType::EXTRACT_2D:               return "EXTRACT_2D";
+  case TaskType::EXTRACT_SEP_2D:           return "EXTRACT_SEP_2D";
+  case TaskType::GET_SUBMATRIX_2D:         return "GET_SUBMATRIX_2D";
+  case TaskType::HSS_EXTRACT_SCHUR:        return "HSS_EXTRACT_SCHUR";
+  case TaskType::GET_SUBMATRIX:            return "GET_SUBMATRIX";
+  case TaskType::HSS_PARTIALLY_FACTOR:     return "HSS_PARTIALLY_FACTOR";
+  case TaskType::HSS_COMPUTE_SCHUR:        return "HSS_COMPUTE_SCHUR";
+  case TaskType::HSS_FACTOR:               return "HSS_FACTOR";
+  case TaskType::FORWARD_SOLVE:            return "FORWARD_SOLVE";
+  case TaskType::LOOK_LEFT:                return "LOOK_LEFT";
+  case TaskType::SOLVE_LOWER:              return "SOLVE_LOWER";
+  case TaskType::SOLVE_LOWER_ROOT:         return "SOLVE_LOWER_ROOT";
+  case TaskType::BACKWARD_SOLVE:           return "BACKWARD_SOLVE";
+  case TaskType::SOLVE_UPPER:              return "SOLVE_UPPER";
+  case TaskType::LOOK_RIGHT:               return "LOOK_RIGHT";
+  case TaskType::DISTMAT_EXTRACT_ROWS:     return "DISTMAT_EXTRACT_ROWS";
+  case TaskType::DISTMAT_EXTRACT_COLS:     return "DISTMAT_EXTRACT_COLS";
+  case TaskType::DISTMAT_EXTRACT:          return "DISTMAT_EXTRACT";
+  case TaskType::QR:                       return "QR";
+  case TaskType::REDUCE_SAMPLES:           return "REDUCE_SAMPLES";
+  case TaskType::COMPUTE_SAMPLES:          return "COMPUTE_SAMPLES";
+  case TaskType::ORTHO:                    return "ORTHO";
+  case TaskType::REDIST_2D_TO_HSS:         return "REDIST_2D_TO_HSS";
+  default: return "SOMEOTHERTAKSNOTNAMED";
   }
 }
 
+void TaskTimer::print_name(std::ostream& os) {
+  if (type == TaskType::EXPLICITLY_NAMED_TASK) os << t_name;
+  else os << task_name(type);
+}
+
 // std::ostream& operator<<(std::ostream& os, TaskTimer& t) {
 //   //  if (t.type == EXPLICITLY_NAMED_TASK) return os;
 // #if defined(USE_OPENMP_TIMER)
@@ -362,3 +360,105 @@ void TimerList::finalize() {
 #endif
 }
 
+
+bool Tracer::enabled_ = false;
+std::size_t Tracer::capacity_ = 0;
+std::vector<std::unique_ptr<Tracer::Buffer>> Tracer::buffers_;
+std::atomic<int> Tracer::nr_threads_(0);
+
+void Tracer::enable(std::size_t capacity) {
+  if (enabled_) return;
+  capacity = std::max(capacity, std::size_t(1));
+  if (capacity != capacity_) clear();
+  capacity_ = capacity;
+  if (buffers_.empty()) {
+    // one buffer per thread, including threads from nested parallel
+    // regions, up to some maximum
+#if defined(_OPENMP)
+    int max_t = std::max(256, 4 * omp_get_max_threads());
+#else
+    int max_t = 1;
+#endif
+    buffers_.resize(max_t);
+    for (auto& b : buffers_) b.reset(new Buffer());
+  }
+  enabled_ = true;
+}
+
+void Tracer::disable() { enabled_ = false; }
+
+void Tracer::clear() {
+  for (auto& b : buffers_) {
+    b->events.clear();
+    b->next = 0;
+  }
+}
+
+int Tracer::thread_index() {
+  // threads get a fixed index the first time they record an event,
+  // so each buffer is only ever accessed by a single thread
+  static thread_local int t = -1;
+  if (t == -1) t = nr_threads_.fetch_add(1);
+  return t;
+}
+
+void Tracer::record(const TraceEvent& e) {
+  auto t = thread_index();
+  if (t >= int(buffers_.size())) return;
+  auto& b = *buffers_[t];
+  if (b.events.size() < capacity_) b.events.push_back(e);
+  else b.events[b.next] = e;
+  b.next = (b.next + 1) % capacity_;
+}
+
+double Tracer::now() {
+#if defined(USE_OPENMP_TIMER)
+  return GET_TIME_NOW() - TaskTimer::t_begin;
+#else
+  return duration_cast<duration<double>>
+    (GET_TIME_NOW() - TaskTimer::t_begin).count();
+#endif
+}
+
+void Tracer::write_chrome_trace(std::ostream& os, int rank, bool first) {
+  // Chrome trace timestamps and durations are in microseconds
+  os << std::fixed << std::setprecision(3);
+  auto sep = [&]() { if (!first) os << ",\n"; first = false; };
+  sep();
+  os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank
+     << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+  for (std::size_t t=0; t<buffers_.size(); t++) {
+    auto& ev = buffers_[t]->events;
+    // oldest event first, in case the ring buffer wrapped around
+    auto n = ev.size();
+    auto b = (n < capacity_) ? 0 : buffers_[t]->next;
+    for (std::size_t i=0; i<n; i++) {
+      auto& e = ev[(b + i) % n];
+      sep();
+      os << "{\"name\":\"" << e.name << "\",\"cat\":\"strumpack\""
+         << ",\"ph\":\"X\",\"pid\":" << rank << ",\"tid\":" << t
+         << ",\"ts\":" << e.begin * 1e6
+         << ",\"dur\":" << (e.end - e.begin) * 1e6 << ",\"args\":{";
+      bool farg = true;
+      auto arg = [&](const char* k, long long v) {
+        if (v < 0) return;
+        os << (farg ? "" : ",") << "\"" << k << "\":" << v;
+        farg = false;
+      };
+      arg("front", e.front);
+      arg("level", e.level);
+      arg("size", e.size);
+      if (e.flops) arg("flops", e.flops);
+      if (e.bytes) arg("bytes", e.bytes);
+      os << "}}";
+    }
+  }
+  os << std::defaultfloat;
+}
+
+void Tracer::write_chrome_trace(const std::string& fname) {
+  std::ofstream f(fname, std::ofstream::out);
+  f << "[\n";
+  write_chrome_trace(f, 0, true);
+  f << "\n]\n";
+}
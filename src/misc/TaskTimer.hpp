@@ -33,6 +33,9 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include <memory>
+#include <atomic>
+#include <ostream>
 #include <functional>
 
 namespace strumpack {
@@ -63,6 +66,11 @@ namespace strumpack {
     REDUCE_SAMPLES, COMPUTE_SAMPLES, ORTHO, REDIST_2D_TO_HSS,
     EXPLICITLY_NAMED_TASK}; // leave this one last
 
+  /**
+   * Return a (static) string with the name of task type t.
+   */
+  const char* task_name(TaskType t);
+
   class TimerList;
 
   class TaskTimer {
@@ -107,22 +115,136 @@ namespace strumpack {
     std::vector<std::list<TaskTimer>> list;
   };
 
+
+  /**
+   * A single traced span, see TraceSpan. Times are in seconds since
+   * TaskTimer::t_begin. A value of -1 for front, level or size means
+   * the span is not associated with a frontal matrix.
+   */
+  struct TraceEvent {
+    const char* name;
+    double begin, end;
+    int front, level, size;
+    long long flops, bytes;
+  };
+
+  /**
+   * Runtime tracing of (nested) spans, for instance the
+   * factorization of each frontal matrix. Unlike the TaskTimer
+   * logs, this does not require building with
+   * STRUMPACK_TASK_TIMERS. When disabled, the overhead of a
+   * TraceSpan is a single check of a flag. When enabled, each thread
+   * records events in its own fixed size ring buffer (no locking,
+   * and the oldest events are overwritten when the buffer is full).
+   * The events can be written as a Chrome trace (JSON), which can be
+   * visualized with chrome://tracing or https://ui.perfetto.dev.
+   */
+  class Tracer {
+  public:
+    /**
+     * Start recording events. Events already recorded are kept.
+     *
+     * \param capacity number of events stored per thread
+     */
+    static void enable(std::size_t capacity=65536);
+    static void disable();
+    static bool enabled() { return enabled_; }
+
+    /**
+     * Remove all recorded events.
+     */
+    static void clear();
+
+    /**
+     * Store an event in the ring buffer of the calling thread.
+     */
+    static void record(const TraceEvent& e);
+
+    /**
+     * Seconds since TaskTimer::t_begin.
+     */
+    static double now();
+
+    /**
+     * Write all recorded events as Chrome trace events, with pid
+     * set to rank and tid to the index of the recording thread.
+     * This writes the events of one process only, and does not
+     * write the enclosing '[' and ']', so the output of multiple
+     * processes can be concatenated. Every event is preceded by a
+     * comma, except the first if first is true.
+     */
+    static void write_chrome_trace
+    (std::ostream& os, int rank=0, bool first=true);
+
+    /**
+     * Write all recorded events to file fname, as a Chrome trace
+     * array.
+     */
+    static void write_chrome_trace(const std::string& fname);
+
+  private:
+    struct Buffer {
+      std::vector<TraceEvent> events;
+      std::size_t next = 0;
+    };
+    static bool enabled_;
+    static std::size_t capacity_;
+    static std::vector<std::unique_ptr<Buffer>> buffers_;
+    static std::atomic<int> nr_threads_;
+    static int thread_index();
+  };
+
+  /**
+   * RAII helper to trace the lifetime of a scope. This does nothing
+   * (except check Tracer::enabled()) when tracing is disabled.
+   */
+  class TraceSpan {
+  public:
+    TraceSpan(const char* name, int front=-1, int level=-1, int size=-1)
+      : on_(Tracer::enabled()) {
+      if (on_) e_ = TraceEvent{name, Tracer::now(), 0., front, level, size,
+                               0, 0};
+    }
+    TraceSpan(TaskType t) : TraceSpan(task_name(t)) {}
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+    ~TraceSpan() { stop(); }
+    /**
+     * End the span before the end of its scope.
+     */
+    void stop() {
+      if (on_) {
+        e_.end = Tracer::now();
+        Tracer::record(e_);
+        on_ = false;
+      }
+    }
+    void set_flops(long long f) { if (on_) e_.flops = f; }
+    void set_bytes(long long b) { if (on_) e_.bytes = b; }
+
+  private:
+    bool on_;
+    TraceEvent e_;
+  };
+
 #if !defined(STRUMPACK_TASK_TIMERS)
 
-#define TIMER_TIME(name, nr, timer) (void)0
+#define TIMER_TIME(type, depth, timer)          \
+  TraceSpan timer(type);
 #define TIMER_DEFINE(name, nr, timer) (void)0
 #define TIMER_START(timer) (void)0
-#define TIMER_STOP(timer) (void)0
+#define TIMER_STOP(timer) timer.stop();
 
 #else // STRUMPACK_TASK_TIMERS
 
 #define TIMER_TIME(type, depth, timer)          \
   TaskTimer timer(type, depth);                 \
+  TraceSpan timer##_trace(type);                \
   timer.start();
 #define TIMER_DEFINE(type, depth, timer)        \
   TaskTimer timer(type, depth);
 #define TIMER_START(timer) timer.start();
-#define TIMER_STOP(timer) timer.stop();
+#define TIMER_STOP(timer) timer.stop(); timer##_trace.stop();
 
 #endif // STRUMPACK_TASK_TIMERS
 
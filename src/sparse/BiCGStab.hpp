@@ -33,6 +33,7 @@
 
 #include "StrumpackParameters.hpp"
 #include "CompressedSparseMatrix.hpp"
+#include "dense/DenseMatrix.hpp"
 
 namespace strumpack {
 
@@ -124,6 +125,168 @@ namespace strumpack {
     return error;
   }
 
+  /**
+   * BiCGStab for multiple right-hand sides, the columns of b. Every
+   * column is solved with its own BiCGStab recurrence, but the
+   * iterations are done in lockstep, so that the preconditioner and
+   * the matrix-vector product are applied to the block of all
+   * columns that did not converge yet. totit is the number of
+   * (block) iterations. Returns the largest relative residual.
+   */
+  template <typename scalar_t>
+  typename RealType<scalar_t>::value_type BlockBiCGStab
+  (const std::function<void(const DenseMatrix<scalar_t>&,
+                            DenseMatrix<scalar_t>&)>& spmv,
+   const std::function<void(DenseMatrix<scalar_t>&)>& preconditioner,
+   DenseMatrix<scalar_t>& x, const DenseMatrix<scalar_t>& b,
+   typename RealType<scalar_t>::value_type rtol,
+   typename RealType<scalar_t>::value_type atol, int& totit, int maxit,
+   bool non_zero_guess, bool verbose) {
+    using real_t = typename RealType<scalar_t>::value_type;
+    using DenseM_t = DenseMatrix<scalar_t>;
+    const std::size_t n = x.rows(), m = x.cols();
+    DenseM_t r(n, m), r_tld(n, m), p_hat(n, m), s_hat(n, m),
+      p(n, m), v(n, m), s(n, m), t(n, m);
+    std::vector<real_t> bnrm2(m), resid(m), error(m, real_t(0.));
+    std::vector<scalar_t> alpha(m, scalar_t(0.)), rho(m),
+      rho_1(m, scalar_t(0.)), omega(m, scalar_t(1.));
+    std::vector<std::size_t> act;
+    // apply spmv or preconditioner to the active columns only
+    auto gather = [&](const DenseM_t& X) {
+      DenseM_t Xa(n, act.size());
+      for (std::size_t j=0; j<act.size(); j++)
+        std::copy(X.ptr(0, act[j]), X.ptr(0, act[j])+n, Xa.ptr(0, j));
+      return Xa;
+    };
+    auto scatter = [&](const DenseM_t& Xa, DenseM_t& X) {
+      for (std::size_t j=0; j<act.size(); j++)
+        std::copy(Xa.ptr(0, j), Xa.ptr(0, j)+n, X.ptr(0, act[j]));
+    };
+    auto block_spmv = [&](const DenseM_t& X, DenseM_t& Y) {
+      if (act.size() == m) spmv(X, Y);
+      else {
+        DenseM_t Ya(n, act.size());
+        spmv(gather(X), Ya);
+        scatter(Ya, Y);
+      }
+    };
+    auto block_prec = [&](DenseM_t& X) {
+      if (act.size() == m) preconditioner(X);
+      else {
+        auto Xa = gather(X);
+        preconditioner(Xa);
+        scatter(Xa, X);
+      }
+    };
+    auto print = [&](int it) {
+      if (!verbose) return;
+      real_t maxres = 0., maxerr = 0.;
+      for (std::size_t c=0; c<m; c++) {
+        maxres = std::max(maxres, resid[c]);
+        maxerr = std::max(maxerr, error[c]);
+      }
+      std::cout << "BiCGStab it. " << it << "\tnrhs = " << act.size()
+                << "\tmax res = " << std::setw(12) << maxres
+                << "\tmax rel.res = " << std::setw(12) << maxerr
+                << std::endl;
+    };
+    for (std::size_t c=0; c<m; c++) {
+      bnrm2[c] = blas::nrm2(n, b.ptr(0, c), 1);
+      if (bnrm2[c] == 0.0) std::fill(x.ptr(0, c), x.ptr(0, c)+n, scalar_t(0.));
+      else act.push_back(c);
+    }
+    if (act.empty()) return real_t(0.);
+    if (non_zero_guess) {      // compute initial residual
+      block_spmv(x, r);
+      for (auto c : act)
+        blas::axpby(n, scalar_t(1.), b.ptr(0, c), 1,
+                    scalar_t(-1.), r.ptr(0, c), 1);
+    } else {
+      for (auto c : act) {
+        std::copy(b.ptr(0, c), b.ptr(0, c)+n, r.ptr(0, c));
+        std::fill(x.ptr(0, c), x.ptr(0, c)+n, scalar_t(0.));
+      }
+    }
+    // remove converged columns, or columns for which the method
+    // broke down, from the active set
+    auto deactivate = [&](const std::vector<bool>& done) {
+      std::vector<std::size_t> a;
+      for (auto c : act) if (!done[c]) a.push_back(c);
+      act.swap(a);
+    };
+    std::vector<bool> done(m, false);
+    for (auto c : act) {
+      resid[c] = blas::nrm2(n, r.ptr(0, c), 1);
+      error[c] = resid[c] / bnrm2[c];
+      if (error[c] <= rtol || resid[c] <= atol) done[c] = true;
+    }
+    print(totit);
+    deactivate(done);
+    for (auto c : act)
+      std::copy(r.ptr(0, c), r.ptr(0, c)+n, r_tld.ptr(0, c));
+    for (totit=1; totit<=maxit && !act.empty(); totit++) {
+      for (auto c : act) {
+        rho[c] = blas::dotc(n, r_tld.ptr(0, c), 1, r.ptr(0, c), 1);
+        if (rho[c] == scalar_t(0.0)) done[c] = true;
+      }
+      deactivate(done);
+      if (act.empty()) break;
+      for (auto c : act) {
+        if (totit > 1) {
+          auto beta = (rho[c] / rho_1[c]) * (alpha[c] / omega[c]);
+          // p = r + beta (p - omega v)
+          blas::axpy(n, -omega[c], v.ptr(0, c), 1, p.ptr(0, c), 1);
+          blas::axpby(n, scalar_t(1), r.ptr(0, c), 1, beta, p.ptr(0, c), 1);
+        } else std::copy(r.ptr(0, c), r.ptr(0, c)+n, p.ptr(0, c));
+        std::copy(p.ptr(0, c), p.ptr(0, c)+n, p_hat.ptr(0, c));
+      }
+      block_prec(p_hat);                      // p_hat = M \ p
+      block_spmv(p_hat, v);                   // v = A * p_hat
+      for (auto c : act) {
+        alpha[c] = rho[c] / blas::dotc
+          (n, r_tld.ptr(0, c), 1, v.ptr(0, c), 1);
+        std::copy(r.ptr(0, c), r.ptr(0, c)+n, s.ptr(0, c));
+        blas::axpy(n, -alpha[c], v.ptr(0, c), 1, s.ptr(0, c), 1);
+        auto snrm = blas::nrm2(n, s.ptr(0, c), 1);
+        if (snrm < atol) {                    // early convergence check
+          blas::axpy(n, alpha[c], p_hat.ptr(0, c), 1, x.ptr(0, c), 1);
+          std::copy(s.ptr(0, c), s.ptr(0, c)+n, r.ptr(0, c));
+          resid[c] = snrm;
+          error[c] = resid[c] / bnrm2[c];
+          done[c] = true;
+        } else
+          std::copy(s.ptr(0, c), s.ptr(0, c)+n, s_hat.ptr(0, c));
+      }
+      deactivate(done);
+      if (act.empty()) { print(totit); break; }
+      block_prec(s_hat);                      // s_hat = M \ s
+      block_spmv(s_hat, t);                   // t = A*s_hat
+      for (auto c : act) {
+        auto tc = t.ptr(0, c);
+        auto sc = s.ptr(0, c);
+        auto rc = r.ptr(0, c);
+        omega[c] = blas::dotc(n, tc, 1, sc, 1) / blas::dotc(n, tc, 1, tc, 1);
+        // x = x + alpha*p_hat + omega*s_hat
+        blas::axpy(n, alpha[c], p_hat.ptr(0, c), 1, x.ptr(0, c), 1);
+        blas::axpy(n, omega[c], s_hat.ptr(0, c), 1, x.ptr(0, c), 1);
+        std::copy(sc, sc+n, rc);              // r = s - omega*t
+        blas::axpy(n, -omega[c], tc, 1, rc, 1);
+        resid[c] = blas::nrm2(n, rc, 1);
+        error[c] = resid[c] / bnrm2[c];
+        if (error[c] <= rtol || resid[c] <= atol ||
+            omega[c] == scalar_t(0.0)) done[c] = true;
+        rho_1[c] = rho[c];
+      }
+      print(totit);
+      deactivate(done);
+    }
+    real_t maxerr = 0.;
+    for (std::size_t c=0; c<m; c++)
+      if (bnrm2[c] != 0.0)
+        maxerr = std::max(maxerr, blas::nrm2(n, r.ptr(0, c), 1) / bnrm2[c]);
+    return maxerr;
+  }
+
 } // end namespace strumpack
 
 #endif // BICGSTAB_HPP
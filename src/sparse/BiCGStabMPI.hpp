@@ -34,6 +34,7 @@
 #include "StrumpackParameters.hpp"
 #include "CompressedSparseMatrix.hpp"
 #include "dense/DistributedVector.hpp"
+#include "dense/DenseMatrix.hpp"
 
 namespace strumpack {
 
@@ -131,6 +132,203 @@ namespace strumpack {
     return error;
   }
 
+  /**
+   * BiCGStab for multiple right-hand sides, see BlockBiCGStab.
+   * Collective operation on comm. The local rows of x and b are
+   * stored as the columns of a DenseMatrix. The inner products and
+   * norms of all active columns are combined in a single reduction.
+   */
+  template <typename scalar_t>
+  typename RealType<scalar_t>::value_type BlockBiCGStabMPI
+  (const MPIComm& comm,
+   const std::function<void(const DenseMatrix<scalar_t>&,
+                            DenseMatrix<scalar_t>&)>& spmv,
+   const std::function<void(DenseMatrix<scalar_t>&)>& preconditioner,
+   DenseMatrix<scalar_t>& x, const DenseMatrix<scalar_t>& b,
+   typename RealType<scalar_t>::value_type rtol,
+   typename RealType<scalar_t>::value_type atol, int& totit, int maxit,
+   bool non_zero_guess, bool verbose) {
+    using real_t = typename RealType<scalar_t>::value_type;
+    using DenseM_t = DenseMatrix<scalar_t>;
+    const std::size_t n = x.rows(), m = x.cols();
+    DenseM_t r(n, m), r_tld(n, m), p_hat(n, m), s_hat(n, m),
+      p(n, m), v(n, m), s(n, m), t(n, m);
+    std::vector<real_t> bnrm2(m), resid(m), error(m, real_t(0.));
+    std::vector<scalar_t> alpha(m, scalar_t(0.)), rho(m),
+      rho_1(m, scalar_t(0.)), omega(m, scalar_t(1.));
+    std::vector<std::size_t> act;
+    auto gather = [&](const DenseM_t& X) {
+      DenseM_t Xa(n, act.size());
+      for (std::size_t j=0; j<act.size(); j++)
+        std::copy(X.ptr(0, act[j]), X.ptr(0, act[j])+n, Xa.ptr(0, j));
+      return Xa;
+    };
+    auto scatter = [&](const DenseM_t& Xa, DenseM_t& X) {
+      for (std::size_t j=0; j<act.size(); j++)
+        std::copy(Xa.ptr(0, j), Xa.ptr(0, j)+n, X.ptr(0, act[j]));
+    };
+    auto block_spmv = [&](const DenseM_t& X, DenseM_t& Y) {
+      if (act.size() == m) spmv(X, Y);
+      else {
+        DenseM_t Ya(n, act.size());
+        spmv(gather(X), Ya);
+        scatter(Ya, Y);
+      }
+    };
+    auto block_prec = [&](DenseM_t& X) {
+      if (act.size() == m) preconditioner(X);
+      else {
+        auto Xa = gather(X);
+        preconditioner(Xa);
+        scatter(Xa, X);
+      }
+    };
+    // inner products/norms of the active columns, one reduction
+    auto dots = [&](const DenseM_t& U, const DenseM_t& W) {
+      std::vector<scalar_t> d(act.size());
+      for (std::size_t j=0; j<act.size(); j++)
+        d[j] = blas::dotc(n, U.ptr(0, act[j]), 1, W.ptr(0, act[j]), 1);
+      comm.all_reduce(d.data(), d.size(), MPI_SUM);
+      return d;
+    };
+    auto norms = [&](const DenseM_t& U) {
+      std::vector<real_t> d(act.size());
+      for (std::size_t j=0; j<act.size(); j++) {
+        auto l = blas::nrm2(n, U.ptr(0, act[j]), 1);
+        d[j] = l * l;
+      }
+      comm.all_reduce(d.data(), d.size(), MPI_SUM);
+      for (auto& v : d) v = std::sqrt(v);
+      return d;
+    };
+    auto print = [&](int it) {
+      if (!verbose) return;
+      real_t maxres = 0., maxerr = 0.;
+      for (std::size_t c=0; c<m; c++) {
+        maxres = std::max(maxres, resid[c]);
+        maxerr = std::max(maxerr, error[c]);
+      }
+      std::cout << "BiCGStab it. " << it << "\tnrhs = " << act.size()
+                << "\tmax res = " << std::setw(12) << maxres
+                << "\tmax rel.res = " << std::setw(12) << maxerr
+                << std::endl;
+    };
+    std::vector<bool> done(m, false);
+    auto deactivate = [&]() {
+      std::vector<std::size_t> a;
+      for (auto c : act) if (!done[c]) a.push_back(c);
+      act.swap(a);
+    };
+    for (std::size_t c=0; c<m; c++) act.push_back(c);
+    {
+      auto nb = norms(b);
+      for (std::size_t c=0; c<m; c++) {
+        bnrm2[c] = nb[c];
+        if (bnrm2[c] == 0.0) {
+          std::fill(x.ptr(0, c), x.ptr(0, c)+n, scalar_t(0.));
+          done[c] = true;
+        }
+      }
+    }
+    deactivate();
+    if (act.empty()) return real_t(0.);
+    if (non_zero_guess) {      // compute initial residual
+      block_spmv(x, r);
+      for (auto c : act)
+        blas::axpby(n, scalar_t(1.), b.ptr(0, c), 1,
+                    scalar_t(-1.), r.ptr(0, c), 1);
+    } else {
+      for (auto c : act) {
+        std::copy(b.ptr(0, c), b.ptr(0, c)+n, r.ptr(0, c));
+        std::fill(x.ptr(0, c), x.ptr(0, c)+n, scalar_t(0.));
+      }
+    }
+    {
+      auto nr = norms(r);
+      for (std::size_t j=0; j<act.size(); j++) {
+        auto c = act[j];
+        resid[c] = nr[j];
+        error[c] = resid[c] / bnrm2[c];
+        if (error[c] <= rtol || resid[c] <= atol) done[c] = true;
+      }
+    }
+    print(totit);
+    deactivate();
+    for (auto c : act)
+      std::copy(r.ptr(0, c), r.ptr(0, c)+n, r_tld.ptr(0, c));
+    for (totit=1; totit<=maxit && !act.empty(); totit++) {
+      auto rt_r = dots(r_tld, r);
+      for (std::size_t j=0; j<act.size(); j++) {
+        auto c = act[j];
+        rho[c] = rt_r[j];
+        if (rho[c] == scalar_t(0.0)) done[c] = true;
+      }
+      deactivate();
+      if (act.empty()) break;
+      for (auto c : act) {
+        if (totit > 1) {
+          auto beta = (rho[c] / rho_1[c]) * (alpha[c] / omega[c]);
+          // p = r + beta (p - omega v)
+          blas::axpy(n, -omega[c], v.ptr(0, c), 1, p.ptr(0, c), 1);
+          blas::axpby(n, scalar_t(1), r.ptr(0, c), 1, beta, p.ptr(0, c), 1);
+        } else std::copy(r.ptr(0, c), r.ptr(0, c)+n, p.ptr(0, c));
+        std::copy(p.ptr(0, c), p.ptr(0, c)+n, p_hat.ptr(0, c));
+      }
+      block_prec(p_hat);                      // p_hat = M \ p
+      block_spmv(p_hat, v);                   // v = A * p_hat
+      auto rt_v = dots(r_tld, v);
+      for (std::size_t j=0; j<act.size(); j++) {
+        auto c = act[j];
+        alpha[c] = rho[c] / rt_v[j];
+        std::copy(r.ptr(0, c), r.ptr(0, c)+n, s.ptr(0, c));
+        blas::axpy(n, -alpha[c], v.ptr(0, c), 1, s.ptr(0, c), 1);
+      }
+      auto snrm = norms(s);
+      for (std::size_t j=0; j<act.size(); j++) {
+        auto c = act[j];
+        if (snrm[j] < atol) {                 // early convergence check
+          blas::axpy(n, alpha[c], p_hat.ptr(0, c), 1, x.ptr(0, c), 1);
+          std::copy(s.ptr(0, c), s.ptr(0, c)+n, r.ptr(0, c));
+          resid[c] = snrm[j];
+          error[c] = resid[c] / bnrm2[c];
+          done[c] = true;
+        } else
+          std::copy(s.ptr(0, c), s.ptr(0, c)+n, s_hat.ptr(0, c));
+      }
+      deactivate();
+      if (act.empty()) { print(totit); break; }
+      block_prec(s_hat);                      // s_hat = M \ s
+      block_spmv(s_hat, t);                   // t = A*s_hat
+      auto t_s = dots(t, s), t_t = dots(t, t);
+      for (std::size_t j=0; j<act.size(); j++) {
+        auto c = act[j];
+        auto sc = s.ptr(0, c);
+        auto rc = r.ptr(0, c);
+        omega[c] = t_s[j] / t_t[j];
+        // x = x + alpha*p_hat + omega*s_hat
+        blas::axpy(n, alpha[c], p_hat.ptr(0, c), 1, x.ptr(0, c), 1);
+        blas::axpy(n, omega[c], s_hat.ptr(0, c), 1, x.ptr(0, c), 1);
+        std::copy(sc, sc+n, rc);              // r = s - omega*t
+        blas::axpy(n, -omega[c], t.ptr(0, c), 1, rc, 1);
+        rho_1[c] = rho[c];
+      }
+      auto nr = norms(r);
+      for (std::size_t j=0; j<act.size(); j++) {
+        auto c = act[j];
+        resid[c] = nr[j];
+        error[c] = resid[c] / bnrm2[c];
+        if (error[c] <= rtol || resid[c] <= atol ||
+            omega[c] == scalar_t(0.0)) done[c] = true;
+      }
+      print(totit);
+      deactivate();
+    }
+    real_t maxerr = 0.;
+    for (std::size_t c=0; c<m; c++)
+      if (bnrm2[c] != 0.0) maxerr = std::max(maxerr, error[c]);
+    return maxerr;
+  }
+
 } // end namespace strumpack
 
 #endif // BICGSTAB_MPI_HPP
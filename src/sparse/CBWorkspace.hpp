@@ -0,0 +1,175 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#ifndef CB_WORKSPACE_HPP
+#define CB_WORKSPACE_HPP
+
+#include <cassert>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <mutex>
+
+namespace strumpack {
+
+  /**
+   * \class CBWorkspace
+   *
+   * \brief Stack used to store the contribution blocks of the fronts
+   * in (a subtree of) the elimination tree.
+   *
+   * The fronts are factored in postorder, so when a front is
+   * assembled, the contribution blocks of its children are the ones
+   * on top of the stack. After the extend-add, the children's
+   * contribution blocks are popped and the contribution block of the
+   * parent is moved down to where the contribution block of its
+   * first child started. The memory is not owned by this object, it
+   * is a region of a larger buffer, see EliminationTree.
+   */
+  template<typename scalar_t> class CBWorkspace {
+  public:
+    CBWorkspace() {}
+    CBWorkspace(scalar_t* buf, std::size_t size)
+      : buf_(buf), size_(size) {}
+
+    /**
+     * Allocate n scalars on top of the stack.
+     */
+    scalar_t* push(std::size_t n) {
+      assert(top_ + n <= size_);
+      auto p = buf_ + top_;
+      top_ += n;
+      peak_ = std::max(peak_, top_);
+      return p;
+    }
+
+    /**
+     * Remove the n scalars from the top of the stack.
+     */
+    void pop(std::size_t n) { assert(n <= top_); top_ -= n; }
+
+    /**
+     * Pop n scalars and the m scalars below them, then push the
+     * (previous) top n scalars again, ie, move them down by m. This
+     * is used to move the contribution block of a front over those of
+     * its children. Returns a pointer to the moved data.
+     */
+    scalar_t* collapse(std::size_t n, std::size_t m) {
+      assert(n + m <= top_);
+      auto src = buf_ + top_ - n;
+      pop(n + m);
+      auto dst = push(n);
+      if (m && n) std::memmove(dst, src, n*sizeof(scalar_t));
+      return dst;
+    }
+
+    void reset() { top_ = peak_ = 0; }
+    std::size_t top() const { return top_; }
+    std::size_t size() const { return size_; }
+    std::size_t peak() const { return peak_; }
+
+  private:
+    scalar_t* buf_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t top_ = 0;
+    std::size_t peak_ = 0;
+  };
+
+  /**
+   * \class CBWorkspacePool
+   *
+   * \brief A number of CBWorkspace stacks, in a single buffer, shared
+   * by the subtrees of the elimination tree that are factored
+   * sequentially.
+   *
+   * A subtree takes a stack when its factorization starts and returns
+   * it, empty, when it is done (the contribution block of the root of
+   * the subtree is not stored on the stack). So only as many stacks
+   * are needed as there are subtrees factored concurrently, ie, at
+   * most the number of threads. The memory is not owned by this
+   * object, see EliminationTree.
+   */
+  template<typename scalar_t> class CBWorkspacePool {
+  public:
+    /**
+     * Set up n stacks of size scalars each, in buf, which should have
+     * room for n*size scalars.
+     */
+    void setup(scalar_t* buf, std::size_t n, std::size_t size) {
+      stacks_.clear();
+      stacks_.reserve(n);
+      free_.clear();
+      for (std::size_t i=0; i<n; i++) {
+        stacks_.emplace_back(buf+i*size, size);
+        free_.push_back(&stacks_.back());
+      }
+    }
+
+    /**
+     * Take a stack, returns nullptr if none are left. This can
+     * happen when a thread starts a subtree while it is suspended in
+     * another one, the subtree then does not use a stack.
+     */
+    CBWorkspace<scalar_t>* acquire() {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (free_.empty()) return nullptr;
+      auto ws = free_.back();
+      free_.pop_back();
+      return ws;
+    }
+
+    /**
+     * Return a stack obtained with acquire(), it should be empty.
+     */
+    void release(CBWorkspace<scalar_t>* ws) {
+      if (!ws) return;
+      assert(ws->top() == 0);
+      std::lock_guard<std::mutex> lock(mtx_);
+      free_.push_back(ws);
+    }
+
+    /**
+     * The sum of the peak sizes of the stacks.
+     */
+    std::size_t peak() const {
+      std::size_t p = 0;
+      for (auto& s : stacks_) p += s.peak();
+      return p;
+    }
+
+    void clear() { stacks_.clear(); free_.clear(); }
+
+  private:
+    std::vector<CBWorkspace<scalar_t>> stacks_;
+    std::vector<CBWorkspace<scalar_t>*> free_;
+    std::mutex mtx_;
+  };
+
+} // end namespace strumpack
+
+#endif // CB_WORKSPACE_HPP
@@ -32,6 +32,7 @@
  */
 #ifndef CSRMATRIX_HPP
 #define CSRMATRIX_HPP
+#include <algorithm>
 #include <sstream>
 #include <fstream>
 #include <vector>
@@ -129,6 +130,16 @@ namespace strumpack {
 #endif //defined(STRUMPACK_USE_MPI)
 #endif //DOXYGEN_SHOULD_SKIP_THIS
 
+  private:
+    /**
+     * Rows [lo, hi) handled by the calling thread in a parallel
+     * region. The rows are split in contiguous blocks with
+     * (approximately) the same number of nonzeros, so that rows with
+     * many nonzeros do not cause load imbalance.
+     */
+    void thread_rows(integer_t& lo, integer_t& hi) const;
+
+  public:
     using CompressedSparseMatrix<scalar_t,integer_t>::n_;
     using CompressedSparseMatrix<scalar_t,integer_t>::nnz_;
     using CompressedSparseMatrix<scalar_t,integer_t>::ptr_;
@@ -310,16 +321,43 @@ namespace strumpack {
   }
 #endif
 
+  template<typename scalar_t,typename integer_t> void
+  CSRMatrix<scalar_t,integer_t>::thread_rows
+  (integer_t& lo, integer_t& hi) const {
+#if defined(_OPENMP)
+    const long long p = omp_get_thread_num(), P = omp_get_num_threads();
+#else
+    const long long p = 0, P = 1;
+#endif
+    // first row with at least nnz*q/P nonzeros before it, nnz_ is
+    // the allocated size, which can be larger than ptr_[n_]
+    const long long nnz = ptr_[n_];
+    auto first_row = [&](long long q) -> integer_t {
+      if (q == 0) return 0;
+      if (q == P) return n_;
+      return std::min
+        (n_, integer_t(std::lower_bound
+                       (ptr_.begin(), ptr_.begin()+n_+1,
+                        integer_t(nnz * q / P)) - ptr_.begin()));
+    };
+    lo = first_row(p);
+    hi = first_row(p+1);
+  }
+
   template<typename scalar_t,typename integer_t> void
   CSRMatrix<scalar_t,integer_t>::spmv
   (const scalar_t* x, scalar_t* y) const {
-#pragma omp parallel for
-    for (integer_t r=0; r<n_; r++) {
-      const auto hij = ptr_[r+1];
-      scalar_t yr(0);
-      for (integer_t j=ptr_[r]; j<hij; j++)
-        yr += val_[j] * x[ind_[j]];
-      y[r] = yr;
+#pragma omp parallel
+    {
+      integer_t lo, hi;
+      thread_rows(lo, hi);
+      for (integer_t r=lo; r<hi; r++) {
+        const auto hij = ptr_[r+1];
+        scalar_t yr(0);
+        for (integer_t j=ptr_[r]; j<hij; j++)
+          yr += val_[j] * x[ind_[j]];
+        y[r] = yr;
+      }
     }
     STRUMPACK_FLOPS(this->spmv_flops());
     STRUMPACK_BYTES(this->spmv_bytes());
@@ -331,8 +369,48 @@ namespace strumpack {
     assert(x.cols() == y.cols());
     assert(x.rows() == std::size_t(n_));
     assert(y.rows() == std::size_t(n_));
-    for (std::size_t c=0; c<x.cols(); c++)
-      spmv(x.ptr(0,c), y.ptr(0,c));
+    const std::size_t m = x.cols();
+    if (m == 1) {
+      spmv(x.data(), y.data());
+      return;
+    }
+    // The nonzeros of a row are read once for a block of B columns,
+    // instead of once per column. The B columns of x are first
+    // copied to a row-major n x B tile, padded with zeros, so that
+    // every nonzero touches a single contiguous piece of x and the
+    // B partial sums can be kept in registers.
+    const std::size_t B = 8;
+    std::vector<scalar_t> xt(std::size_t(n_) * B);
+#pragma omp parallel
+    {
+      integer_t lo, hi;
+      thread_rows(lo, hi);
+      for (std::size_t c=0; c<m; c+=B) {
+        const auto nc = std::min(B, m-c);
+        for (integer_t r=lo; r<hi; r++) {
+          auto xr = &xt[r*B];
+          for (std::size_t cc=0; cc<nc; cc++) xr[cc] = x(r, c+cc);
+          for (std::size_t cc=nc; cc<B; cc++) xr[cc] = scalar_t(0.);
+        }
+#pragma omp barrier
+        for (integer_t r=lo; r<hi; r++) {
+          scalar_t yr[B];
+          for (std::size_t cc=0; cc<B; cc++) yr[cc] = scalar_t(0.);
+          const auto hij = ptr_[r+1];
+          for (integer_t j=ptr_[r]; j<hij; j++) {
+            const auto v = val_[j];
+            const auto xj = &xt[ind_[j]*B];
+            for (std::size_t cc=0; cc<B; cc++)
+              yr[cc] += v * xj[cc];
+          }
+          for (std::size_t cc=0; cc<nc; cc++)
+            y(r, c+cc) = yr[cc];
+        }
+#pragma omp barrier
+      }
+    }
+    STRUMPACK_FLOPS(this->spmv_flops() * m);
+    STRUMPACK_BYTES(this->spmv_bytes() * ((m+B-1)/B));
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -577,21 +655,36 @@ namespace strumpack {
   CSRMatrix<scalar_t,integer_t>::max_scaled_residual
   (const DenseM_t& x, const DenseM_t& b) const {
     real_t res = real_t(0.);
-    const integer_t m = n_;
-    const integer_t n = x.cols();
-    for (integer_t c=0; c<n; c++) {
-#pragma omp parallel for reduction(max:res)
-      for (integer_t r=0; r<m; r++) {
-        auto true_res = b(r, c);
-        auto abs_res = std::abs(b(r, c));
-        const auto hij = ptr_[r+1];
-        for (integer_t j=ptr_[r]; j<hij; ++j) {
-          const auto v = val_[j];
-          const auto rj = ind_[j];
-          true_res -= v * x(rj, c);
-          abs_res += std::abs(v) * std::abs(x(rj,c));
+    const std::size_t m = x.cols(), ldx = x.ld();
+    // blocked over the columns, as in spmv
+    const std::size_t B = 8;
+#pragma omp parallel reduction(max:res)
+    {
+      integer_t lo, hi;
+      thread_rows(lo, hi);
+      for (std::size_t c=0; c<m; c+=B) {
+        const auto nc = std::min(B, m-c);
+        const auto xc = x.ptr(0, c);
+        for (integer_t r=lo; r<hi; r++) {
+          scalar_t true_res[B];
+          real_t abs_res[B];
+          for (std::size_t cc=0; cc<nc; cc++) {
+            true_res[cc] = b(r, c+cc);
+            abs_res[cc] = std::abs(b(r, c+cc));
+          }
+          const auto hij = ptr_[r+1];
+          for (integer_t j=ptr_[r]; j<hij; ++j) {
+            const auto v = val_[j];
+            const auto absv = std::abs(v);
+            const auto xj = xc + ind_[j];
+            for (std::size_t cc=0; cc<nc; cc++) {
+              true_res[cc] -= v * xj[cc*ldx];
+              abs_res[cc] += absv * std::abs(xj[cc*ldx]);
+            }
+          }
+          for (std::size_t cc=0; cc<nc; cc++)
+            res = std::max(res, std::abs(true_res[cc]) / abs_res[cc]);
         }
-        res = std::max(res, std::abs(true_res) / std::abs(abs_res));
       }
     }
     return res;
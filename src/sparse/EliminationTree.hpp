@@ -31,6 +31,9 @@
 
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <array>
+#include <mutex>
 #include "StrumpackParameters.hpp"
 #include "CompressedSparseMatrix.hpp"
 #include "FrontalMatrixHSS.hpp"
@@ -56,12 +59,56 @@ namespace strumpack {
 
     virtual void multifrontal_factorization
     (const SpMat_t& A, const SPOptions<scalar_t>& opts);
+    /**
+     * Solve with the factors. Solves from different threads are
+     * serialized, they share the work memory of the tree, while
+     * every solve runs in parallel with OpenMP tasks.
+     */
     virtual void multifrontal_solve(DenseM_t& x) const;
+    /**
+     * Solve, only visiting the fronts marked in prune, see
+     * prune_backward and prune_forward. Only the rows of the
+     * solution for which prune was set up are computed.
+     */
+    void multifrontal_solve(DenseM_t& x, const SolvePruning& prune) const;
+    /**
+     * Set up prune for solves where only the rows sol_rows (sorted,
+     * in the ordering of the factors) of the solution are needed, see
+     * FrontalMatrix::prune_backward. This is done once for all
+     * right-hand sides.
+     */
+    void prune_backward
+    (const std::vector<integer_t>& sol_rows, SolvePruning& prune) const {
+      prune.reset(nr_dense_fronts_ + nr_HSS_fronts_ + nr_BLR_fronts_);
+      root_->prune_backward(sol_rows, prune);
+    }
+    /**
+     * Restrict the forward solve in prune to a right-hand side which
+     * is only nonzero in the rows rhs_rows, see
+     * FrontalMatrix::prune_forward. Call this after prune_backward.
+     */
+    void prune_forward
+    (const std::vector<integer_t>& rhs_rows, SolvePruning& prune) const {
+      root_->prune_forward(rhs_rows, prune);
+    }
     virtual void multifrontal_solve_dist
     (DenseM_t& x, const std::vector<integer_t>& dist) {} // TODO const
     virtual integer_t maximum_rank() const;
     virtual long long factor_nonzeros() const;
     virtual long long dense_factor_nonzeros() const;
+    /**
+     * Number of nonzeros in the factors, split by the type of the
+     * frontal matrices: { dense, HSS, BLR }.
+     */
+    virtual std::array<long long,3> factor_nonzeros_by_type() const;
+    /**
+     * Compute the requested entries of the inverse of the factored
+     * matrix by selected inversion, see
+     * FrontalMatrix::selected_inversion. The entries are reordered.
+     * Returns false if not all entries could be computed.
+     */
+    virtual bool selected_inversion
+    (std::vector<InverseEntry<scalar_t,integer_t>>& e) const;
     void print_rank_statistics(std::ostream &out) const {
       root_->print_rank_statistics(out);
     }
@@ -69,6 +116,15 @@ namespace strumpack {
     virtual int nr_BLR_fronts() const { return nr_BLR_fronts_; }
     virtual int nr_dense_fronts() const { return nr_dense_fronts_; }
 
+    /**
+     * Memory (in bytes) used for the contribution block stacks in
+     * the last numerical factorization. This is the peak working
+     * memory of the sequentially factored subtrees.
+     */
+    std::size_t CB_stack_memory() const {
+      return CB_stack_peak_ * sizeof(scalar_t);
+    }
+
     void draw(const SpMat_t& A, const std::string& name) const;
 
   protected:
@@ -82,7 +138,20 @@ namespace strumpack {
     int nr_dense_fronts_ = 0;
     std::unique_ptr<F_t> root_;
 
+    void setup_CB_stacks(const std::vector<F_t*>& seq_subtrees={});
+    void clear_CB_stacks();
+
   private:
+    // storage for the CB stacks, a DenseMatrix so that it is
+    // included in the memory counters
+    DenseM_t CB_buf_;
+    CBWorkspacePool<scalar_t> CB_stacks_;
+    std::size_t CB_stack_peak_ = 0;
+    // work memory for multifrontal_solve, kept for the next solve,
+    // only used by one solve at a time
+    mutable SolveWorkspace<scalar_t> solve_ws_;
+    mutable std::mutex solve_mtx_;
+
     std::unique_ptr<F_t> setup_tree
     (const SPOptions<scalar_t>& opts, const SpMat_t& A,
      const SeparatorTree<integer_t>& sep_tree,
@@ -92,6 +161,9 @@ namespace strumpack {
     void symbolic_factorization
     (const SpMat_t& A, const SeparatorTree<integer_t>& sep_tree,
      integer_t sep, std::vector<integer_t>* upd, int depth=0) const;
+
+    bool multifrontal_factorization_DAG
+    (const SpMat_t& A, const SPOptions<scalar_t>& opts);
   };
 
 
@@ -218,16 +290,170 @@ namespace strumpack {
     return front;
   }
 
+  /**
+   * The subtrees that are factored sequentially use a stack for the
+   * contribution blocks. A subtree only needs the stack while it is
+   * being factored, so the subtrees share min(P, #subtrees) stacks,
+   * with P the number of threads, each sized for the largest
+   * subtree, from the symbolic factorization. This is redone before
+   * each factorization since it depends on the task recursion cutoff
+   * level. When seq_subtrees is not empty, only those subtrees are
+   * factored sequentially (see multifrontal_factorization_DAG),
+   * otherwise this follows the recursive tasking.
+   */
+  template<typename scalar_t,typename integer_t> void
+  EliminationTree<scalar_t,integer_t>::setup_CB_stacks
+  (const std::vector<F_t*>& seq_subtrees) {
+    std::vector<F_t*> roots;
+    root_->find_CB_stack_roots(roots, false);
+    if (!seq_subtrees.empty()) {
+      roots.clear();
+      for (auto f : seq_subtrees)
+        f->find_CB_stack_roots
+          (roots, false, params::task_recursion_cutoff_level);
+    }
+    std::size_t size = 0;
+    for (auto r : roots) {
+      r->set_CB_pool(&CB_stacks_);
+      size = std::max(size, r->CB_stack_peak());
+    }
+    std::size_t n = std::min
+      (std::size_t(std::max(params::num_threads, 1)), roots.size());
+    CB_buf_ = DenseM_t(n*size, 1);
+    CB_stacks_.setup(CB_buf_.data(), n, size);
+  }
+
+  /**
+   * Release the memory for the CB stacks after the factorization,
+   * only the peak usage is kept, see CB_stack_memory().
+   */
+  template<typename scalar_t,typename integer_t> void
+  EliminationTree<scalar_t,integer_t>::clear_CB_stacks() {
+    CB_stack_peak_ = CB_stacks_.peak();
+    CB_buf_.clear();
+    CB_stacks_.clear();
+  }
+
   template<typename scalar_t,typename integer_t> void
   EliminationTree<scalar_t,integer_t>::multifrontal_factorization
   (const SpMat_t& A, const SPOptions<scalar_t>& opts) {
+    if (opts.use_DAG_scheduler() && multifrontal_factorization_DAG(A, opts))
+      return;
+    setup_CB_stacks();
     root_->multifrontal_factorization(A, opts);
+    clear_CB_stacks();
+  }
+
+  /**
+   * Factor the tree as a task dependency graph. The fronts are
+   * flattened in postorder, with the index of their parent and a
+   * counter of children that are not yet factored. Subtrees with
+   * less than 1/(4P) of the (estimated) total work, with P the
+   * number of threads, form a single node in the graph and are
+   * factored sequentially, with their contribution blocks on a
+   * stack. The leaves of the graph are started as tasks, and the
+   * task that completes the last child of a front continues with
+   * that front. Idle threads steal work from the OpenMP runtime,
+   * which also schedules the tasks created within the fronts, so
+   * there is no fork/join between the levels of the tree.
+   *
+   * Returns false, without doing anything, if the tree contains
+   * distributed memory fronts.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  EliminationTree<scalar_t,integer_t>::multifrontal_factorization_DAG
+  (const SpMat_t& A, const SPOptions<scalar_t>& opts) {
+    std::vector<F_t*> fronts;
+    std::vector<int> parent, level;
+    {
+      // iterative postorder traversal
+      std::vector<std::pair<int,bool>> stack;
+      std::vector<F_t*> pre{root_.get()};
+      std::vector<int> prepa{-1}, prelvl{0};
+      stack.emplace_back(0, false);
+      std::vector<int> post(1);
+      while (!stack.empty()) {
+        auto& t = stack.back();
+        auto f = pre[t.first];
+        if (f->isMPI()) return false;
+        if (t.second) {
+          post[t.first] = fronts.size();
+          fronts.push_back(f);
+          level.push_back(prelvl[t.first]);
+          parent.push_back(prepa[t.first]);
+          stack.pop_back();
+          continue;
+        }
+        t.second = true;
+        int id = t.first;
+        for (auto ch : {f->rchild(), f->lchild()}) {
+          if (!ch) continue;
+          stack.emplace_back(pre.size(), false);
+          pre.push_back(ch);
+          prepa.push_back(id);
+          prelvl.push_back(prelvl[id]+1);
+          post.push_back(0);
+        }
+      }
+      // parent is still a preorder index, map it to postorder
+      for (auto& p : parent) if (p != -1) p = post[p];
+    }
+    const int n = fronts.size();
+    std::vector<double> work(n);
+    for (int i=0; i<n; i++) {
+      double ds = fronts[i]->dim_sep(), du = fronts[i]->dim_upd();
+      work[i] += 2./3.*ds*ds*ds + 2.*ds*ds*du + 2.*ds*du*du;
+      if (parent[i] != -1) work[parent[i]] += work[i];
+    }
+    const double seq_work = work[n-1] / (4. * params::num_threads);
+    std::vector<bool> seq(n), in_dag(n);
+    std::vector<F_t*> seq_subtrees;
+    std::unique_ptr<std::atomic<int>[]> pending
+      (new std::atomic<int>[n]);
+    for (int i=n-1; i>=0; i--) {
+      pending[i] = 0;
+      in_dag[i] = parent[i] == -1 ||
+        (in_dag[parent[i]] && !seq[parent[i]]);
+      if (!in_dag[i]) continue;
+      seq[i] = work[i] <= seq_work ||
+        (!fronts[i]->lchild() && !fronts[i]->rchild());
+      if (seq[i]) seq_subtrees.push_back(fronts[i]);
+      if (parent[i] != -1) pending[parent[i]]++;
+    }
+    setup_CB_stacks(seq_subtrees);
+#pragma omp parallel default(shared)
+#pragma omp single nowait
+    for (int i=0; i<n; i++) {
+      if (!in_dag[i] || !seq[i]) continue;
+#pragma omp task default(shared) firstprivate(i)
+      {
+        int f = i;
+        while (true) {
+          if (seq[f])
+            fronts[f]->multifrontal_factorization
+              (A, opts, level[f], params::task_recursion_cutoff_level);
+          else fronts[f]->factor_node(A, opts, level[f], 0);
+          f = parent[f];
+          if (f == -1 || pending[f].fetch_sub(1) != 1) break;
+        }
+      }
+    }
+    clear_CB_stacks();
+    return true;
   }
 
   template<typename scalar_t,typename integer_t> void
   EliminationTree<scalar_t,integer_t>::multifrontal_solve
   (DenseM_t& x) const {
-    root_->multifrontal_solve(x);
+    std::lock_guard<std::mutex> lock(solve_mtx_);
+    root_->multifrontal_solve(x, solve_ws_);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  EliminationTree<scalar_t,integer_t>::multifrontal_solve
+  (DenseM_t& x, const SolvePruning& prune) const {
+    std::lock_guard<std::mutex> lock(solve_mtx_);
+    root_->multifrontal_solve(x, solve_ws_, &prune);
   }
 
   template<typename scalar_t,typename integer_t> integer_t
@@ -257,6 +483,28 @@ namespace strumpack {
     return nonzeros;
   }
 
+  template<typename scalar_t,typename integer_t> std::array<long long,3>
+  EliminationTree<scalar_t,integer_t>::factor_nonzeros_by_type() const {
+    std::array<long long,3> nnz = {0, 0, 0};
+    root_->factor_nonzeros_by_type(nnz);
+    return nnz;
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  EliminationTree<scalar_t,integer_t>::selected_inversion
+  (std::vector<InverseEntry<scalar_t,integer_t>>& e) const {
+    std::sort(e.begin(), e.end(),
+              [](const InverseEntry<scalar_t,integer_t>& a,
+                 const InverseEntry<scalar_t,integer_t>& b) {
+                return a.first() < b.first(); });
+    bool ok;
+#pragma omp parallel
+#pragma omp single nowait
+    ok = root_->selected_inversion
+      (e.data(), e.data()+e.size(), nullptr, nullptr, 0);
+    return ok;
+  }
+
   template<typename scalar_t,typename integer_t> void
   EliminationTree<scalar_t,integer_t>::draw
   (const SpMat_t& A, const std::string& name) const {
@@ -76,6 +76,7 @@ namespace strumpack {
     integer_t maximum_rank() const override;
     long long factor_nonzeros() const override;
     long long dense_factor_nonzeros() const override;
+    std::array<long long,3> factor_nonzeros_by_type() const override;
     std::vector<SepRange> subtree_ranges;
 
   protected:
@@ -90,6 +91,19 @@ namespace strumpack {
       return comm_.all_reduce(this->nr_dense_fronts_, MPI_SUM);
     }
 
+    /**
+     * Estimate of the work for a front, used to divide the processes
+     * over the subtrees in the proportional mapping: the flops for
+     * the partial factorization of a dense front, LU of F11, the two
+     * triangular solves with F12 and F21 and the Schur complement
+     * update, plus the extend-add of the contribution block into the
+     * parent.
+     */
+    static float front_work(integer_t dim_sep, integer_t dim_upd) {
+      float s = dim_sep, u = dim_upd;
+      return 2.f/3.f*s*s*s + 2.f*s*s*u + 2.f*s*u*u + u*u;
+    }
+
   private:
     struct ParFront {
       // TODO store a pointer to the actual front??
@@ -265,12 +279,11 @@ namespace strumpack {
           (std::unique(upd[sep].begin(), upd[sep].end()), upd[sep].end());
       }
     }
-    integer_t dim_blk = (sep_end - sep_begin) + upd[sep].size();
-    // assume amount of work per front is N^3, work per subtree is
-    // work on front plus children
+    // work per subtree is work on front plus children
     float wl = (chl != -1) ? subtree_work[chl] : 0.;
     float wr = (chr != -1) ? subtree_work[chr] : 0.;
-    subtree_work[sep] = (float(dim_blk)*dim_blk*dim_blk) + wl + wr;
+    subtree_work[sep] = front_work(sep_end - sep_begin, upd[sep].size())
+      + wl + wr;
   }
 
   // keep track of [P0_pa, P0_pa+P_pa) -> can be used to stop iso keep_subtree
@@ -388,6 +401,13 @@ namespace strumpack {
       (EliminationTree<scalar_t,integer_t>::dense_factor_nonzeros(), MPI_SUM);
   }
 
+  template<typename scalar_t,typename integer_t> std::array<long long,3>
+  EliminationTreeMPI<scalar_t,integer_t>::factor_nonzeros_by_type() const {
+    auto nnz = EliminationTree<scalar_t,integer_t>::factor_nonzeros_by_type();
+    comm_.all_reduce(nnz.data(), 3, MPI_SUM);
+    return nnz;
+  }
+
 } // end namespace strumpack
 
 #endif
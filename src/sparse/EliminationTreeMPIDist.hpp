@@ -71,6 +71,15 @@ namespace strumpack {
      MatrixReorderingMPI<scalar_t,integer_t>& nd,
      const MPIComm& comm);
 
+    /**
+     * Redistribute the values of a matrix with the same sparsity
+     * pattern as the matrix used to construct this tree, reusing the
+     * proportional mapping and the symbolic factorization.
+     */
+    void update_values
+    (const SPOptions<scalar_t>& opts,
+     const CSRMatrixMPI<scalar_t,integer_t>& A);
+
     void multifrontal_factorization
     (const CompressedSparseMatrix<scalar_t,integer_t>& A,
      const SPOptions<scalar_t>& opts) override;
@@ -363,11 +372,22 @@ namespace strumpack {
     }
   }
 
+  template<typename scalar_t,typename integer_t> void
+  EliminationTreeMPIDist<scalar_t,integer_t>::update_values
+  (const SPOptions<scalar_t>& opts,
+   const CSRMatrixMPI<scalar_t,integer_t>& A) {
+    MPI_Pcontrol(1, "block_row_A_to_prop_A");
+    Aprop_.setup(A, nd_, *this, opts.use_HSS());
+    MPI_Pcontrol(-1, "block_row_A_to_prop_A");
+  }
+
   template<typename scalar_t,typename integer_t> void
   EliminationTreeMPIDist<scalar_t,integer_t>::multifrontal_factorization
   (const CompressedSparseMatrix<scalar_t,integer_t>& A,
    const SPOptions<scalar_t>& opts) {
+    this->setup_CB_stacks();
     this->root_->multifrontal_factorization(Aprop_, opts);
+    this->clear_CB_stacks();
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -589,12 +609,11 @@ namespace strumpack {
         (std::unique(upd[sep].begin(), upd[sep].end()), upd[sep].end());
     }
     upd[sep].shrink_to_fit();
-    integer_t dim_blk = (sep_end - sep_begin) + upd[sep].size();
-    // assume amount of work per front is N^3, work per subtree is
-    // work on front plus children
+    // work per subtree is work on front plus children
     float wl = (chl != -1) ? subtree_work[chl] : 0.;
     float wr = (chr != -1) ? subtree_work[chr] : 0.;
-    subtree_work[sep] = (float(dim_blk)*dim_blk*dim_blk) + wl + wr;
+    subtree_work[sep] = this->front_work
+      (sep_end - sep_begin, upd[sep].size()) + wl + wr;
   }
 
   /**
@@ -608,7 +627,7 @@ namespace strumpack {
    *        childs, merge with upd for local distributed separator
    *        send upd to parent receive work estimate from left and
    *        right subtrees work estimate for distributed separator
-   *        subtree is dim_blk^3 + left_tree + right_tree send work
+   *        subtree is front_work + left_tree + right_tree send work
    *        estimate for this distributed separator / subtree to
    *        parent
    */
@@ -714,9 +733,8 @@ namespace strumpack {
         float dsep_left_work, dsep_right_work;
         MPI_Recv(&dsep_left_work,  1, MPI_FLOAT, chl, 3, comm_.comm(), &stat);
         MPI_Recv(&dsep_right_work, 1, MPI_FLOAT, chr, 4, comm_.comm(), &stat);
-        integer_t dim_blk = (sep_end - sep_begin) + dist_upd.size();
-        dsep_work = (float(dim_blk)*dim_blk*dim_blk) + dsep_left_work +
-          dsep_right_work;
+        dsep_work = this->front_work(sep_end - sep_begin, dist_upd.size())
+          + dsep_left_work + dsep_right_work;
 
         // send dist_upd and work estimate to parent
         if (nd_.tree().pa(pa) != -1) {
@@ -33,6 +33,7 @@
 #include "FrontalMatrixMPI.hpp"
 #include "FrontalMatrixDenseMPI.hpp"
 #include "FrontalMatrixHSSMPI.hpp"
+#include "BLR/BLRMatrix.hpp"
 
 namespace strumpack {
 
@@ -42,6 +43,53 @@ namespace strumpack {
 
   public:
 
+    /**
+     * Add to rsizes[p] the number of elements this rank, in the grid
+     * of the parent pa, will receive from rank p of pa in the
+     * extend-add from child ch, as packed by
+     * extend_add_copy_to_buffers or extend_add_seq_copy_to_buffers.
+     * The contribution block of the child is block cyclic on the
+     * grid of the child, or on a single rank for a sequential child,
+     * and the front of the parent is block cyclic on the grid of the
+     * parent, so the rows and the columns can be counted
+     * separately. This only depends on the update indices and the
+     * grid shapes, not on the numerical values.
+     */
+    static void extend_add_count_from_buffers
+    (std::vector<std::size_t>& rsizes,
+     const FrontalMatrixMPI<scalar_t,integer_t>* pa,
+     const FrontalMatrix<scalar_t,integer_t>* ch) {
+      if (!pa->grid()->active()) return;
+      const auto I = ch->upd_to_parent
+        (static_cast<const FrontalMatrix<scalar_t,integer_t>*>(pa));
+      const std::size_t du = ch->dim_upd();
+      const std::size_t ds = pa->dim_sep();
+      const auto prows = pa->grid()->nprows();
+      const auto pcols = pa->grid()->npcols();
+      const auto prow = pa->grid()->prow();
+      const auto pcol = pa->grid()->pcol();
+      const auto B = DistM_t::default_MB;
+      int ch_prows = 1, ch_pcols = 1;
+      if (auto mpi_ch =
+          dynamic_cast<const FrontalMatrixMPI<scalar_t,integer_t>*>(ch)) {
+        ch_prows = mpi_ch->grid()->nprows();
+        ch_pcols = mpi_ch->grid()->npcols();
+      }
+      // nr[r] (nc[c]) is the number of rows (columns) of the child
+      // CB on child process row r (column c) that map to this
+      // process row (column) in the parent
+      std::vector<std::size_t> nr(ch_prows), nc(ch_pcols);
+      for (std::size_t u=0; u<du; u++) {
+        auto t = (I[u] < ds) ? I[u] : I[u] - ds;
+        if (int((t / B) % prows) == prow) nr[(u / B) % ch_prows]++;
+        if (int((t / B) % pcols) == pcol) nc[(u / B) % ch_pcols]++;
+      }
+      const auto ch_master = pa->master(ch);
+      for (int c=0; c<ch_pcols; c++)
+        for (int r=0; r<ch_prows; r++)
+          rsizes[ch_master+r+c*ch_prows] += nr[r] * nc[c];
+    }
+
     static void extend_add_copy_to_buffers
     (const DistM_t& CB, std::vector<std::vector<scalar_t>>& sbuf,
      const FrontalMatrixMPI<scalar_t,integer_t>* pa,
@@ -57,8 +105,7 @@ namespace strumpack {
       // destination rank is:
       //  ((r / B) % prows) + ((c / B) % pcols) * prows
       //  = pr[r] + pc[c]
-      auto pr = new int[CB.lrows()+CB.lcols()];
-      auto pc = pr + CB.lrows();
+      std::vector<int> pr(lrows), pc(lcols);
       int r_upd, c_upd;
       for (r_upd=0; r_upd<lrows; r_upd++) {
         auto t = I[CB.rowl2g_fixed(r_upd)];
@@ -74,103 +121,103 @@ namespace strumpack {
       }
       for (int c=c_upd; c<lcols; c++)
         pc[c] = (((I[CB.coll2g_fixed(c)]-pa_sep) / B) % pcols) * prows;
-      { // reserve space for the send buffers
-        std::vector<std::size_t> cnt(sbuf.size());
-        for (int c=0; c<lcols; c++)
-          for (int r=0; r<lrows; r++)
-            cnt[pr[r]+pc[c]]++;
-        for (std::size_t p=0; p<sbuf.size(); p++)
-          sbuf[p].reserve(sbuf[p].size()+cnt[p]);
-      }
-      if (params::num_threads != 1) {
-#pragma omp parallel for
-        for (int t=0; t<int(sbuf.size()); t++) {
-          for (int c=0; c<c_upd; c++) // F11
-            for (int r=0, pcc=pc[c]; r<r_upd; r++) {
-              auto d = pr[r]+pcc;
-              if (d == t) sbuf[d].push_back(CB(r,c));
-            }
-          for (int c=c_upd; c<lcols; c++) // F12
-            for (int r=0, pcc=pc[c]; r<r_upd; r++) {
-              auto d = pr[r]+pcc;
-              if (d == t) sbuf[d].push_back(CB(r,c));
-            }
-          for (int c=0; c<c_upd; c++) // F21
-            for (int r=r_upd, pcc=pc[c]; r<lrows; r++) {
-              auto d = pr[r]+pcc;
-              if (d == t) sbuf[d].push_back(CB(r,c));
-            }
-          for (int c=c_upd; c<lcols; c++) // F22
-            for (int r=r_upd, pcc=pc[c]; r<lrows; r++) {
-              auto d = pr[r]+pcc;
-              if (d == t) sbuf[d].push_back(CB(r,c));
-            }
-        }
-      } else {
-        for (int c=0; c<c_upd; c++) // F11
-          for (int r=0, pcc=pc[c]; r<r_upd; r++)
-            sbuf[pr[r]+pcc].push_back(CB(r,c));
-        for (int c=c_upd; c<lcols; c++) // F12
-          for (int r=0, pcc=pc[c]; r<r_upd; r++)
-            sbuf[pr[r]+pcc].push_back(CB(r,c));
-        for (int c=0; c<c_upd; c++) // F21
-          for (int r=r_upd, pcc=pc[c]; r<lrows; r++)
-            sbuf[pr[r]+pcc].push_back(CB(r,c));
-        for (int c=c_upd; c<lcols; c++) // F22
-          for (int r=r_upd, pcc=pc[c]; r<lrows; r++)
-            sbuf[pr[r]+pcc].push_back(CB(r,c));
-      }
-      delete[] pr;
+      RowMap R1(r_upd, [](int r) { return r; },
+                [&](int r) { return pr[r]; });
+      RowMap R2(lrows-r_upd, [&](int r) { return r_upd+r; },
+                [&](int r) { return pr[r_upd+r]; });
+      std::vector<Column<const scalar_t>> cols;
+      cols.reserve(2*lcols);
+      for (int c=0; c<c_upd; c++) // F11
+        cols.push_back({&R1, CB.data()+c*CB.ld(), pc[c]});
+      for (int c=c_upd; c<lcols; c++) // F12
+        cols.push_back({&R1, CB.data()+c*CB.ld(), pc[c]});
+      for (int c=0; c<c_upd; c++) // F21
+        cols.push_back({&R2, CB.data()+c*CB.ld(), pc[c]});
+      for (int c=c_upd; c<lcols; c++) // F22
+        cols.push_back({&R2, CB.data()+c*CB.ld(), pc[c]});
+      pack(cols, sbuf);
     }
 
     static void extend_add_seq_copy_to_buffers
     (const DenseM_t& CB, std::vector<std::vector<scalar_t>>& sbuf,
      const FrontalMatrixMPI<scalar_t,integer_t>* pa,
      const FrontalMatrix<scalar_t,integer_t>* ch) {
-      std::size_t u2s;
-      const auto I = ch->upd_to_parent
-        (static_cast<const FrontalMatrix<scalar_t,integer_t>*>(pa), u2s);
-      const std::size_t du = ch->dim_upd();
-      const std::size_t ds = pa->dim_sep();
-      const auto pr = new int[CB.rows()+CB.cols()];
-      const auto pc = pr + CB.rows();
-      const auto prows = pa->grid()->nprows();
-      const auto pcols = pa->grid()->npcols();
-      const auto B = DistM_t::default_MB;
-      // destination rank is:
-      //  ((r / B) % prows) + ((c / B) % pcols) * prows
-      //  = pr[r] + pc[c]
-      for (std::size_t i=0; i<u2s; i++) {
-        auto Ii = I[i];
-        pr[i] = (Ii / B) % prows;
-        pc[i] = ((Ii / B) % pcols) * prows;
-      }
-      for (std::size_t i=u2s; i<du; i++) {
-        auto Ii = I[i] - ds;
-        pr[i] = (Ii / B) % prows;
-        pc[i] = ((Ii / B) % pcols) * prows;
-      }
-      { // reserve space for the send buffers
-        std::vector<std::size_t> cnt(sbuf.size());
-        for (std::size_t c=0; c<du; c++)
-          for (std::size_t r=0; r<du; r++)
-            cnt[pr[r]+pc[c]]++;
-        for (std::size_t p=0; p<sbuf.size(); p++)
-          sbuf[p].reserve(sbuf[p].size()+cnt[p]);
-      }
-      for (std::size_t c=0; c<u2s; c++) // F11
-        for (std::size_t r=0; r<u2s; r++)
-          sbuf[pr[r]+pc[c]].push_back(CB(r,c));
-      for (std::size_t c=u2s; c<du; c++) // F12
-        for (std::size_t r=0; r<u2s; r++)
-          sbuf[pr[r]+pc[c]].push_back(CB(r,c));
-      for (std::size_t c=0; c<u2s; c++) // F21
-        for (std::size_t r=u2s; r<du; r++)
-          sbuf[pr[r]+pc[c]].push_back(CB(r,c));
-      for (std::size_t c=u2s; c<du; c++) // F22
-        for (std::size_t r=u2s; r<du; r++)
-          sbuf[pr[r]+pc[c]].push_back(CB(r,c));
-      delete[] pr;
+      const int du = ch->dim_upd();
+      int s;
+      std::vector<int> pr, pc;
+      seq_destinations(pa, ch, s, pr, pc);
+      RowMap R1(s, [](int r) { return r; }, [&](int r) { return pr[r]; });
+      RowMap R2(du-s, [&](int r) { return s+r; },
+                [&](int r) { return pr[s+r]; });
+      std::vector<Column<const scalar_t>> cols;
+      cols.reserve(2*du);
+      for (int c=0; c<s; c++) // F11
+        cols.push_back({&R1, CB.ptr(0,c), pc[c]});
+      for (int c=s; c<du; c++) // F12
+        cols.push_back({&R1, CB.ptr(0,c), pc[c]});
+      for (int c=0; c<s; c++) // F21
+        cols.push_back({&R2, CB.ptr(0,c), pc[c]});
+      for (int c=s; c<du; c++) // F22
+        cols.push_back({&R2, CB.ptr(0,c), pc[c]});
+      pack(cols, sbuf);
+    }
+
+    /**
+     * Same as extend_add_seq_copy_to_buffers, for a contribution
+     * block stored as a BLR matrix. The tiles are expanded one at a
+     * time and copied directly to their place in the send buffers,
+     * the dense contribution block is never formed. The buffers are
+     * the same as for the dense contribution block.
+     */
+    static void extend_add_seq_copy_to_buffers
+    (const BLR::BLRMatrix<scalar_t>& CB,
+     std::vector<std::vector<scalar_t>>& sbuf,
+     const FrontalMatrixMPI<scalar_t,integer_t>* pa,
+     const FrontalMatrix<scalar_t,integer_t>* ch) {
+      const int du = ch->dim_upd();
+      int s;
+      std::vector<int> pr, pc;
+      seq_destinations(pa, ch, s, pr, pc);
+      RowMap R1(s, [](int r) { return r; }, [&](int r) { return pr[r]; });
+      RowMap R2(du-s, [&](int r) { return s+r; },
+                [&](int r) { return pr[s+r]; });
+      // column c of CB is cols[c] for rows [0,s) and cols[du+c] for
+      // rows [s,du), no data yet, only the buffer offsets are needed
+      std::vector<Column<const scalar_t>> cols;
+      cols.reserve(2*du);
+      for (int c=0; c<du; c++)
+        cols.push_back({&R1, nullptr, pc[c]});
+      for (int c=0; c<du; c++)
+        cols.push_back({&R2, nullptr, pc[c]});
+      std::vector<std::size_t> first, off;
+      pack_offsets(cols, sbuf, first, off);
+      const auto roff1 = R1.run_offsets(), roff2 = R2.run_offsets();
+      // copy rows [r0,r0+m) of column k, rows are in CB coordinates
+      auto copy_rows = [&]
+        (const RowMap& R, const std::vector<std::size_t>& roff,
+         std::size_t k, const scalar_t* d, int r0, int m) {
+        const auto o = off.data() + first[k];
+        std::size_t i = std::upper_bound
+          (R.start.begin(), R.start.end(), r0) - R.start.begin();
+        if (i) i--;
+        for (; i<R.start.size() && R.start[i]<r0+m; i++) {
+          auto lo = std::max(R.start[i], r0);
+          auto hi = std::min(R.start[i]+R.len[i], r0+m);
+          if (lo >= hi) continue;
+          auto sl = R.slot[i];
+          std::copy(d+lo-r0, d+hi-r0, sbuf[R.rank[sl]+cols[k].rank].data()
+                    + o[sl] + roff[i] + (lo-R.start[i]));
+        }
+      };
+#pragma omp parallel if(!omp_in_parallel() && params::num_threads != 1)
+#pragma omp single nowait
+      CB.for_each_dense_tile
+        ([&](const DenseM_t& D, std::size_t r0, std::size_t c0) {
+          for (std::size_t j=0; j<D.cols(); j++) {
+            copy_rows(R1, roff1, c0+j, D.ptr(0,j), r0, D.rows());
+            copy_rows(R2, roff2, du+c0+j, D.ptr(0,j), r0, D.rows());
+          }
+        }, 0);
     }
 
     static void extend_add_seq_copy_from_buffers
@@ -182,11 +229,8 @@ namespace strumpack {
       const auto ch_upd = ch->upd();
       const auto pa_upd = pa->upd();
       const auto pa_sep = pa->sep_begin();
-      auto r_1 =
-        new int[F11.lrows()+F11.lcols()+F22.lrows()+F22.lcols()];
-      auto c_1 = r_1 + F11.lrows();
-      auto r_2 = c_1 + F11.lcols();
-      auto c_2 = r_2 + F22.lrows();
+      std::vector<int> r_1(F11.lrows()), c_1(F11.lcols()),
+        r_2(F22.lrows()), c_2(F22.lcols());
       integer_t r_max_1 = 0, r_max_2 = 0;
       integer_t c_max_1 = 0, c_max_2 = 0;
       for (int r=0, ur=0; r<F11.lrows(); r++) {
@@ -217,19 +261,22 @@ namespace strumpack {
         if (ch_upd[uc] != fgc) continue;
         c_2[c_max_2++] = c;
       }
+      // everything comes from a single rank
+      RowMap R1(r_max_1, [&](int r) { return r_1[r]; },
+                [](int) { return 0; });
+      RowMap R2(r_max_2, [&](int r) { return r_2[r]; },
+                [](int) { return 0; });
+      std::vector<Column<scalar_t>> cols;
+      cols.reserve(2*(c_max_1+c_max_2));
       for (int c=0; c<c_max_1; c++)
-        for (int r=0; r<r_max_1; r++)
-          F11(r_1[r],c_1[c]) += *(pbuf++);
+        cols.push_back({&R1, F11.data()+c_1[c]*F11.ld(), 0});
       for (int c=0; c<c_max_2; c++)
-        for (int r=0; r<r_max_1; r++)
-          F12(r_1[r],c_2[c]) += *(pbuf++);
+        cols.push_back({&R1, F12.data()+c_2[c]*F12.ld(), 0});
       for (int c=0; c<c_max_1; c++)
-        for (int r=0; r<r_max_2; r++)
-          F21(r_2[r],c_1[c]) += *(pbuf++);
+        cols.push_back({&R2, F21.data()+c_1[c]*F21.ld(), 0});
       for (int c=0; c<c_max_2; c++)
-        for (int r=0; r<r_max_2; r++)
-          F22(r_2[r],c_2[c]) += *(pbuf++);
-      delete[] r_1;
+        cols.push_back({&R2, F22.data()+c_2[c]*F22.ld(), 0});
+      unpack(cols, &pbuf, true);
     }
 
     static void extend_add_copy_from_buffers
@@ -247,16 +294,10 @@ namespace strumpack {
       // source rank is
       //  ((r / B) % prows) + ((c / B) % pcols) * prows
       // where r,c is the coordinate in the F22 block of the child
-      auto upd_r_1 =
-        new int[2*F11.lrows()+2*F11.lcols()+
-                2*F22.lrows()+2*F22.lcols()];
-      auto upd_c_1 = upd_r_1 + F11.lrows();
-      auto upd_r_2 = upd_c_1 + F11.lcols();
-      auto upd_c_2 = upd_r_2 + F22.lrows();
-      auto r_1 = upd_c_2 + F22.lcols();
-      auto c_1 = r_1 + F11.lrows();
-      auto r_2 = c_1 + F11.lcols();
-      auto c_2 = r_2 + F22.lrows();
+      std::vector<int> upd_r_1(F11.lrows()), upd_c_1(F11.lcols()),
+        upd_r_2(F22.lrows()), upd_c_2(F22.lcols()),
+        r_1(F11.lrows()), c_1(F11.lcols()),
+        r_2(F22.lrows()), c_2(F22.lcols());
       integer_t r_max_1 = 0, r_max_2 = 0;
       integer_t c_max_1 = 0, c_max_2 = 0;
       for (int r=0, ur=0; r<F11.lrows(); r++) {
@@ -291,19 +332,21 @@ namespace strumpack {
         c_2[c_max_2] = c;
         upd_c_2[c_max_2++] = ((uc / B) % pcols) * prows;
       }
+      RowMap R1(r_max_1, [&](int r) { return r_1[r]; },
+                [&](int r) { return upd_r_1[r]; });
+      RowMap R2(r_max_2, [&](int r) { return r_2[r]; },
+                [&](int r) { return upd_r_2[r]; });
+      std::vector<Column<scalar_t>> cols;
+      cols.reserve(2*(c_max_1+c_max_2));
       for (int c=0; c<c_max_1; c++)
-        for (int r=0; r<r_max_1; r++)
-          F11(r_1[r],c_1[c]) += *(pbuf[upd_r_1[r]+upd_c_1[c]]++);
+        cols.push_back({&R1, F11.data()+c_1[c]*F11.ld(), upd_c_1[c]});
       for (int c=0; c<c_max_2; c++)
-        for (int r=0; r<r_max_1; r++)
-          F12(r_1[r],c_2[c]) += *(pbuf[upd_r_1[r]+upd_c_2[c]]++);
+        cols.push_back({&R1, F12.data()+c_2[c]*F12.ld(), upd_c_2[c]});
       for (int c=0; c<c_max_1; c++)
-        for (int r=0; r<r_max_2; r++)
-          F21(r_2[r],c_1[c]) += *(pbuf[upd_r_2[r]+upd_c_1[c]]++);
+        cols.push_back({&R2, F21.data()+c_1[c]*F21.ld(), upd_c_1[c]});
       for (int c=0; c<c_max_2; c++)
-        for (int r=0; r<r_max_2; r++)
-          F22(r_2[r],c_2[c]) += *(pbuf[upd_r_2[r]+upd_c_2[c]]++);
-      delete[] upd_r_1;
+        cols.push_back({&R2, F22.data()+c_2[c]*F22.ld(), upd_c_2[c]});
+      unpack(cols, pbuf, true);
     }
 
 
@@ -327,8 +370,7 @@ namespace strumpack {
       // destination rank is:
       //  ((r / B) % prows) + ((c / B) % pcols) * prows
       //  = pr[r] + pc[c]
-      auto pr = new int[CB.lrows()+CB.lcols()];
-      auto pc = pr + CB.lrows();
+      std::vector<int> pr(lrows), pc(lcols);
       int r_upd;
       for (r_upd=0; r_upd<lrows; r_upd++) {
         auto t = I[CB.rowl2g_fixed(r_upd)];
@@ -339,21 +381,17 @@ namespace strumpack {
         pr[r] = ((I[CB.rowl2g_fixed(r)]-pa_sep) / B) % prows;
       for (int c=0; c<lcols; c++)
         pc[c] = ((CB.coll2g_fixed(c) / B) % pcols) * prows;
-      { // reserve space for the send buffers
-        std::vector<std::size_t> cnt(sbuf.size());
-        for (int c=0; c<lcols; c++)
-          for (int r=0; r<lrows; r++)
-            cnt[pr[r]+pc[c]]++;
-        for (std::size_t p=0; p<sbuf.size(); p++)
-          sbuf[p].reserve(sbuf[p].size()+cnt[p]);
-      }
+      RowMap R1(r_upd, [](int r) { return r; },
+                [&](int r) { return pr[r]; });
+      RowMap R2(lrows-r_upd, [&](int r) { return r_upd+r; },
+                [&](int r) { return pr[r_upd+r]; });
+      std::vector<Column<const scalar_t>> cols;
+      cols.reserve(2*lcols);
       for (int c=0; c<lcols; c++) // b
-        for (int r=0; r<r_upd; r++)
-          sbuf[pr[r]+pc[c]].push_back(CB(r,c));
+        cols.push_back({&R1, CB.data()+c*CB.ld(), pc[c]});
       for (int c=0; c<lcols; c++) // bupd
-        for (int r=r_upd; r<lrows; r++)
-          sbuf[pr[r]+pc[c]].push_back(CB(r,c));
-      delete[] pr;
+        cols.push_back({&R2, CB.data()+c*CB.ld(), pc[c]});
+      pack(cols, sbuf);
     }
 
     static void extend_add_column_seq_copy_to_buffers
@@ -362,38 +400,33 @@ namespace strumpack {
      const FrontalMatrix<scalar_t,integer_t>* ch) {
       std::size_t u2s;
       const auto I = ch->upd_to_parent(pa, u2s);
-      const std::size_t du = ch->dim_upd();
+      const int du = ch->dim_upd();
       const std::size_t ds = pa->dim_sep();
-      const auto cols = CB.cols();
-      const auto pr = new int[CB.rows()+cols];
-      const auto pc = pr + CB.rows();
+      const int cols = CB.cols();
       const auto prows = pa->grid()->nprows();
       const auto pcols = pa->grid()->npcols();
       const auto B = DistM_t::default_MB;
       // destination rank is:
       //  ((r / B) % prows) + ((c / B) % pcols) * prows
       //  = pr[r] + pc[c]
+      std::vector<int> pr(du), pc(cols);
       for (std::size_t r=0; r<u2s; r++)
         pr[r] = (I[r] / B) % prows;
-      for (std::size_t r=u2s; r<du; r++)
+      for (int r=u2s; r<du; r++)
         pr[r] = ((I[r]-ds) / B) % prows;
-      for (std::size_t c=0; c<cols; c++)
+      for (int c=0; c<cols; c++)
         pc[c] = ((c / B) % pcols) * prows;
-      { // reserve space for the send buffers
-        std::vector<std::size_t> cnt(sbuf.size());
-        for (std::size_t c=0; c<cols; c++)
-          for (std::size_t r=0; r<du; r++)
-            cnt[pr[r]+pc[c]]++;
-        for (std::size_t p=0; p<sbuf.size(); p++)
-          sbuf[p].reserve(sbuf[p].size()+cnt[p]);
-      }
-      for (std::size_t c=0; c<cols; c++) // b
-        for (std::size_t r=0; r<u2s; r++)
-          sbuf[pr[r]+pc[c]].push_back(CB(r,c));
-      for (std::size_t c=0; c<cols; c++) // bupd
-        for (std::size_t r=u2s; r<du; r++)
-          sbuf[pr[r]+pc[c]].push_back(CB(r,c));
-      delete[] pr;
+      const int s = u2s;
+      RowMap R1(s, [](int r) { return r; }, [&](int r) { return pr[r]; });
+      RowMap R2(du-s, [&](int r) { return s+r; },
+                [&](int r) { return pr[s+r]; });
+      std::vector<Column<const scalar_t>> bcols;
+      bcols.reserve(2*cols);
+      for (int c=0; c<cols; c++) // b
+        bcols.push_back({&R1, CB.ptr(0,c), pc[c]});
+      for (int c=0; c<cols; c++) // bupd
+        bcols.push_back({&R2, CB.ptr(0,c), pc[c]});
+      pack(bcols, sbuf);
     }
 
     static void extend_add_column_seq_copy_from_buffers
@@ -406,8 +439,7 @@ namespace strumpack {
       const auto pa_upd = pa->upd();
       const auto pa_sep = pa->sep_begin();
       const auto lcols = b.lcols();
-      auto r_1 = new int[b.lrows()+bupd.lrows()];
-      auto r_2 = r_1 + b.lrows();
+      std::vector<int> r_1(b.lrows()), r_2(bupd.lrows());
       integer_t r_max_1 = 0, r_max_2 = 0;
       for (int r=0, ur=0; r<b.lrows(); r++) {
         auto fgr = b.rowl2g_fixed(r) + pa_sep;
@@ -423,13 +455,17 @@ namespace strumpack {
         if (ch_upd[ur] != fgr) continue;
         r_2[r_max_2++] = r;
       }
+      RowMap R1(r_max_1, [&](int r) { return r_1[r]; },
+                [](int) { return 0; });
+      RowMap R2(r_max_2, [&](int r) { return r_2[r]; },
+                [](int) { return 0; });
+      std::vector<Column<scalar_t>> cols;
+      cols.reserve(2*lcols);
       for (int c=0; c<lcols; c++)
-        for (int r=0; r<r_max_1; r++)
-          b(r_1[r],c) += *(pbuf++);
+        cols.push_back({&R1, b.data()+c*b.ld(), 0});
       for (int c=0; c<lcols; c++)
-        for (int r=0; r<r_max_2; r++)
-          bupd(r_2[r],c) += *(pbuf++);
-      delete[] r_1;
+        cols.push_back({&R2, bupd.data()+c*bupd.ld(), 0});
+      unpack(cols, &pbuf, true);
     }
 
     static void extend_add_column_copy_from_buffers
@@ -448,11 +484,8 @@ namespace strumpack {
       // source rank is
       //  ((r / B) % prows) + ((c / B) % pcols) * prows
       // where r,c is the coordinate in the F22 block of the child
-      auto upd_r_1 = new int[2*b.lrows()+2*bupd.lrows()+lcols];
-      auto upd_r_2 = upd_r_1 + b.lrows();
-      auto r_1 = upd_r_2 + bupd.lrows();
-      auto r_2 = r_1 + b.lrows();
-      auto upd_c_1 = r_2 + bupd.lrows();
+      std::vector<int> upd_r_1(b.lrows()), upd_r_2(bupd.lrows()),
+        r_1(b.lrows()), r_2(bupd.lrows()), upd_c_1(lcols);
       integer_t r_max_1 = 0, r_max_2 = 0;
       for (int r=0, ur=0; r<b.lrows(); r++) {
         auto fgr = b.rowl2g_fixed(r) + pa_sep;
@@ -473,13 +506,17 @@ namespace strumpack {
       }
       for (int c=0; c<lcols; c++)
         upd_c_1[c] = ((b.coll2g_fixed(c) / B) % pcols) * prows;
+      RowMap R1(r_max_1, [&](int r) { return r_1[r]; },
+                [&](int r) { return upd_r_1[r]; });
+      RowMap R2(r_max_2, [&](int r) { return r_2[r]; },
+                [&](int r) { return upd_r_2[r]; });
+      std::vector<Column<scalar_t>> cols;
+      cols.reserve(2*lcols);
       for (int c=0; c<lcols; c++)
-        for (int r=0; r<r_max_1; r++)
-          b(r_1[r],c) += *(pbuf[upd_r_1[r]+upd_c_1[c]]++);
+        cols.push_back({&R1, b.data()+c*b.ld(), upd_c_1[c]});
       for (int c=0; c<lcols; c++)
-        for (int r=0; r<r_max_2; r++)
-          bupd(r_2[r],c) += *(pbuf[upd_r_2[r]+upd_c_1[c]]++);
-      delete[] upd_r_1;
+        cols.push_back({&R2, bupd.data()+c*bupd.ld(), upd_c_1[c]});
+      unpack(cols, pbuf, true);
     }
 
 
@@ -496,27 +533,20 @@ namespace strumpack {
       const auto B = DistM_t::default_MB;
       const auto lrows = cSr.lrows();
       const auto lcols = cSr.lcols();
-      auto destr = new int[lrows+lcols];
-      auto destc = destr + lrows;
+      std::vector<int> destr(lrows), destc(lcols);
       for (int r=0; r<lrows; r++)
         destr[r] = (I[cSr.rowl2g_fixed(r)] / B) % prows;
       for (int c=0; c<lcols; c++)
         destc[c] = ((cSr.coll2g_fixed(c) / B) % pcols) * prows;
-      {
-        std::vector<std::size_t> cnt(sbuf.size());
-        for (int c=0; c<lcols; c++)
-          for (int r=0; r<lrows; r++)
-            cnt[destr[r]+destc[c]]++;
-        for (std::size_t p=0; p<sbuf.size(); p++)
-          sbuf[p].reserve(sbuf[p].size()+cnt[p]);
-      }
+      RowMap R(lrows, [](int r) { return r; },
+               [&](int r) { return destr[r]; });
+      std::vector<Column<const scalar_t>> cols;
+      cols.reserve(2*lcols);
       for (int c=0; c<lcols; c++)
-        for (int r=0; r<lrows; r++)
-          sbuf[destr[r]+destc[c]].push_back(cSr(r,c));
+        cols.push_back({&R, cSr.data()+c*cSr.ld(), destc[c]});
       for (int c=0; c<lcols; c++)
-        for (int r=0; r<lrows; r++)
-          sbuf[destr[r]+destc[c]].push_back(cSc(r,c));
-      delete[] destr;
+        cols.push_back({&R, cSc.data()+c*cSc.ld(), destc[c]});
+      pack(cols, sbuf);
     }
 
     static void skinny_extend_add_copy_from_buffers
@@ -535,9 +565,7 @@ namespace strumpack {
       const auto prows = ch->grid()->nprows();
       const auto pcols = ch->grid()->npcols();
       const auto B = DistM_t::default_MB;
-      auto lr = new int[2*lrows+lcols];
-      auto srcr = lr + Sr.lrows();
-      auto srcc = srcr + Sr.lrows();
+      std::vector<int> lr(lrows), srcr(lrows), srcc(lcols);
       for (int c=0; c<lcols; c++)
         srcc[c] = ((Sr.coll2g_fixed(c) / B) % pcols) * prows;
       integer_t rmax = 0;
@@ -550,13 +578,15 @@ namespace strumpack {
         lr[rmax] = r;
         srcr[rmax++] = (ur / B) % prows;
       }
+      RowMap R(rmax, [&](int r) { return lr[r]; },
+               [&](int r) { return srcr[r]; });
+      std::vector<Column<scalar_t>> cols;
+      cols.reserve(2*lcols);
       for (int c=0; c<lcols; c++)
-        for (int r=0; r<rmax; r++)
-          Sr(lr[r],c) += *(pbuf[srcr[r]+srcc[c]]++);
+        cols.push_back({&R, Sr.data()+c*Sr.ld(), srcc[c]});
       for (int c=0; c<lcols; c++)
-        for (int r=0; r<rmax; r++)
-          Sc(lr[r],c) += *(pbuf[srcr[r]+srcc[c]]++);
-      delete[] lr;
+        cols.push_back({&R, Sc.data()+c*Sc.ld(), srcc[c]});
+      unpack(cols, pbuf, true);
     }
 
 
@@ -573,24 +603,18 @@ namespace strumpack {
       const auto prows = B.nprows();
       const auto pcols = B.npcols();
       const auto MB = DistM_t::default_MB;
-      auto destr = new int[lrows+lcols];
-      auto destc = destr + lrows;
+      std::vector<int> destr(lrows), destc(lcols);
       for (int r=0; r<lrows; r++)
         destr[r] = (I[F.rowl2g_fixed(r)] / MB) % prows;
       for (int c=0; c<lcols; c++)
         destc[c] = ((J[F.coll2g_fixed(c)] / MB) % pcols) * prows;
-      {
-        std::vector<std::size_t> cnt(sbuf.size());
-        for (int c=0; c<lcols; c++)
-          for (int r=0; r<lrows; r++)
-            cnt[destr[r]+destc[c]]++;
-        for (std::size_t p=0; p<sbuf.size(); p++)
-          sbuf[p].reserve(sbuf[p].size()+cnt[p]);
-      }
+      RowMap R(lrows, [](int r) { return r; },
+               [&](int r) { return destr[r]; });
+      std::vector<Column<const scalar_t>> cols;
+      cols.reserve(lcols);
       for (int c=0; c<lcols; c++)
-        for (int r=0; r<lrows; r++)
-          sbuf[destr[r]+destc[c]].push_back(F(r,c));
-      delete[] destr;
+        cols.push_back({&R, F.data()+c*F.ld(), destc[c]});
+      pack(cols, sbuf);
     }
 
     static void extend_copy_from_buffers
@@ -602,25 +626,18 @@ namespace strumpack {
       const auto prows = B.nprows();
       const auto pcols = B.npcols();
       const auto MB = DistM_t::default_MB;
-      auto srcr = new int[2*oI.size()];
-      auto lr = srcr + oI.size();
-      for (std::size_t r=0; r<oI.size(); r++) {
-        srcr[r] = (r / MB) % prows;
-        auto gr = oI[r];
-        if (F.rowg2p_fixed(gr) == F.prow())
-          lr[r] = F.rowg2l_fixed(gr);
-        else lr[r] = -1;
-      }
+      RowMap R(oI.size(), [&](int r) { return F.rowg2l_fixed(oI[r]); },
+               [&](int r) {
+                 return (F.rowg2p_fixed(oI[r]) == F.prow()) ?
+                   int((r / MB) % prows) : -1; });
+      std::vector<Column<scalar_t>> cols;
       for (std::size_t c=0; c<oJ.size(); c++) {
         auto gc = oJ[c];
         if (F.colg2p_fixed(gc) != F.pcol()) continue;
-        auto lc = F.colg2l_fixed(gc);
-        auto srcc = ((c / MB) % pcols) * prows;
-        for (std::size_t r=0; r<oI.size(); r++)
-          if (lr[r] != -1)
-            F(lr[r],lc) += *(pbuf[srcr[r]+srcc]++);
+        cols.push_back({&R, F.data()+F.colg2l_fixed(gc)*F.ld(),
+                        int(((c / MB) % pcols) * prows)});
       }
-      delete[] srcr;
+      unpack(cols, pbuf.data(), true);
     }
 
     static void extract_column_copy_to_buffers
@@ -638,11 +655,8 @@ namespace strumpack {
       const std::size_t blcols = b.lcols();
       const std::size_t blrows = b.lrows();
       const std::size_t ulrows = bupd.lrows();
-      auto pb = new int[2*blrows+2*ulrows+blcols];
-      auto rb = pb + blrows;
-      auto pu = rb + blrows;
-      auto ru = pu + ulrows;
-      auto pc = ru + ulrows;
+      std::vector<int> pb(blrows), rb(blrows), pu(ulrows), ru(ulrows),
+        pc(blcols);
       std::size_t ur = 0, brmax = 0, urmax = 0;
       for (std::size_t r=0, ur=0; r<blrows; r++) {
         const std::size_t gr = b.rowl2g_fixed(r);
@@ -663,24 +677,17 @@ namespace strumpack {
       }
       for (std::size_t c=0; c<blcols; c++)
         pc[c] = ((b.coll2g_fixed(c) / B) % pcols) * prows;
-      {
-        std::vector<std::size_t> cnt(sbuf.size());
-        for (std::size_t c=0; c<blcols; c++) {
-          for (std::size_t r=0; r<brmax; r++)
-            cnt[pb[r]+pc[c]]++;
-          for (std::size_t r=0; r<urmax; r++)
-            cnt[pu[r]+pc[c]]++;
-        }
-        for (std::size_t p=0; p<sbuf.size(); p++)
-          sbuf[p].reserve(sbuf[p].size()+cnt[p]);
-      }
+      RowMap Rb(brmax, [&](int r) { return rb[r]; },
+                [&](int r) { return pb[r]; });
+      RowMap Ru(urmax, [&](int r) { return ru[r]; },
+                [&](int r) { return pu[r]; });
+      std::vector<Column<const scalar_t>> cols;
+      cols.reserve(2*blcols);
       for (std::size_t c=0; c<blcols; c++) {
-        for (std::size_t r=0; r<brmax; r++)
-          sbuf[pb[r]+pc[c]].push_back(b(rb[r],c));
-        for (std::size_t r=0; r<urmax; r++)
-          sbuf[pu[r]+pc[c]].push_back(bupd(ru[r],c));
+        cols.push_back({&Rb, b.data()+c*b.ld(), pc[c]});
+        cols.push_back({&Ru, bupd.data()+c*bupd.ld(), pc[c]});
       }
-      delete[] pb;
+      pack(cols, sbuf);
     }
 
     static void extract_column_seq_copy_to_buffers
@@ -721,8 +728,6 @@ namespace strumpack {
       delete[] rb;
     }
 
-
-    // TODO optimize loops
     static void extract_column_copy_from_buffers
     (DistM_t& CB, std::vector<scalar_t*>& pbuf,
      const FrontalMatrixMPI<scalar_t,integer_t>* pa,
@@ -732,18 +737,19 @@ namespace strumpack {
       const auto pcols = pa->grid()->npcols();
       const auto B = DistM_t::default_MB;
       const auto pa_dim_sep = pa->dim_sep();
-      for (int c=0; c<CB.lcols(); c++) {
-        const auto pc = ((CB.coll2g_fixed(c) / B) % pcols) * prows;
-        for (int r=0; r<CB.lrows(); r++) {
-          integer_t gr = I[CB.rowl2g_fixed(r)];
-          if (gr >= pa_dim_sep) gr -= pa_dim_sep;
-          auto pr = (gr / B) % prows;
-          CB(r,c) = *(pbuf[pr+pc]++);
-        }
-      }
+      RowMap R(CB.lrows(), [](int r) { return r; },
+               [&](int r) {
+                 integer_t gr = I[CB.rowl2g_fixed(r)];
+                 if (gr >= pa_dim_sep) gr -= pa_dim_sep;
+                 return int((gr / B) % prows); });
+      std::vector<Column<scalar_t>> cols;
+      cols.reserve(CB.lcols());
+      for (int c=0; c<CB.lcols(); c++)
+        cols.push_back({&R, CB.data()+c*CB.ld(),
+                        int(((CB.coll2g_fixed(c) / B) % pcols) * prows)});
+      unpack(cols, pbuf.data(), false);
     }
 
-    // TODO optimize loops
     static void extract_column_seq_copy_from_buffers
     (DenseM_t& CB, std::vector<scalar_t*>& pbuf,
      const FrontalMatrixMPI<scalar_t,integer_t>* pa,
@@ -753,20 +759,20 @@ namespace strumpack {
       const auto pcols = pa->grid()->npcols();
       const auto B = DistM_t::default_MB;
       const auto pa_dim_sep = pa->dim_sep();
-      for (std::size_t c=0; c<CB.cols(); c++) {
-        const auto pc = ((c / B) % pcols) * prows;
-        for (std::size_t r=0; r<CB.rows(); r++) {
-          integer_t gr = I[r];
-          if (gr >= pa_dim_sep) gr -= pa_dim_sep;
-          auto pr = (gr / B) % prows;
-          CB(r,c) = *(pbuf[pr+pc]++);
-        }
-      }
+      RowMap R(CB.rows(), [](int r) { return r; },
+               [&](int r) {
+                 integer_t gr = I[r];
+                 if (gr >= pa_dim_sep) gr -= pa_dim_sep;
+                 return int((gr / B) % prows); });
+      std::vector<Column<scalar_t>> cols;
+      cols.reserve(CB.cols());
+      for (std::size_t c=0; c<CB.cols(); c++)
+        cols.push_back({&R, CB.ptr(0,c), int(((c / B) % pcols) * prows)});
+      unpack(cols, pbuf.data(), false);
     }
 
 
 
-    // TODO optimize loops!!
     static void extract_copy_to_buffers
     (const DistM_t& F, const std::vector<std::size_t>& I,
      const std::vector<std::size_t>& J,
@@ -774,30 +780,25 @@ namespace strumpack {
      const std::vector<std::size_t>& oJ,
      const DistM_t& B, std::vector<std::vector<scalar_t>>& sbuf) {
       if (!F.active()) return;
-      if (F.fixed()) {
-        for (std::size_t c=0; c<J.size(); c++) {
-          auto gc = J[c];
-          if (F.colg2p_fixed(gc) != F.pcol()) continue;
-          auto lc = F.colg2l_fixed(gc);
-          for (std::size_t r=0; r<I.size(); r++) {
-            auto gr = I[r];
-            if (F.rowg2p_fixed(gr) == F.prow())
-              sbuf[B.rank_fixed(oI[r],oJ[c])].
-                push_back(F(F.rowg2l_fixed(gr),lc));
-          }
-        }
-      } else {
-        for (std::size_t c=0; c<J.size(); c++) {
-          auto gc = J[c];
-          if (F.colg2p(gc) != F.pcol()) continue;
-          auto lc = F.colg2l(gc);
-          for (std::size_t r=0; r<I.size(); r++) {
-            auto gr = I[r];
-            if (F.rowg2p(gr) == F.prow())
-              sbuf[B.rank(oI[r],oJ[c])].push_back(F(F.rowg2l(gr),lc));
-          }
-        }
+      const bool fixed = F.fixed();
+      const auto prows = B.nprows();
+      RowMap R(I.size(), [&](int r) {
+          return fixed ? F.rowg2l_fixed(I[r]) : F.rowg2l(I[r]); },
+        [&](int r) {
+          if ((fixed ? F.rowg2p_fixed(I[r]) : F.rowg2p(I[r])) != F.prow())
+            return -1;
+          return fixed ? B.rowg2p_fixed(oI[r]) : B.rowg2p(oI[r]); });
+      std::vector<Column<const scalar_t>> cols;
+      for (std::size_t c=0; c<J.size(); c++) {
+        auto gc = J[c];
+        if ((fixed ? F.colg2p_fixed(gc) : F.colg2p(gc)) != F.pcol())
+          continue;
+        auto lc = fixed ? F.colg2l_fixed(gc) : F.colg2l(gc);
+        cols.push_back
+          ({&R, F.data()+lc*F.ld(),
+            (fixed ? B.colg2p_fixed(oJ[c]) : B.colg2p(oJ[c])) * prows});
       }
+      pack(cols, sbuf);
     }
 
     static void extract_copy_from_buffers
@@ -805,31 +806,223 @@ namespace strumpack {
      std::vector<std::size_t>& oI, std::vector<std::size_t>& oJ,
      const DistM_t& B, std::vector<scalar_t*>& pbuf) {
       if (!F.active()) return;
-      if (F.fixed()) {
-        for (std::size_t c=0; c<oJ.size(); c++) {
-          auto gc = oJ[c];
-          if (F.colg2p_fixed(gc) != F.pcol()) continue;
-          auto lc = F.colg2l_fixed(gc);
-          for (std::size_t r=0; r<oI.size(); r++) {
-            auto gr = oI[r];
-            if (F.rowg2p_fixed(gr) == F.prow())
-              F(F.rowg2l_fixed(gr),lc) += *(pbuf[B.rank_fixed(I[r], J[c])]++);
+      const bool fixed = F.fixed();
+      const auto prows = B.nprows();
+      RowMap R(oI.size(), [&](int r) {
+          return fixed ? F.rowg2l_fixed(oI[r]) : F.rowg2l(oI[r]); },
+        [&](int r) {
+          if ((fixed ? F.rowg2p_fixed(oI[r]) : F.rowg2p(oI[r])) != F.prow())
+            return -1;
+          return fixed ? B.rowg2p_fixed(I[r]) : B.rowg2p(I[r]); });
+      std::vector<Column<scalar_t>> cols;
+      for (std::size_t c=0; c<oJ.size(); c++) {
+        auto gc = oJ[c];
+        if ((fixed ? F.colg2p_fixed(gc) : F.colg2p(gc)) != F.pcol())
+          continue;
+        auto lc = fixed ? F.colg2l_fixed(gc) : F.colg2l(gc);
+        cols.push_back
+          ({&R, F.data()+lc*F.ld(),
+            (fixed ? B.colg2p_fixed(J[c]) : B.colg2p(J[c])) * prows});
+      }
+      unpack(cols, pbuf.data(), true);
+    }
+
+  private:
+    /**
+     * A list of local rows of a block, with for each row the part of
+     * the rank it is sent to, or received from, that depends only on
+     * the row. Rows with a negative rank are skipped. Consecutive
+     * local rows that go to the same rank are grouped in runs, which
+     * are copied at once, and the number of rows per rank is
+     * counted, so that the buffer offsets for a column can be
+     * computed without touching the data.
+     */
+    class RowMap {
+    public:
+      template<typename LR, typename PR> RowMap(int n, LR lr, PR pr) {
+        std::vector<int> slot_of;
+        for (int i=0; i<n; i++) {
+          int p = pr(i);
+          if (p < 0) continue;
+          int l = lr(i);
+          if (p >= int(slot_of.size())) slot_of.resize(p+1, -1);
+          if (slot_of[p] == -1) {
+            slot_of[p] = rank.size();
+            rank.push_back(p);
+            cnt.push_back(0);
           }
-        }
-      } else {
-        for (std::size_t c=0; c<oJ.size(); c++) {
-          auto gc = oJ[c];
-          if (F.colg2p(gc) != F.pcol()) continue;
-          auto lc = F.colg2l(gc);
-          for (std::size_t r=0; r<oI.size(); r++) {
-            auto gr = oI[r];
-            if (F.rowg2p(gr) == F.prow())
-              F(F.rowg2l(gr),lc) += *(pbuf[B.rank(I[r], J[c])]++);
+          int s = slot_of[p];
+          cnt[s]++;
+          if (!start.empty() && slot.back() == s &&
+              start.back() + len.back() == l)
+            len.back()++;
+          else {
+            start.push_back(l);
+            len.push_back(1);
+            slot.push_back(s);
           }
         }
       }
+      // for every distinct rank: the rank and the number of rows
+      std::vector<int> rank;
+      std::vector<std::size_t> cnt;
+      // for every run: first local row, length and index in rank
+      std::vector<int> start, len, slot;
+
+      /**
+       * For every run, the number of rows in the earlier runs that
+       * go to the same rank, ie, the offset of the run in the data
+       * of a column for that rank.
+       */
+      std::vector<std::size_t> run_offsets() const {
+        std::vector<std::size_t> roff(start.size()), c(rank.size());
+        for (std::size_t i=0; i<start.size(); i++) {
+          roff[i] = c[slot[i]];
+          c[slot[i]] += len[i];
+        }
+        return roff;
+      }
+    };
+
+    /**
+     * A column of a block, with its rows described by a RowMap, and
+     * the part of the rank that depends on the column.
+     */
+    template<typename T> struct Column {
+      const RowMap* rows;
+      T* data;
+      int rank;
+    };
+
+    /**
+     * Append the columns, in order, to the send buffers. Element
+     * rows.start[i]+j of a column goes to rank rows.rank[s]+rank,
+     * with s = rows.slot[i]. The first pass computes, for every
+     * column and every rank it sends to, the offset in the send
+     * buffer, and sizes the buffers. The second pass copies the runs
+     * of rows, the columns are independent and are copied in
+     * parallel. This is linear in the number of elements and
+     * columns, independent of the number of ranks.
+     */
+    static void pack
+    (const std::vector<Column<const scalar_t>>& cols,
+     std::vector<std::vector<scalar_t>>& sbuf) {
+      const std::size_t nc = cols.size();
+      std::vector<std::size_t> first, off;
+      pack_offsets(cols, sbuf, first, off);
+#pragma omp parallel for schedule(static) if(params::num_threads != 1)
+      for (std::size_t k=0; k<nc; k++) {
+        const auto& R = *cols[k].rows;
+        const auto d = cols[k].data;
+        auto o = off.data() + first[k];
+        for (std::size_t i=0; i<R.start.size(); i++) {
+          auto s = R.slot[i];
+          std::copy(d+R.start[i], d+R.start[i]+R.len[i],
+                    sbuf[R.rank[s]+cols[k].rank].data()+o[s]);
+          o[s] += R.len[i];
+        }
+      }
     }
 
+    /**
+     * First pass of pack: off[first[k]+s] is the offset in the send
+     * buffer of rank cols[k].rows->rank[s]+cols[k].rank where column
+     * k starts, and the send buffers are resized.
+     */
+    static void pack_offsets
+    (const std::vector<Column<const scalar_t>>& cols,
+     std::vector<std::vector<scalar_t>>& sbuf,
+     std::vector<std::size_t>& first, std::vector<std::size_t>& off) {
+      const std::size_t nc = cols.size();
+      std::vector<std::size_t> pos(sbuf.size());
+      first.assign(nc+1, 0);
+      for (std::size_t p=0; p<sbuf.size(); p++)
+        pos[p] = sbuf[p].size();
+      for (std::size_t k=0; k<nc; k++)
+        first[k+1] = first[k] + cols[k].rows->rank.size();
+      off.resize(first[nc]);
+      for (std::size_t k=0; k<nc; k++) {
+        const auto& R = *cols[k].rows;
+        for (std::size_t s=0; s<R.rank.size(); s++) {
+          auto& p = pos[R.rank[s]+cols[k].rank];
+          off[first[k]+s] = p;
+          p += R.cnt[s];
+        }
+      }
+      for (std::size_t p=0; p<sbuf.size(); p++)
+        sbuf[p].resize(pos[p]);
+    }
+
+    /**
+     * Destinations for the extend-add from a sequential child ch to
+     * the distributed parent pa. The first u2s rows (columns) of the
+     * contribution block map to F11/F12 (F11/F21) of the parent. Row
+     * (column) i of the contribution block goes to a rank pr[i]+pc[j]
+     * of the grid of pa.
+     */
+    static void seq_destinations
+    (const FrontalMatrixMPI<scalar_t,integer_t>* pa,
+     const FrontalMatrix<scalar_t,integer_t>* ch,
+     int& u2s, std::vector<int>& pr, std::vector<int>& pc) {
+      std::size_t s;
+      const auto I = ch->upd_to_parent
+        (static_cast<const FrontalMatrix<scalar_t,integer_t>*>(pa), s);
+      u2s = s;
+      const int du = ch->dim_upd();
+      const std::size_t ds = pa->dim_sep();
+      const auto prows = pa->grid()->nprows();
+      const auto pcols = pa->grid()->npcols();
+      const auto B = DistM_t::default_MB;
+      // destination rank is:
+      //  ((r / B) % prows) + ((c / B) % pcols) * prows
+      //  = pr[r] + pc[c]
+      pr.resize(du);
+      pc.resize(du);
+      for (int i=0; i<du; i++) {
+        auto Ii = (i < u2s) ? I[i] : I[i] - ds;
+        pr[i] = (Ii / B) % prows;
+        pc[i] = ((Ii / B) % pcols) * prows;
+      }
+    }
+
+    /**
+     * Read the columns, in order, from the receive buffers, pbuf[p]
+     * points to the data from rank p, and is advanced past the data
+     * that is read. Element rows.start[i]+j of a column comes from
+     * rank rows.rank[s]+rank, with s = rows.slot[i], and is either
+     * added to the column or copied. Two passes, as for pack.
+     */
+    static void unpack
+    (const std::vector<Column<scalar_t>>& cols, scalar_t** pbuf, bool add) {
+      const std::size_t nc = cols.size();
+      std::vector<std::size_t> first(nc+1);
+      for (std::size_t k=0; k<nc; k++)
+        first[k+1] = first[k] + cols[k].rows->rank.size();
+      std::vector<const scalar_t*> off(first[nc]);
+      for (std::size_t k=0; k<nc; k++) {
+        const auto& R = *cols[k].rows;
+        for (std::size_t s=0; s<R.rank.size(); s++) {
+          auto& p = pbuf[R.rank[s]+cols[k].rank];
+          off[first[k]+s] = p;
+          p += R.cnt[s];
+        }
+      }
+#pragma omp parallel for schedule(static) if(params::num_threads != 1)
+      for (std::size_t k=0; k<nc; k++) {
+        const auto& R = *cols[k].rows;
+        const auto d = cols[k].data;
+        auto o = off.data() + first[k];
+        for (std::size_t i=0; i<R.start.size(); i++) {
+          auto s = R.slot[i];
+          auto dst = d + R.start[i];
+          const auto src = o[s];
+          if (add)
+            for (int j=0; j<R.len[i]; j++) dst[j] += src[j];
+          else std::copy(src, src+R.len[i], dst);
+          o[s] += R.len[i];
+        }
+      }
+    }
   };
 
 
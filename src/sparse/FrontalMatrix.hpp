@@ -33,12 +33,15 @@
 #include <algorithm>
 #include <random>
 #include <vector>
+#include <array>
 
 #include "misc/TaskTimer.hpp"
 #include "StrumpackParameters.hpp"
 #include "CompressedSparseMatrix.hpp"
 #include "MatrixReordering.hpp"
 #include "HSS/HSSMatrix.hpp"
+#include "CBWorkspace.hpp"
+#include "SolveWorkspace.hpp"
 #if defined(STRUMPACK_USE_MPI)
 #include "ExtendAdd.hpp"
 #endif
@@ -52,6 +55,22 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> class ExtendAdd;
 #endif
 
+  /**
+   * Entry (i,j) of the inverse of the factored matrix, requested
+   * from the selected inversion, see
+   * FrontalMatrix::selected_inversion. The indices i and j are in the
+   * ordering of the factors, pos is the position of this entry in
+   * the list of requested entries and v will hold the value.
+   */
+  template<typename scalar_t,typename integer_t> struct InverseEntry {
+    integer_t i, j;
+    std::size_t pos;
+    scalar_t v;
+    /** the entry is computed in the front with first() in its
+        separator */
+    integer_t first() const { return std::min(i, j); }
+  };
+
   template<typename scalar_t,typename integer_t> class FrontalMatrix {
     using DenseM_t = DenseMatrix<scalar_t>;
     using DenseMW_t = DenseMatrixWrapper<scalar_t>;
@@ -91,21 +110,75 @@ namespace strumpack {
     virtual void multifrontal_factorization
     (const SpMat_t& A, const SPOptions<scalar_t>& opts,
      int etree_level=0, int task_depth=0) = 0;
+    /**
+     * Factor only this front, assuming both children have already
+     * been factored. This is what the DAG scheduler in
+     * EliminationTree calls for every front above the sequential
+     * subtrees. Distributed memory fronts are never scheduled this
+     * way, so they do not need to implement it.
+     */
+    virtual void factor_node
+    (const SpMat_t& /*A*/, const SPOptions<scalar_t>& /*opts*/,
+     int /*etree_level*/=0, int /*task_depth*/=0) {}
 
-    void multifrontal_solve(DenseM_t& b) const;
+    /**
+     * Forward and backward solve with the factors of this front and
+     * all its descendants. The work memory is taken from ws, which is
+     * set up again (see setup_solve_workspace) if it was prepared for
+     * a different number of right-hand sides or task recursion cutoff
+     * level. This records the layout of ws in the fronts, so only one
+     * solve with this tree can run at a time, see
+     * EliminationTree::multifrontal_solve.
+     */
+    void multifrontal_solve
+    (DenseM_t& b, SolveWorkspace<scalar_t>& ws,
+     const SolvePruning* prune=nullptr) const;
+    /**
+     * Set in prune which fronts of this subtree the backward solve
+     * visits, when only the rows sol_rows (sorted, in the ordering of
+     * the factors) of the solution are needed, or all rows if
+     * sol_rows is empty. These are the fronts with a row from
+     * sol_rows in their subtree, i.e., the paths from those rows to
+     * the root. Returns whether the subtree of this front needs the
+     * backward solve.
+     */
+    bool prune_backward
+    (const std::vector<integer_t>& sol_rows, SolvePruning& prune) const;
+    /**
+     * Set in prune which fronts of this subtree the forward solve
+     * visits, for a right-hand side which is only nonzero in rows
+     * rhs_rows (sorted, in the ordering of the factors): the fronts
+     * with a row from rhs_rows in their subtree. This should be
+     * called after prune_backward. Returns whether the subtree of
+     * this front needs the forward solve.
+     */
+    bool prune_forward
+    (const std::vector<integer_t>& rhs_rows, SolvePruning& prune) const;
+    /**
+     * Add the work stacks needed to solve with this front as root to
+     * ws, for nrhs right-hand sides. This only depends on the tree
+     * structure, so ws can be reused as long as nrhs does not change.
+     */
+    void setup_solve_workspace
+    (SolveWorkspace<scalar_t>& ws, std::size_t nrhs) const;
+    /**
+     * Forward/backward solve with the factors of this front and all
+     * its descendants, only visiting the children that are marked
+     * in prune, if prune is not null.
+     */
     virtual void forward_multifrontal_solve
-    (DenseM_t& b, DenseM_t* work, int etree_level=0,
-     int task_depth=0) const {};
+    (DenseM_t& /*b*/, DenseM_t* /*work*/, const SolvePruning* /*prune*/,
+     int /*etree_level*/=0, int /*task_depth*/=0) const {};
     virtual void backward_multifrontal_solve
-    (DenseM_t& y, DenseM_t* work, int etree_level=0,
-     int task_depth=0) const {};
+    (DenseM_t& /*y*/, DenseM_t* /*work*/, const SolvePruning* /*prune*/,
+     int /*etree_level*/=0, int /*task_depth*/=0) const {};
 
     void fwd_solve_phase1
     (DenseM_t& b, DenseM_t& bupd, DenseM_t* work,
-     int etree_level, int task_depth) const;
+     const SolvePruning* prune, int etree_level, int task_depth) const;
     void bwd_solve_phase2
     (DenseM_t& y, DenseM_t& yupd, DenseM_t* work,
-     int etree_level, int task_depth) const;
+     const SolvePruning* prune, int etree_level, int task_depth) const;
 
     virtual void extend_add_to_dense
     (DenseM_t& paF11, DenseM_t& paF12, DenseM_t& paF21, DenseM_t& paF22,
@@ -119,6 +192,43 @@ namespace strumpack {
     virtual void extract_CB_sub_matrix
     (const std::vector<std::size_t>& I, const std::vector<std::size_t>& J,
      DenseM_t& B, int task_depth) const = 0;
+    /**
+     * Add CB(I[k],J[k]) to B[k] for all blocks k, where I and J are
+     * global indices, as in extract_CB_sub_matrix. By default this
+     * extracts block per block.
+     */
+    virtual void extract_CB_sub_matrix_blocks
+    (const std::vector<std::vector<std::size_t>>& I,
+     const std::vector<std::vector<std::size_t>>& J,
+     std::vector<DenseMW_t>& B, int task_depth) const {
+      for (std::size_t k=0; k<I.size(); k++)
+        extract_CB_sub_matrix(I[k], J[k], B[k], task_depth);
+    }
+
+    /**
+     * Selected inversion of the factored matrix, top down from this
+     * front. [begin,end) are the requested entries of the inverse Z
+     * in the subtree of this front, sorted by InverseEntry::first().
+     * paZ is the block of Z corresponding to the parent front, of
+     * size pa->dim_blk(), which is used to get Z(upd,upd) of this
+     * front. Returns false if an entry is not in the sparsity
+     * pattern of the factors, or if a front on the path to one of
+     * the entries does not support selected inversion.
+     */
+    bool selected_inversion
+    (InverseEntry<scalar_t,integer_t>* begin,
+     InverseEntry<scalar_t,integer_t>* end,
+     const DenseM_t* paZ, const F_t* pa, int task_depth) const;
+    /**
+     * Compute the block Z of the inverse corresponding to this front,
+     * of size dim_blk(), from Zuu = Z(upd,upd) and the factors of
+     * this front. This is not supported by default.
+     */
+    virtual bool inverse_front
+    (const DenseM_t& /*Zuu*/, DenseM_t& /*Z*/,
+     int /*task_depth*/) const {
+      return false;
+    }
 
     void extend_add_b
     (DenseM_t& b, DenseM_t& bupd, const DenseM_t& CB, const F_t* pa) const;
@@ -126,9 +236,16 @@ namespace strumpack {
     (const DenseM_t& y, const DenseM_t& yupd, DenseM_t& CB, const F_t* pa) const;
 
     virtual integer_t maximum_rank(int task_depth=0) const { return 0; }
+    /**
+     * Rank of the compressed representation of this front only, not
+     * including its descendants. This is 0 for dense fronts.
+     */
+    virtual integer_t front_rank() const { return 0; }
     virtual long long factor_nonzeros(int task_depth=0) const;
     virtual long long dense_factor_nonzeros(int task_depth=0) const;
+    void factor_nonzeros_by_type(std::array<long long,3>& nnz) const;
     virtual bool isHSS() const { return false; }
+    virtual bool isBLR() const { return false; }
     virtual bool isMPI() const { return false; }
     virtual void print_rank_statistics(std::ostream &out) const {}
     virtual std::string type() const { return "FrontalMatrix"; }
@@ -153,6 +270,8 @@ namespace strumpack {
 
     void set_lchild(std::unique_ptr<F_t> ch) { lchild_ = std::move(ch); }
     void set_rchild(std::unique_ptr<F_t> ch) { rchild_ = std::move(ch); }
+    F_t* lchild() const { return lchild_.get(); }
+    F_t* rchild() const { return rchild_.get(); }
 
     // TODO compute this (and levels) once, store it
     // maybe compute it when setting pointers to the children
@@ -166,6 +285,36 @@ namespace strumpack {
 
     virtual int P() const { return 1; }
 
+    /**
+     * Collect the fronts that are the root of a subtree which will be
+     * factored sequentially with its contribution blocks on a
+     * CBWorkspace stack. This follows the same task_depth logic as
+     * multifrontal_factorization. Fronts that do not use a stack
+     * (the default) just pass this on to their children.
+     */
+    virtual void find_CB_stack_roots
+    (std::vector<F_t*>& roots, bool pa_on_stack, int task_depth=0);
+    /**
+     * Number of scalars taken by the contribution block of this front
+     * when it is stored on a CBWorkspace.
+     */
+    virtual std::size_t CB_stack_size() const { return 0; }
+    /**
+     * Peak size of the CBWorkspace when factoring the subtree rooted
+     * at this front, including the contribution block of this front,
+     * unless this front is the root of the subtree (see
+     * set_CB_pool).
+     */
+    virtual std::size_t CB_stack_peak() const { return 0; }
+    virtual void set_CB_stack(CBWorkspace<scalar_t>* /*ws*/) {}
+    /**
+     * Make this front, one of the find_CB_stack_roots, take a stack
+     * from pool for the factorization of its subtree. Its own
+     * contribution block is not stored on the stack, since it is
+     * still needed after the subtree is factored.
+     */
+    virtual void set_CB_pool(CBWorkspacePool<scalar_t>* /*pool*/) {}
+
 
 #if defined(STRUMPACK_USE_MPI)
     void multifrontal_solve(DenseM_t& bloc, DistM_t* bdist) const;
@@ -229,6 +378,25 @@ namespace strumpack {
     std::unique_ptr<F_t> lchild_;
     std::unique_ptr<F_t> rchild_;
 
+    // work stack for the solve, only set for the fronts that start a
+    // new task in the solve, see setup_solve_workspace, written by
+    // the solve, which the EliminationTree serializes
+    mutable SolveWorkspace<scalar_t>* solve_ws_ = nullptr;
+    mutable int solve_stack_ = -1;
+
+    void setup_solve_workspace
+    (SolveWorkspace<scalar_t>& ws, std::vector<std::size_t>& rows,
+     int level, int task_depth) const;
+    DenseM_t* solve_work(std::size_t nrhs, std::vector<DenseM_t>& tmp) const;
+
+    void factor_children
+    (const SpMat_t& A, const SPOptions<scalar_t>& opts,
+     int etree_level, int task_depth);
+
+    static void inverse_front_dense
+    (const DenseM_t& F11, const std::vector<int>& piv, const DenseM_t& F12,
+     const DenseM_t& F21, const DenseM_t& Zuu, DenseM_t& Z, int task_depth);
+
   private:
     FrontalMatrix(const FrontalMatrix&) = delete;
     FrontalMatrix& operator=(FrontalMatrix const&) = delete;
@@ -335,149 +503,255 @@ namespace strumpack {
     return I;
   }
 
+  /**
+   * Assemble CB into [b(I^{sep});bupd] of the parent. The map from
+   * the upd indices of this front to the parent, see upd_to_parent,
+   * is merged on the fly, so this does not allocate.
+   */
   template<typename scalar_t,typename integer_t> inline void
   FrontalMatrix<scalar_t,integer_t>::extend_add_b
   (DenseM_t& b, DenseM_t& bupd, const DenseM_t& CB, const F_t* pa) const {
-    std::size_t upd2sep;
-    auto I = upd_to_parent(pa, upd2sep);
-    for (std::size_t c=0; c<b.cols(); c++) {
-      for (std::size_t r=0; r<upd2sep; r++)
-        b(I[r]+pa->sep_begin_, c) += CB(r, c);
-      for (std::size_t r=upd2sep; r<CB.rows(); r++) {
-        bupd(I[r]-pa->dim_sep(), c) += CB(r, c);
-      }
+    const std::size_t dupd = dim_upd(), nrhs = b.cols();
+    std::size_t r = 0;
+    for (; r<dupd; r++) {
+      auto up = upd_[r];
+      if (up >= pa->sep_end_) break;
+      for (std::size_t c=0; c<nrhs; c++)
+        b(up, c) += CB(r, c);
+    }
+    for (std::size_t t=0; r<dupd; r++) {
+      auto up = upd_[r];
+      while (pa->upd_[t] < up) t++;
+      for (std::size_t c=0; c<nrhs; c++)
+        bupd(t, c) += CB(r, c);
     }
-    // TODO adjust flops for multiple columns
     STRUMPACK_FLOPS
       ((is_complex<scalar_t>()?2:1)*
-       static_cast<long long int>(CB.rows()));
+       static_cast<long long int>(CB.rows()*nrhs));
     STRUMPACK_BYTES
       (sizeof(scalar_t)*static_cast<long long int>
-       (3*CB.rows())+sizeof(integer_t)*(CB.rows()+bupd.rows()));
+       (3*CB.rows()*nrhs)+sizeof(integer_t)*(CB.rows()+bupd.rows()));
   }
 
   /**
    * Assemble CB=b(I^{upd}) from [b(I^{sep});b(I^{upd})] of the
-   * parent.
+   * parent. Like extend_add_b, this does not allocate.
    */
   template<typename scalar_t,typename integer_t> inline void
   FrontalMatrix<scalar_t,integer_t>::extract_b
   (const DenseM_t& y, const DenseM_t& yupd, DenseM_t& CB, const F_t* pa) const {
-    std::size_t upd2sep;
-    auto I = upd_to_parent(pa, upd2sep);
-    for (std::size_t c=0; c<y.cols(); c++) {
-      for (std::size_t r=0; r<upd2sep; r++)
-        CB(r,c) = y(I[r]+pa->sep_begin_, c);
-      for (std::size_t r=upd2sep; r<CB.rows(); r++)
-        CB(r,c) = yupd(I[r]-pa->dim_sep(), c);
+    const std::size_t dupd = dim_upd(), nrhs = y.cols();
+    std::size_t r = 0;
+    for (; r<dupd; r++) {
+      auto up = upd_[r];
+      if (up >= pa->sep_end_) break;
+      for (std::size_t c=0; c<nrhs; c++)
+        CB(r, c) = y(up, c);
+    }
+    for (std::size_t t=0; r<dupd; r++) {
+      auto up = upd_[r];
+      while (pa->upd_[t] < up) t++;
+      for (std::size_t c=0; c<nrhs; c++)
+        CB(r, c) = yupd(t, c);
     }
-    // TODO adjust flops for multiple columns
     STRUMPACK_FLOPS
       ((is_complex<scalar_t>()?2:1)*
-       static_cast<long long int>(CB.rows()));
+       static_cast<long long int>(CB.rows()*nrhs));
     STRUMPACK_BYTES
       (sizeof(scalar_t)*static_cast<long long int>
-       (3*CB.rows())+sizeof(integer_t)*(CB.rows()+yupd.rows()));
+       (3*CB.rows()*nrhs)+sizeof(integer_t)*(CB.rows()+yupd.rows()));
   }
 
   template<typename scalar_t,typename integer_t> void
-  FrontalMatrix<scalar_t,integer_t>::multifrontal_solve(DenseM_t& b) const {
+  FrontalMatrix<scalar_t,integer_t>::setup_solve_workspace
+  (SolveWorkspace<scalar_t>& ws, std::size_t nrhs) const {
+    ws.reset(nrhs, params::task_recursion_cutoff_level);
+    std::vector<std::size_t> rows;
+    setup_solve_workspace(ws, rows, 0, 0);
+    solve_stack_ = ws.add_stack(std::move(rows));
+    solve_ws_ = &ws;
+  }
+
+  /**
+   * Record in rows[level] the largest dim_upd at this level of the
+   * current stack. This follows the task creation in
+   * fwd_solve_phase1 and bwd_solve_phase2: the left child continues
+   * on the stack of the parent, while a right child that is solved
+   * in a separate task gets a stack of its own.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::setup_solve_workspace
+  (SolveWorkspace<scalar_t>& ws, std::vector<std::size_t>& rows,
+   int level, int task_depth) const {
+    if (int(rows.size()) <= level) rows.resize(level+1, 0);
+    rows[level] = std::max(rows[level], std::size_t(dim_upd()));
+    solve_ws_ = nullptr;
+    solve_stack_ = -1;
+    if (task_depth < params::task_recursion_cutoff_level) {
+      if (lchild_)
+        lchild_->setup_solve_workspace(ws, rows, level+1, task_depth+1);
+      if (rchild_) {
+        std::vector<std::size_t> rrows;
+        rchild_->setup_solve_workspace(ws, rrows, 0, task_depth+1);
+        rchild_->solve_stack_ = ws.add_stack(std::move(rrows));
+        rchild_->solve_ws_ = &ws;
+      }
+    } else {
+      if (lchild_)
+        lchild_->setup_solve_workspace(ws, rows, level+1, task_depth);
+      if (rchild_)
+        rchild_->setup_solve_workspace(ws, rows, level+1, task_depth);
+    }
+  }
+
+  /**
+   * Return the work stack of this front, from the SolveWorkspace if
+   * it was set up for nrhs right-hand sides, otherwise allocate it
+   * in tmp.
+   */
+  template<typename scalar_t,typename integer_t> DenseMatrix<scalar_t>*
+  FrontalMatrix<scalar_t,integer_t>::solve_work
+  (std::size_t nrhs, std::vector<DenseM_t>& tmp) const {
+    if (solve_ws_ && solve_ws_->nrhs() == nrhs)
+      return solve_ws_->stack(solve_stack_);
+    tmp.resize(levels());
     auto max_dupd = max_dim_upd();
-    auto lvls = levels();
-    std::vector<DenseM_t> CB(lvls);
-    for (auto& cb : CB)
-      cb = DenseM_t(max_dupd, b.cols());
+    for (auto& cb : tmp)
+      cb = DenseM_t(max_dupd, nrhs);
+    return tmp.data();
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::multifrontal_solve
+  (DenseM_t& b, SolveWorkspace<scalar_t>& ws,
+   const SolvePruning* prune) const {
+    if (solve_ws_ != &ws || ws.nrhs() != b.cols() ||
+        ws.task_cutoff() != params::task_recursion_cutoff_level)
+      setup_solve_workspace(ws, b.cols());
+    std::vector<DenseM_t> tmp;
+    auto work = solve_work(b.cols(), tmp);
     TIMER_TIME(TaskType::FORWARD_SOLVE, 0, t_fwd);
-    forward_multifrontal_solve(b, CB.data());
+    forward_multifrontal_solve(b, work, prune);
     TIMER_STOP(t_fwd);
     TIMER_TIME(TaskType::BACKWARD_SOLVE, 0, t_bwd);
-    backward_multifrontal_solve(b, CB.data());
+    backward_multifrontal_solve(b, work, prune);
     TIMER_STOP(t_bwd);
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrix<scalar_t,integer_t>::fwd_solve_phase1
   (DenseM_t& b, DenseM_t& bupd, DenseM_t* work,
-   int etree_level, int task_depth) const {
+   const SolvePruning* prune, int etree_level, int task_depth) const {
+    // children without right-hand side in their subtree are skipped,
+    // see prune_forward
+    const bool lch = lchild_ && (!prune || prune->forward(lchild_->sep_)),
+      rch = rchild_ && (!prune || prune->forward(rchild_->sep_));
     if (task_depth < params::task_recursion_cutoff_level) {
-      if (lchild_)
+      if (lch)
 #pragma omp task untied default(shared)                                 \
   final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
         lchild_->forward_multifrontal_solve
-          (b, work+1, etree_level+1, task_depth+1);
-      if (rchild_)
+          (b, work+1, prune, etree_level+1, task_depth+1);
+      if (rch)
 #pragma omp task untied default(shared)                                 \
   final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
         {
-          std::vector<DenseM_t> work2(rchild_->levels());
-          for (auto& cb : work2)
-            cb = DenseM_t(rchild_->max_dim_upd(), b.cols());
+          std::vector<DenseM_t> tmp;
+          auto work2 = rchild_->solve_work(b.cols(), tmp);
           rchild_->forward_multifrontal_solve
-            (b, work2.data(), etree_level+1, task_depth+1);
+            (b, work2, prune, etree_level+1, task_depth+1);
           DenseMW_t CBch(rchild_->dim_upd(), b.cols(), work2[0], 0, 0);
           rchild_->extend_add_b(b, bupd, CBch, this);
         }
 #pragma omp taskwait
-      if (lchild_) {
+      if (lch) {
         DenseMW_t CBch(lchild_->dim_upd(), b.cols(), work[1], 0, 0);
         lchild_->extend_add_b(b, bupd, CBch, this);
       }
     } else {
-      if (lchild_) {
+      if (lch) {
         lchild_->forward_multifrontal_solve
-          (b, work+1, etree_level+1, task_depth);
+          (b, work+1, prune, etree_level+1, task_depth);
         DenseMW_t CBch(lchild_->dim_upd(), b.cols(), work[1], 0, 0);
         lchild_->extend_add_b(b, bupd, CBch, this);
       }
-      if (rchild_) {
+      if (rch) {
         rchild_->forward_multifrontal_solve
-          (b, work+1, etree_level+1, task_depth);
+          (b, work+1, prune, etree_level+1, task_depth);
         DenseMW_t CBch(rchild_->dim_upd(), b.cols(), work[1], 0, 0);
         rchild_->extend_add_b(b, bupd, CBch, this);
       }
     }
   }
 
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrix<scalar_t,integer_t>::prune_backward
+  (const std::vector<integer_t>& sol_rows, SolvePruning& prune) const {
+    auto r = std::lower_bound(sol_rows.begin(), sol_rows.end(), sep_begin_);
+    bool bwd = sol_rows.empty() || (r != sol_rows.end() && *r < sep_end_);
+    if (lchild_) bwd = lchild_->prune_backward(sol_rows, prune) || bwd;
+    if (rchild_) bwd = rchild_->prune_backward(sol_rows, prune) || bwd;
+    prune.set_backward(sep_, bwd);
+    return bwd;
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrix<scalar_t,integer_t>::prune_forward
+  (const std::vector<integer_t>& rhs_rows, SolvePruning& prune) const {
+    auto r = std::lower_bound(rhs_rows.begin(), rhs_rows.end(), sep_begin_);
+    bool fwd = r != rhs_rows.end() && *r < sep_end_;
+    if (lchild_) fwd = lchild_->prune_forward(rhs_rows, prune) || fwd;
+    if (rchild_) fwd = rchild_->prune_forward(rhs_rows, prune) || fwd;
+    // the backward solve of an HSS front uses the work from its
+    // forward solve, so it (and its ancestors) need the forward
+    // solve, even if it is with a zero right-hand side
+    fwd = fwd || (prune.backward(sep_) && isHSS());
+    prune.set_forward(sep_, fwd);
+    return fwd;
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrix<scalar_t,integer_t>::bwd_solve_phase2
   (DenseM_t& y, DenseM_t& yupd, DenseM_t* work,
-   int etree_level, int task_depth) const {
+   const SolvePruning* prune, int etree_level, int task_depth) const {
+    // see prune_backward
+    const bool lch = lchild_ && (!prune || prune->backward(lchild_->sep_)),
+      rch = rchild_ && (!prune || prune->backward(rchild_->sep_));
     if (task_depth < params::task_recursion_cutoff_level) {
-      if (lchild_) {
+      if (lch) {
 #pragma omp task untied default(shared)                                 \
   final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
         {
           DenseMW_t CB(lchild_->dim_upd(), y.cols(), work[1], 0, 0);
           lchild_->extract_b(y, yupd, CB, this);
           lchild_->backward_multifrontal_solve
-            (y, work+1, etree_level+1, task_depth+1);
+            (y, work+1, prune, etree_level+1, task_depth+1);
         }
       }
-      if (rchild_)
+      if (rch)
 #pragma omp task untied default(shared)                                 \
   final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
         {
-          std::vector<DenseM_t> work2(rchild_->levels());
-          for (auto& cb : work2)
-            cb = DenseM_t(rchild_->max_dim_upd(), y.cols());
+          std::vector<DenseM_t> tmp;
+          auto work2 = rchild_->solve_work(y.cols(), tmp);
           DenseMW_t CB(rchild_->dim_upd(), y.cols(), work2[0], 0, 0);
           rchild_->extract_b(y, yupd, CB, this);
           rchild_->backward_multifrontal_solve
-            (y, work2.data(), etree_level+1, task_depth+1);
+            (y, work2, prune, etree_level+1, task_depth+1);
         }
 #pragma omp taskwait
     } else {
-      if (lchild_) {
+      if (lch) {
         DenseMW_t CB(lchild_->dim_upd(), y.cols(), work[1], 0, 0);
         lchild_->extract_b(y, yupd, CB, this);
         lchild_->backward_multifrontal_solve
-          (y, work+1, etree_level+1, task_depth);
+          (y, work+1, prune, etree_level+1, task_depth);
       }
-      if (rchild_) {
+      if (rch) {
         DenseMW_t CB(rchild_->dim_upd(), y.cols(), work[1], 0, 0);
         rchild_->extract_b(y, yupd, CB, this);
         rchild_->backward_multifrontal_solve
-          (y, work+1, etree_level+1, task_depth);
+          (y, work+1, prune, etree_level+1, task_depth);
       }
     }
   }
@@ -513,6 +787,164 @@ namespace strumpack {
     return nnz + nnzl + nnzr;
   }
 
+  /**
+   * Add the factor nonzeros of this front and all its descendants to
+   * nnz[0], nnz[1] or nnz[2], for dense, HSS or BLR fronts
+   * respectively. For distributed fronts, this only counts the local
+   * part.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::factor_nonzeros_by_type
+  (std::array<long long,3>& nnz) const {
+    nnz[isHSS() ? 1 : (isBLR() ? 2 : 0)] += node_factor_nonzeros();
+    if (lchild_) lchild_->factor_nonzeros_by_type(nnz);
+    if (rchild_) rchild_->factor_nonzeros_by_type(nnz);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::find_CB_stack_roots
+  (std::vector<F_t*>& roots, bool /*pa_on_stack*/, int task_depth) {
+    if (task_depth < params::task_recursion_cutoff_level) task_depth++;
+    if (lchild_) lchild_->find_CB_stack_roots(roots, false, task_depth);
+    if (rchild_) rchild_->find_CB_stack_roots(roots, false, task_depth);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::factor_children
+  (const SpMat_t& A, const SPOptions<scalar_t>& opts,
+   int etree_level, int task_depth) {
+    if (task_depth < params::task_recursion_cutoff_level) {
+      if (lchild_)
+#pragma omp task default(shared)                                        \
+  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
+        lchild_->multifrontal_factorization
+          (A, opts, etree_level+1, task_depth+1);
+      if (rchild_)
+#pragma omp task default(shared)                                        \
+  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
+        rchild_->multifrontal_factorization
+          (A, opts, etree_level+1, task_depth+1);
+#pragma omp taskwait
+    } else {
+      if (lchild_)
+        lchild_->multifrontal_factorization
+          (A, opts, etree_level+1, task_depth);
+      if (rchild_)
+        rchild_->multifrontal_factorization
+          (A, opts, etree_level+1, task_depth);
+    }
+  }
+
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrix<scalar_t,integer_t>::selected_inversion
+  (InverseEntry<scalar_t,integer_t>* begin,
+   InverseEntry<scalar_t,integer_t>* end,
+   const DenseM_t* paZ, const F_t* pa, int task_depth) const {
+    if (begin == end) return true;
+    const integer_t dsep = dim_sep(), dupd = dim_upd();
+    if (dupd && !pa) return false;
+    DenseM_t Zuu, Z;
+    if (dupd) {
+      auto I = upd_to_parent(pa);
+      Zuu = paZ->extract(I, I);
+    }
+    if (!inverse_front(Zuu, Z, task_depth)) return false;
+    Zuu.clear();
+    // entries in this front are at the end, the children's subtrees
+    // are before sep_begin_
+    auto mid = std::partition_point
+      (begin, end, [&](const InverseEntry<scalar_t,integer_t>& e) {
+        return e.first() < sep_begin_; });
+    auto local = [&](integer_t i, std::size_t& l) {
+      if (i >= sep_begin_ && i < sep_end_) { l = i - sep_begin_; return true; }
+      auto u = std::lower_bound(upd_.begin(), upd_.end(), i);
+      if (u == upd_.end() || *u != i) return false;
+      l = dsep + std::distance(upd_.begin(), u);
+      return true;
+    };
+    bool ok = true;
+    for (auto e=mid; e!=end; e++) {
+      std::size_t li, lj;
+      if (local(e->i, li) && local(e->j, lj)) e->v = Z(li, lj);
+      else ok = false;
+    }
+    if (mid == begin) return ok;
+    // split the remaining entries over the subtrees of the children,
+    // the subtree of a child ends at the end of its separator
+    auto ch0 = lchild_.get(), ch1 = rchild_.get();
+    if (ch0 && ch1 && ch1->sep_end_ < ch0->sep_end_) std::swap(ch0, ch1);
+    if (!ch0) std::swap(ch0, ch1);
+    if (!ch0) return false;
+    auto split = ch1 ? std::partition_point
+      (begin, mid, [&](const InverseEntry<scalar_t,integer_t>& e) {
+        return e.first() < ch0->sep_end_; }) : mid;
+    bool ok0 = true, ok1 = true;
+#pragma omp task default(shared)                                        \
+  if(task_depth < params::task_recursion_cutoff_level)                  \
+  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
+    ok0 = ch0->selected_inversion(begin, split, &Z, this, task_depth+1);
+    if (ch1)
+      ok1 = ch1->selected_inversion(split, mid, &Z, this, task_depth+1);
+#pragma omp taskwait
+    return ok && ok0 && ok1;
+  }
+
+  /**
+   * Block of the inverse Z for a front with (partially) factored
+   *   [F11 F12; F21 F22] = [P L11 0; L21 I] [U11 U12; 0 S],
+   * i.e., as computed by FrontalMatrixDense::factor_phase2, with
+   * L11 U11 stored in F11, the row interchanges of P in piv, U12 in
+   * F12 and L21 in F21. Zuu is the Z(upd,upd) block of the inverse
+   * of the whole matrix, extracted by selected_inversion from the
+   * inverse block of the parent. This is not the inverse of the
+   * Schur complement S of this front, which only has the updates
+   * from the descendants. The other blocks follow from
+   *   Z(upd,sep) = -Zuu L21 L11^{-1} P^T
+   *   Z(sep,upd) = -U11^{-1} U12 Zuu
+   *   Z(sep,sep) = U11^{-1} (L11^{-1} P^T - U12 Z(upd,sep)),
+   * where P^T is applied by laswp with the pivots in forward order.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrix<scalar_t,integer_t>::inverse_front_dense
+  (const DenseM_t& F11, const std::vector<int>& piv, const DenseM_t& F12,
+   const DenseM_t& F21, const DenseM_t& Zuu, DenseM_t& Z, int task_depth) {
+    const std::size_t dsep = F11.rows(), dupd = Zuu.rows();
+    Z = DenseM_t(dsep+dupd, dsep+dupd);
+    DenseMW_t Zss(dsep, dsep, Z, 0, 0);
+    Zss.eye();
+    Zss.laswp(piv, true);
+    trsm(Side::L, UpLo::L, Trans::N, Diag::U,
+         scalar_t(1.), F11, Zss, task_depth);
+    long long flops = trsm_flops(Side::L, scalar_t(1.), F11, Zss) * 2;
+    if (dupd) {
+      DenseMW_t Zsu(dsep, dupd, Z, 0, dsep), Zus(dupd, dsep, Z, dsep, 0),
+        Zuu_(dupd, dupd, Z, dsep, dsep);
+      Zuu_.copy(Zuu);
+      if (dsep) {
+        DenseM_t ZuuL21(dupd, dsep);
+        gemm(Trans::N, Trans::N, scalar_t(1.), Zuu, F21,
+             scalar_t(0.), ZuuL21, task_depth);
+        gemm(Trans::N, Trans::N, scalar_t(-1.), ZuuL21, Zss,
+             scalar_t(0.), Zus, task_depth);
+        gemm(Trans::N, Trans::N, scalar_t(-1.), F12, Zuu,
+             scalar_t(0.), Zsu, task_depth);
+        trsm(Side::L, UpLo::U, Trans::N, Diag::N,
+             scalar_t(1.), F11, Zsu, task_depth);
+        gemm(Trans::N, Trans::N, scalar_t(-1.), F12, Zus,
+             scalar_t(1.), Zss, task_depth);
+        flops += gemm_flops
+          (Trans::N, Trans::N, scalar_t(1.), Zuu, F21, scalar_t(0.)) +
+          gemm_flops(Trans::N, Trans::N, scalar_t(-1.), ZuuL21, Zss, scalar_t(0.)) +
+          gemm_flops(Trans::N, Trans::N, scalar_t(-1.), F12, Zuu, scalar_t(0.)) +
+          gemm_flops(Trans::N, Trans::N, scalar_t(-1.), F12, Zus, scalar_t(1.)) +
+          trsm_flops(Side::L, scalar_t(1.), F11, Zsu);
+      }
+    }
+    trsm(Side::L, UpLo::U, Trans::N, Diag::N,
+         scalar_t(1.), F11, Zss, task_depth);
+    STRUMPACK_FULL_RANK_FLOPS(flops);
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrix<scalar_t,integer_t>::bisection_partitioning
   (const SPOptions<scalar_t>& opts, integer_t* sorder,
@@ -579,7 +1011,7 @@ namespace strumpack {
     std::vector<DenseM_t> CB(lvls);
     for (auto& cb : CB)
       cb = DenseM_t(max_dupd, bloc.cols());
-    forward_multifrontal_solve(bloc, CB.data(), etree_level, 0);
+    forward_multifrontal_solve(bloc, CB.data(), nullptr, etree_level, 0);
     seqbupd = CB[0];
   }
 
@@ -593,7 +1025,7 @@ namespace strumpack {
     for (auto& cb : CB)
       cb = DenseM_t(max_dupd, yloc.cols());
     CB[0] = seqyupd;
-    backward_multifrontal_solve(yloc, CB.data(), etree_level, 0);
+    backward_multifrontal_solve(yloc, CB.data(), nullptr, etree_level, 0);
   }
 
   template<typename scalar_t,typename integer_t> void
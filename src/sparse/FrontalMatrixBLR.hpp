@@ -62,7 +62,7 @@ namespace strumpack {
     (integer_t sep, integer_t sep_begin, integer_t sep_end,
      std::vector<integer_t>& upd);
 
-    void release_work_memory() { F22_.clear(); }
+    void release_work_memory() { F22_.clear(); F22blr_ = BLRM_t(); }
     void extend_add_to_dense
     (DenseM_t& paF11, DenseM_t& paF12, DenseM_t& paF21, DenseM_t& paF22,
      const FrontalMatrix<scalar_t,integer_t>* p, int task_depth) override;
@@ -75,14 +75,14 @@ namespace strumpack {
      int etree_level=0, int task_depth=0) override;
     void factor_node
     (const SpMat_t& A, const SPOptions<scalar_t>& opts,
-     int etree_level=0, int task_depth=0);
+     int etree_level=0, int task_depth=0) override;
 
     void forward_multifrontal_solve
-    (DenseM_t& b, DenseM_t* work, int etree_level=0,
-     int task_depth=0) const override;
+    (DenseM_t& b, DenseM_t* work, const SolvePruning* prune,
+     int etree_level=0, int task_depth=0) const override;
     void backward_multifrontal_solve
-    (DenseM_t& y, DenseM_t* work, int etree_level=0,
-     int task_depth=0) const override;
+    (DenseM_t& y, DenseM_t* work, const SolvePruning* prune,
+     int etree_level=0, int task_depth=0) const override;
 
     void extract_CB_sub_matrix
     (const std::vector<std::size_t>& I, const std::vector<std::size_t>& J,
@@ -90,10 +90,17 @@ namespace strumpack {
 
     std::string type() const override { return "FrontalMatrixBLR"; }
 
+    bool inverse_front
+    (const DenseM_t& Zuu, DenseM_t& Z, int task_depth) const override;
+    bool isBLR() const override { return true; }
+
 #if defined(STRUMPACK_USE_MPI)
     void extend_add_copy_to_buffers
     (std::vector<std::vector<scalar_t>>& sbuf, const FMPI_t* pa) const override {
-      ExtAdd::extend_add_seq_copy_to_buffers(F22_, sbuf, pa, this);
+      if (F22blr_.rows())
+        ExtAdd::extend_add_seq_copy_to_buffers
+          (F22blr_, sbuf, pa, this);
+      else ExtAdd::extend_add_seq_copy_to_buffers(F22_, sbuf, pa, this);
     }
 #endif
 
@@ -109,6 +116,9 @@ namespace strumpack {
   private:
     DenseM_t F11_, F12_, F21_, F22_;
     BLRM_t F11blr_, F12blr_, F21blr_;
+    // compressed contribution block, only used with
+    // BLROptions::CB_compression, F22_ is cleared then
+    BLRM_t F22blr_;
     std::vector<int> piv_;
     std::vector<std::size_t> sep_tiles_;
     std::vector<std::size_t> upd_tiles_;
@@ -147,6 +157,30 @@ namespace strumpack {
     const std::size_t dupd = dim_upd();
     std::size_t upd2sep;
     auto I = this->upd_to_parent(p, upd2sep);
+    if (F22blr_.rows()) {
+      // expand the compressed CB one tile at a time, adding each
+      // tile directly to the parent front
+      F22blr_.for_each_dense_tile
+        ([&](const DenseM_t& D, std::size_t roff, std::size_t coff) {
+          for (std::size_t c=0; c<D.cols(); c++) {
+            auto pc = I[coff+c];
+            for (std::size_t r=0; r<D.rows(); r++) {
+              auto pr = I[roff+r];
+              if (pc < pdsep) {
+                if (pr < pdsep) paF11(pr,pc) += D(r,c);
+                else paF21(pr-pdsep,pc) += D(r,c);
+              } else {
+                if (pr < pdsep) paF12(pr,pc-pdsep) += D(r,c);
+                else paF22(pr-pdsep,pc-pdsep) += D(r,c);
+              }
+            }
+          }
+        }, task_depth);
+      STRUMPACK_FLOPS((is_complex<scalar_t>()?2:1) * dupd * dupd);
+      STRUMPACK_FULL_RANK_FLOPS((is_complex<scalar_t>()?2:1) * dupd * dupd);
+      release_work_memory();
+      return;
+    }
 #if defined(STRUMPACK_USE_OPENMP_TASKLOOP)
 #pragma omp taskloop default(shared) grainsize(64)      \
   if(task_depth < params::task_recursion_cutoff_level)
@@ -177,6 +211,21 @@ namespace strumpack {
     auto I = this->upd_to_parent(pa);
     auto cR = R.extract_rows(I);
     DenseM_t cS(dim_upd(), R.cols());
+    if (F22blr_.rows()) {
+      gemm(Trans::N, Trans::N, scalar_t(1.), F22blr_, cR,
+           scalar_t(0.), cS, task_depth);
+      Sr.scatter_rows_add(I, cS, task_depth);
+      gemm(Trans::C, Trans::N, scalar_t(1.), F22blr_, cR,
+           scalar_t(0.), cS, task_depth);
+      Sc.scatter_rows_add(I, cS, task_depth);
+      // each nonzero of the BLR representation is used once per
+      // column of cR, in both products
+      STRUMPACK_CB_SAMPLE_FLOPS
+        ((is_complex<scalar_t>() ? 4 : 1) *
+         4 * F22blr_.nonzeros() * cR.cols() +
+         cS.rows()*cS.cols()*2); // for the skinny-extend add
+      return;
+    }
     gemm(Trans::N, Trans::N, scalar_t(1.), F22_, cR,
          scalar_t(0.), cS, task_depth);
     Sr.scatter_rows_add(I, cS, task_depth);
@@ -198,36 +247,23 @@ namespace strumpack {
       // use tasking for children and for extend-add parallelism
 #pragma omp parallel if(!omp_in_parallel()) default(shared)
 #pragma omp single nowait
+      {
+        this->factor_children(A, opts, etree_level, task_depth);
+        factor_node(A, opts, etree_level, task_depth);
+      }
+    } else {
+      this->factor_children(A, opts, etree_level, task_depth);
       factor_node(A, opts, etree_level, task_depth);
-    } else factor_node(A, opts, etree_level, task_depth);
+    }
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixBLR<scalar_t,integer_t>::factor_node
   (const SpMat_t& A, const SPOptions<scalar_t>& opts,
    int etree_level, int task_depth) {
-    if (task_depth < params::task_recursion_cutoff_level) {
-      if (lchild_)
-#pragma omp task default(shared)                                        \
-  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-        lchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth+1);
-      if (rchild_)
-#pragma omp task default(shared)                                        \
-  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-        rchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth+1);
-#pragma omp taskwait
-    } else {
-      if (lchild_)
-        lchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth);
-      if (rchild_)
-        rchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth);
-    }
     const auto dsep = dim_sep();
     const auto dupd = dim_upd();
+    TraceSpan trace("factor_BLR", this->sep_, etree_level, dsep+dupd);
     F11_ = DenseM_t(dsep, dsep); F11_.zero();
     F12_ = DenseM_t(dsep, dupd); F12_.zero();
     F21_ = DenseM_t(dupd, dsep); F21_.zero();
@@ -274,22 +310,31 @@ namespace strumpack {
 #endif
       // TODO flops
     }
+    if (dupd && opts.BLR_options().CB_compression()) {
+      F22blr_ = BLRM_t
+        (F22_, upd_tiles_, upd_tiles_,
+         [](std::size_t i, std::size_t j) -> bool { return i != j; },
+         opts.BLR_options());
+      F22_.clear();
+    }
+    trace.set_bytes(node_factor_nonzeros() * sizeof(scalar_t));
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixBLR<scalar_t,integer_t>::forward_multifrontal_solve
-  (DenseM_t& b, DenseM_t* work, int etree_level, int task_depth) const {
+  (DenseM_t& b, DenseM_t* work, const SolvePruning* prune,
+   int etree_level, int task_depth) const {
     DenseMW_t bupd(dim_upd(), b.cols(), work[0], 0, 0);
     bupd.zero();
     if (task_depth == 0) {
       // tasking when calling the children
 #pragma omp parallel if(!omp_in_parallel())
 #pragma omp single nowait
-      this->fwd_solve_phase1(b, bupd, work, etree_level, task_depth);
+      this->fwd_solve_phase1(b, bupd, work, prune, etree_level, task_depth);
       // no tasking for the root node computations, use system blas threading!
       fwd_solve_phase2(b, bupd, etree_level, params::task_recursion_cutoff_level);
     } else {
-      this->fwd_solve_phase1(b, bupd, work, etree_level, task_depth);
+      this->fwd_solve_phase1(b, bupd, work, prune, etree_level, task_depth);
       fwd_solve_phase2(b, bupd, etree_level, task_depth);
     }
   }
@@ -321,7 +366,8 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixBLR<scalar_t,integer_t>::backward_multifrontal_solve
-  (DenseM_t& y, DenseM_t* work, int etree_level, int task_depth) const {
+  (DenseM_t& y, DenseM_t* work, const SolvePruning* prune,
+   int etree_level, int task_depth) const {
     DenseMW_t yupd(dim_upd(), y.cols(), work[0], 0, 0);
     if (task_depth == 0) {
       // no tasking in blas routines, use system threaded blas instead
@@ -330,10 +376,10 @@ namespace strumpack {
 #pragma omp parallel if(!omp_in_parallel())
 #pragma omp single nowait
       // tasking when calling children
-      this->bwd_solve_phase2(y, yupd, work, etree_level, task_depth);
+      this->bwd_solve_phase2(y, yupd, work, prune, etree_level, task_depth);
     } else {
       bwd_solve_phase1(y, yupd, etree_level, task_depth);
-      this->bwd_solve_phase2(y, yupd, work, etree_level, task_depth);
+      this->bwd_solve_phase2(y, yupd, work, prune, etree_level, task_depth);
     }
   }
 
@@ -361,6 +407,24 @@ namespace strumpack {
     }
   }
 
+  /**
+   * The BLR factors are expanded to dense, so this gives the
+   * inverse of the approximate factorization, as applied in the
+   * solve.
+   */
+  template<typename scalar_t,typename integer_t> bool
+  FrontalMatrixBLR<scalar_t,integer_t>::inverse_front
+  (const DenseM_t& Zuu, DenseM_t& Z, int task_depth) const {
+    DenseM_t F11, F12, F21;
+    if (dim_sep()) F11 = F11blr_.dense();
+    if (dim_sep() && dim_upd()) {
+      F12 = F12blr_.dense();
+      F21 = F21blr_.dense();
+    }
+    this->inverse_front_dense(F11, piv_, F12, F21, Zuu, Z, task_depth);
+    return true;
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixBLR<scalar_t,integer_t>::extract_CB_sub_matrix
   (const std::vector<std::size_t>& I, const std::vector<std::size_t>& J,
@@ -371,9 +435,12 @@ namespace strumpack {
     std::vector<std::size_t> lI, oI;
     this->find_upd_indices(I, lI, oI);
     if (lI.empty()) return;
-    for (std::size_t j=0; j<lJ.size(); j++)
-      for (std::size_t i=0; i<lI.size(); i++)
-        B(oI[i], oJ[j]) += F22_(lI[i], lJ[j]);
+    if (F22blr_.rows()) F22blr_.extract_add(lI, lJ, B, oI, oJ);
+    else {
+      for (std::size_t j=0; j<lJ.size(); j++)
+        for (std::size_t i=0; i<lI.size(); i++)
+          B(oI[i], oJ[j]) += F22_(lI[i], lJ[j]);
+    }
     STRUMPACK_FLOPS((is_complex<scalar_t>() ? 2 : 1) * lJ.size() * lI.size());
   }
 
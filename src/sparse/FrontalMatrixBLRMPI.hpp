@@ -67,7 +67,6 @@ namespace strumpack {
     void build_front(const SpMat_t& A);
     void partial_factorization(const SPOptions<scalar_t>& opts);
 
-    void extend_add();
     void extend_add_copy_to_buffers
     (std::vector<std::vector<scalar_t>>& sbuf, const FMPI_t* pa) const override;
 
@@ -91,6 +90,7 @@ namespace strumpack {
      DistM_t& B) const override;
 
     std::string type() const override { return "FrontalMatrixBLRMPI"; }
+    bool isBLR() const override { return true; }
 
     void set_BLR_partitioning
     (const SPOptions<scalar_t>& opts, const HSS::HSSPartitionTree& sep_tree,
@@ -132,26 +132,6 @@ namespace strumpack {
     F22_.clear(); // remove the update block
   }
 
-  template<typename scalar_t,typename integer_t> void
-  FrontalMatrixBLRMPI<scalar_t,integer_t>::extend_add() {
-    if (!lchild_ && !rchild_) return;
-    std::vector<std::vector<scalar_t>> sbuf(this->P());
-    for (auto& ch : {lchild_.get(), rchild_.get()}) {
-      if (ch && Comm().is_root()) {
-        STRUMPACK_FLOPS
-          (static_cast<long long int>(ch->dim_upd())*ch->dim_upd());
-      }
-      if (visit(ch)) ch->extend_add_copy_to_buffers(sbuf, this);
-    }
-    std::vector<scalar_t> rbuf;
-    std::vector<scalar_t*> pbuf;
-    Comm().all_to_all_v(sbuf, rbuf, pbuf);
-    for (auto& ch : {lchild_.get(), rchild_.get()})
-      if (ch)
-        ch->extend_add_copy_from_buffers
-          (F11_, F12_, F21_, F22_, pbuf.data()+this->master(ch), this);
-  }
-
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixBLRMPI<scalar_t,integer_t>::extend_add_copy_to_buffers
   (std::vector<std::vector<scalar_t>>& sbuf, const FMPI_t* pa) const {
@@ -162,6 +142,8 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixBLRMPI<scalar_t,integer_t>::build_front
   (const SpMat_t& A) {
+    // send the children's contribution blocks while extracting from A
+    this->extend_add_post();
     const auto dupd = dim_upd();
     const auto dsep = dim_sep();
     if (dsep) {
@@ -181,7 +163,7 @@ namespace strumpack {
       F22_ = DistM_t(grid(), dupd, dupd);
       F22_.zero();
     }
-    extend_add();
+    this->extend_add_wait(F11_, F12_, F21_, F22_);
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -218,10 +200,13 @@ namespace strumpack {
     if (visit(rchild_))
       rchild_->multifrontal_factorization
         (A, opts, etree_level+1, task_depth);
+    TraceSpan trace("factor_BLR_MPI", this->sep_, etree_level,
+                    this->dim_sep()+this->dim_upd());
     build_front(A);
     if (lchild_) lchild_->release_work_memory();
     if (rchild_) rchild_->release_work_memory();
     partial_factorization(opts);
+    trace.set_bytes(this->node_factor_nonzeros() * sizeof(scalar_t));
   }
 
   template<typename scalar_t,typename integer_t> void
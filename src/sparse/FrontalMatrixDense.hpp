@@ -39,6 +39,7 @@
 #include "dense/BLASLAPACKWrapper.hpp"
 #include "CompressedSparseMatrix.hpp"
 #include "MatrixReordering.hpp"
+#include "CBWorkspace.hpp"
 #if defined(STRUMPACK_USE_MPI)
 #include "ExtendAdd.hpp"
 #endif
@@ -59,7 +60,7 @@ namespace strumpack {
     (integer_t sep, integer_t sep_begin, integer_t sep_end,
      std::vector<integer_t>& upd);
 
-    void release_work_memory() { F22_.clear(); }
+    void release_work_memory() { F22_.clear(); CB_mem_.clear(); }
     void extend_add_to_dense
     (DenseM_t& paF11, DenseM_t& paF12, DenseM_t& paF21, DenseM_t& paF22,
      const FrontalMatrix<scalar_t,integer_t>* p, int task_depth) override;
@@ -69,21 +70,42 @@ namespace strumpack {
      DenseM_t& Sc, FrontalMatrix<scalar_t,integer_t>* pa,
      int task_depth) override;
     void multifrontal_factorization
+    (const SpMat_t& A, const SPOptions<scalar_t>& opts,
+     int etree_level=0, int task_depth=0) override;
+    void factor_node
     (const SpMat_t& A, const SPOptions<scalar_t>& opts,
      int etree_level=0, int task_depth=0) override;
 
     void forward_multifrontal_solve
-    (DenseM_t& b, DenseM_t* work, int etree_level=0,
-     int task_depth=0) const override;
+    (DenseM_t& b, DenseM_t* work, const SolvePruning* prune,
+     int etree_level=0, int task_depth=0) const override;
     void backward_multifrontal_solve
-    (DenseM_t& y, DenseM_t* work, int etree_level=0,
-     int task_depth=0) const override;
+    (DenseM_t& y, DenseM_t* work, const SolvePruning* prune,
+     int etree_level=0, int task_depth=0) const override;
 
     void extract_CB_sub_matrix
     (const std::vector<std::size_t>& I, const std::vector<std::size_t>& J,
      DenseM_t& B, int task_depth) const override;
     std::string type() const override { return "FrontalMatrixDense"; }
 
+    bool inverse_front
+    (const DenseM_t& Zuu, DenseM_t& Z, int task_depth) const override {
+      this->inverse_front_dense(F11_, piv, F12_, F21_, Zuu, Z, task_depth);
+      return true;
+    }
+
+    void find_CB_stack_roots
+    (std::vector<FrontalMatrix<scalar_t,integer_t>*>& roots,
+     bool pa_on_stack, int task_depth=0) override;
+    std::size_t CB_stack_size() const override {
+      return std::size_t(dim_upd()) * dim_upd();
+    }
+    std::size_t CB_stack_peak() const override;
+    void set_CB_stack(CBWorkspace<scalar_t>* ws) override;
+    void set_CB_pool(CBWorkspacePool<scalar_t>* pool) override {
+      CB_pool_ = pool;
+    }
+
 #if defined(STRUMPACK_USE_MPI)
     void extend_add_copy_to_buffers
     (std::vector<std::vector<scalar_t>>& sbuf,
@@ -93,7 +115,14 @@ namespace strumpack {
 #endif
 
   private:
-    DenseM_t F11_, F12_, F21_, F22_;
+    // F11_, F12_ and F21_ are stored in factor_mem_, F22_ is either
+    // on the CB_stack_ or in CB_mem_
+    DenseMW_t F11_, F12_, F21_, F22_;
+    DenseM_t factor_mem_;
+    DenseM_t CB_mem_;
+    CBWorkspace<scalar_t>* CB_stack_ = nullptr;
+    // only set for the root of a subtree with its CBs on a stack
+    CBWorkspacePool<scalar_t>* CB_pool_ = nullptr;
     std::vector<int> piv; // regular int because it is passed to BLAS
 
     FrontalMatrixDense(const FrontalMatrixDense&) = delete;
@@ -102,6 +131,7 @@ namespace strumpack {
     void factor_phase1
     (const SpMat_t& A, const SPOptions<scalar_t>& opts,
      int etree_level, int task_depth);
+    void build_front(const SpMat_t& A, int task_depth);
     void factor_phase2
     (const SpMat_t& A, const SPOptions<scalar_t>& opts,
      int etree_level, int task_depth);
@@ -178,6 +208,11 @@ namespace strumpack {
   FrontalMatrixDense<scalar_t,integer_t>::multifrontal_factorization
   (const SpMat_t& A, const SPOptions<scalar_t>& opts,
    int etree_level, int task_depth) {
+    CBWorkspace<scalar_t>* ws = nullptr;
+    if (CB_pool_) {
+      ws = CB_pool_->acquire();
+      set_CB_stack(ws);
+    }
     if (task_depth == 0) {
       // use tasking for children and for extend-add parallelism
 #pragma omp parallel if(!omp_in_parallel()) default(shared)
@@ -190,45 +225,55 @@ namespace strumpack {
       factor_phase1(A, opts, etree_level, task_depth);
       factor_phase2(A, opts, etree_level, task_depth);
     }
+    if (CB_pool_) {
+      set_CB_stack(nullptr);
+      CB_pool_->release(ws);
+    }
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::factor_node
+  (const SpMat_t& A, const SPOptions<scalar_t>& opts,
+   int etree_level, int task_depth) {
+    build_front(A, task_depth);
+    factor_phase2(A, opts, etree_level, task_depth);
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixDense<scalar_t,integer_t>::factor_phase1
   (const SpMat_t& A, const SPOptions<scalar_t>& opts,
    int etree_level, int task_depth) {
-    if (task_depth < params::task_recursion_cutoff_level) {
-      if (lchild_)
-#pragma omp task default(shared)                                        \
-  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-        lchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth+1);
-      if (rchild_)
-#pragma omp task default(shared)                                        \
-  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-        rchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth+1);
-#pragma omp taskwait
-    } else {
-      if (lchild_)
-        lchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth);
-      if (rchild_)
-        rchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth);
-    }
-    // TODO can we allocate the memory in one go??
-    const auto dsep = dim_sep();
-    const auto dupd = dim_upd();
-    F11_ = DenseM_t(dsep, dsep); F11_.zero();
-    F12_ = DenseM_t(dsep, dupd); F12_.zero();
-    F21_ = DenseM_t(dupd, dsep); F21_.zero();
+    this->factor_children(A, opts, etree_level, task_depth);
+    build_front(A, task_depth);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::build_front
+  (const SpMat_t& A, int task_depth) {
+    const std::size_t dsep = dim_sep();
+    const std::size_t dupd = dim_upd();
+    const std::size_t fsize = dsep * (dsep + 2 * dupd);
+    factor_mem_ = DenseM_t(fsize, 1);
+    factor_mem_.zero();
+    F11_ = DenseMW_t(dsep, dsep, factor_mem_.data(), dsep);
+    F12_ = DenseMW_t(dsep, dupd, factor_mem_.data()+dsep*dsep, dsep);
+    F21_ = DenseMW_t(dupd, dsep, factor_mem_.data()+dsep*(dsep+dupd), dupd);
     A.extract_front
       (F11_, F12_, F21_, this->sep_begin_, this->sep_end_,
        this->upd_, task_depth);
     if (dupd) {
-      F22_ = DenseM_t(dupd, dupd);
+      if (CB_stack_ && !CB_pool_)
+        F22_ = DenseMW_t(dupd, dupd, CB_stack_->push(dupd*dupd), dupd);
+      else {
+        CB_mem_ = DenseM_t(dupd, dupd);
+        F22_ = DenseMW_t(dupd, dupd, CB_mem_, 0, 0);
+      }
       F22_.zero();
     }
+    TraceSpan trace("extend_add", this->sep_, -1, dsep+dupd);
+    trace.set_bytes
+      (((lchild_ ? lchild_->CB_stack_size() : 0) +
+        (rchild_ ? rchild_->CB_stack_size() : 0)) * sizeof(scalar_t));
     if (lchild_)
       lchild_->extend_add_to_dense
         (F11_, F12_, F21_, F22_, this, task_depth);
@@ -241,6 +286,8 @@ namespace strumpack {
   FrontalMatrixDense<scalar_t,integer_t>::factor_phase2
   (const SpMat_t& A, const SPOptions<scalar_t>& opts,
    int etree_level, int task_depth) {
+    TraceSpan trace("factor_dense", this->sep_, etree_level,
+                    dim_sep()+dim_upd());
     if (dim_sep()) {
       piv = F11_.LU(task_depth);
       if (opts.replace_tiny_pivots()) {
@@ -261,27 +308,83 @@ namespace strumpack {
              scalar_t(1.), F22_, task_depth);
       }
     }
-    STRUMPACK_FULL_RANK_FLOPS
-      (LU_flops(F11_) +
-       gemm_flops(Trans::N, Trans::N, scalar_t(-1.), F21_, F12_, scalar_t(1.)) +
-       trsm_flops(Side::L, scalar_t(1.), F11_, F12_) +
-       trsm_flops(Side::R, scalar_t(1.), F11_, F21_));
+    auto flops = LU_flops(F11_) +
+      gemm_flops(Trans::N, Trans::N, scalar_t(-1.), F21_, F12_, scalar_t(1.)) +
+      trsm_flops(Side::L, scalar_t(1.), F11_, F12_) +
+      trsm_flops(Side::R, scalar_t(1.), F11_, F21_);
+    STRUMPACK_FULL_RANK_FLOPS(flops);
+    trace.set_flops(flops);
+    trace.set_bytes
+      ((long long)dim_sep() * (dim_sep() + 2 * dim_upd()) * sizeof(scalar_t));
+    if (CB_stack_) {
+      // the children's contribution blocks are no longer needed,
+      // move the contribution block of this front over them, or, for
+      // the root of the subtree, leave the stack empty
+      std::size_t chCB = 0;
+      if (lchild_) chCB += lchild_->CB_stack_size();
+      if (rchild_) chCB += rchild_->CB_stack_size();
+      if (CB_pool_) CB_stack_->pop(chCB);
+      else {
+        auto CB = CB_stack_->collapse(CB_stack_size(), chCB);
+        if (dim_upd())
+          F22_ = DenseMW_t(dim_upd(), dim_upd(), CB, dim_upd());
+      }
+    }
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::find_CB_stack_roots
+  (std::vector<FrontalMatrix<scalar_t,integer_t>*>& roots,
+   bool pa_on_stack, int task_depth) {
+    // below the task recursion cutoff level, the subtree is factored
+    // sequentially, so its contribution blocks can go on a stack
+    bool on_stack = task_depth >= params::task_recursion_cutoff_level;
+    CB_stack_ = nullptr;
+    CB_pool_ = nullptr;
+    if (on_stack && !pa_on_stack) roots.push_back(this);
+    if (!on_stack) task_depth++;
+    if (lchild_) lchild_->find_CB_stack_roots(roots, on_stack, task_depth);
+    if (rchild_) rchild_->find_CB_stack_roots(roots, on_stack, task_depth);
+  }
+
+  template<typename scalar_t,typename integer_t> std::size_t
+  FrontalMatrixDense<scalar_t,integer_t>::CB_stack_peak() const {
+    std::size_t pl = 0, pr = 0, cbl = 0, cbr = 0;
+    if (lchild_) {
+      pl = lchild_->CB_stack_peak();
+      cbl = lchild_->CB_stack_size();
+    }
+    if (rchild_) {
+      pr = rchild_->CB_stack_peak();
+      cbr = rchild_->CB_stack_size();
+    }
+    return std::max(std::max(pl, cbl + pr),
+                    cbl + cbr + (CB_pool_ ? 0 : CB_stack_size()));
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDense<scalar_t,integer_t>::set_CB_stack
+  (CBWorkspace<scalar_t>* ws) {
+    CB_stack_ = ws;
+    if (lchild_) lchild_->set_CB_stack(ws);
+    if (rchild_) rchild_->set_CB_stack(ws);
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixDense<scalar_t,integer_t>::forward_multifrontal_solve
-  (DenseM_t& b, DenseM_t* work, int etree_level, int task_depth) const {
+  (DenseM_t& b, DenseM_t* work, const SolvePruning* prune,
+   int etree_level, int task_depth) const {
     DenseMW_t bupd(dim_upd(), b.cols(), work[0], 0, 0);
     bupd.zero();
     if (task_depth == 0) {
       // tasking when calling the children
 #pragma omp parallel if(!omp_in_parallel())
 #pragma omp single nowait
-      this->fwd_solve_phase1(b, bupd, work, etree_level, task_depth);
+      this->fwd_solve_phase1(b, bupd, work, prune, etree_level, task_depth);
       // no tasking for the root node computations, use system blas threading!
       fwd_solve_phase2(b, bupd, etree_level, params::task_recursion_cutoff_level);
     } else {
-      this->fwd_solve_phase1(b, bupd, work, etree_level, task_depth);
+      this->fwd_solve_phase1(b, bupd, work, prune, etree_level, task_depth);
       fwd_solve_phase2(b, bupd, etree_level, task_depth);
     }
   }
@@ -309,7 +412,8 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixDense<scalar_t,integer_t>::backward_multifrontal_solve
-  (DenseM_t& y, DenseM_t* work, int etree_level, int task_depth) const {
+  (DenseM_t& y, DenseM_t* work, const SolvePruning* prune,
+   int etree_level, int task_depth) const {
     DenseMW_t yupd(dim_upd(), y.cols(), work[0], 0, 0);
     if (task_depth == 0) {
       // no tasking in blas routines, use system threaded blas instead
@@ -318,10 +422,10 @@ namespace strumpack {
 #pragma omp parallel if(!omp_in_parallel())
 #pragma omp single nowait
       // tasking when calling children
-      this->bwd_solve_phase2(y, yupd, work, etree_level, task_depth);
+      this->bwd_solve_phase2(y, yupd, work, prune, etree_level, task_depth);
     } else {
       bwd_solve_phase1(y, yupd, etree_level, task_depth);
-      this->bwd_solve_phase2(y, yupd, work, etree_level, task_depth);
+      this->bwd_solve_phase2(y, yupd, work, prune, etree_level, task_depth);
     }
   }
 
@@ -33,6 +33,8 @@
 #include <fstream>
 #include <algorithm>
 #include <cmath>
+#include <map>
+#include <numeric>
 #include "misc/TaskTimer.hpp"
 #include "misc/MPIWrapper.hpp"
 #include "dense/DistributedMatrix.hpp"
@@ -67,9 +69,8 @@ namespace strumpack {
 
     void release_work_memory() override;
     void build_front(const SpMat_t& A);
-    void partial_factorization();
+    void partial_factorization(const SPOptions<scalar_t>& opts);
 
-    void extend_add();
     void extend_add_copy_to_buffers
     (std::vector<std::vector<scalar_t>>& sbuf, const FMPI_t* pa) const override;
 
@@ -100,6 +101,8 @@ namespace strumpack {
 
     long long node_factor_nonzeros() const override;
 
+    void partial_factorization_lookahead();
+
     using FrontalMatrix<scalar_t,integer_t>::lchild_;
     using FrontalMatrix<scalar_t,integer_t>::rchild_;
     using FrontalMatrixMPI<scalar_t,integer_t>::visit;
@@ -120,28 +123,6 @@ namespace strumpack {
     F22_.clear(); // remove the update block
   }
 
-  template<typename scalar_t,typename integer_t> void
-  FrontalMatrixDenseMPI<scalar_t,integer_t>::extend_add() {
-    if (!lchild_ && !rchild_) return;
-    std::vector<std::vector<scalar_t>> sbuf(this->P());
-    for (auto& ch : {lchild_.get(), rchild_.get()}) {
-      if (ch && Comm().is_root()) {
-        STRUMPACK_FLOPS
-          (static_cast<long long int>(ch->dim_upd())*ch->dim_upd());
-      }
-      if (!visit(ch)) continue;
-      ch->extend_add_copy_to_buffers(sbuf, this);
-    }
-    std::vector<scalar_t> rbuf;
-    std::vector<scalar_t*> pbuf;
-    Comm().all_to_all_v(sbuf, rbuf, pbuf);
-    for (auto& ch : {lchild_.get(), rchild_.get()}) {
-      if (!ch) continue;
-      ch->extend_add_copy_from_buffers
-        (F11_, F12_, F21_, F22_, pbuf.data()+this->master(ch), this);
-    }
-  }
-
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixDenseMPI<scalar_t,integer_t>::extend_add_copy_to_buffers
   (std::vector<std::vector<scalar_t>>& sbuf, const FMPI_t* pa) const {
@@ -151,6 +132,8 @@ namespace strumpack {
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixDenseMPI<scalar_t,integer_t>::build_front
   (const SpMat_t& A) {
+    // send the children's contribution blocks while extracting from A
+    this->extend_add_post();
     const auto dupd = this->dim_upd();
     const auto dsep = this->dim_sep();
     if (dsep) {
@@ -170,23 +153,262 @@ namespace strumpack {
       F22_ = DistM_t(grid(), dupd, dupd);
       F22_.zero();
     }
-    extend_add();
+    this->extend_add_wait(F11_, F12_, F21_, F22_);
   }
 
   template<typename scalar_t,typename integer_t> void
-  FrontalMatrixDenseMPI<scalar_t,integer_t>::partial_factorization() {
-    if (this->dim_sep() && grid()->active()) {
+  FrontalMatrixDenseMPI<scalar_t,integer_t>::partial_factorization
+  (const SPOptions<scalar_t>& opts) {
+    if (!this->dim_sep()) return;
+    if (opts.lookahead_LU()) partial_factorization_lookahead();
+    else if (grid()->active()) {
       piv = F11_.LU();
-      STRUMPACK_FULL_RANK_FLOPS(LU_flops(F11_));
       if (this->dim_upd()) {
         F12_.laswp(piv, true);
         trsm(Side::L, UpLo::L, Trans::N, Diag::U, scalar_t(1.), F11_, F12_);
         trsm(Side::R, UpLo::U, Trans::N, Diag::N, scalar_t(1.), F11_, F21_);
         gemm(Trans::N, Trans::N, scalar_t(-1.), F21_, F12_, scalar_t(1.), F22_);
+      }
+    }
+    if (grid()->active()) {
+      STRUMPACK_FULL_RANK_FLOPS(LU_flops(F11_));
+      if (this->dim_upd())
         STRUMPACK_FULL_RANK_FLOPS
           (gemm_flops(Trans::N, Trans::N, scalar_t(-1.), F21_, F12_, scalar_t(1.)) +
            trsm_flops(Side::L, scalar_t(1.), F11_, F12_) +
            trsm_flops(Side::R, scalar_t(1.), F11_, F21_));
+    }
+  }
+
+  /**
+   * Right-looking LU of the front, by panels of one block column,
+   * working directly on the local parts of F11, F12, F21 and F22.
+   * The pivots of a panel are selected with tournament pivoting:
+   * every process in the process column owning the panel proposes
+   * its partial pivoting rows, and a single partial pivoting LU on
+   * all these candidates selects the pivots. The processes owning
+   * the next panel first update and factor that panel, and only then
+   * finish the trailing update (lookahead). The pivots are stored in
+   * the ScaLAPACK format, so the solve is the same as after
+   * F11_.LU().
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixDenseMPI<scalar_t,integer_t>::partial_factorization_lookahead() {
+    // this is collective on all ranks of the front, also the idle ones
+    const bool active = grid()->active();
+    auto rcomm = Comm().split
+      (active ? grid()->prow() : MPI_UNDEFINED, grid()->pcol());
+    auto ccomm = Comm().split
+      (active ? grid()->pcol() : MPI_UNDEFINED, grid()->prow());
+    if (!active) return;
+    assert(F11_.fixed());
+    const bool upd = this->dim_upd();
+    const int n = this->dim_sep(), B = F11_.MB(), npan = (n + B - 1) / B,
+      npr = grid()->nprows(), npc = grid()->npcols(),
+      pr = grid()->prow(), pc = grid()->pcol(),
+      r11 = F11_.lrows(), c11 = F11_.lcols(),
+      r21 = upd ? F21_.lrows() : 0, c12 = upd ? F12_.lcols() : 0,
+      ld11 = std::max(1, F11_.ld()), ld12 = upd ? std::max(1, F12_.ld()) : 1,
+      ld21 = upd ? std::max(1, F21_.ld()) : 1,
+      ld22 = upd ? std::max(1, F22_.ld()) : 1;
+    scalar_t *A11 = F11_.data(), *A12 = upd ? F12_.data() : nullptr,
+      *A21 = upd ? F21_.data() : nullptr, *A22 = upd ? F22_.data() : nullptr;
+    // local rows/columns of F11 before global row/column g, with g
+    // a multiple of B, or g == n
+    auto lrows_before = [&](int g) {
+      if (g >= n) return r11;
+      return (g / B / npr + (pr < (g / B) % npr)) * B;
+    };
+    auto lcols_before = [&](int g) {
+      if (g >= n) return c11;
+      return (g / B / npc + (pc < (g / B) % npc)) * B;
+    };
+    auto row_owner = [&](int g) { return (g / B) % npr; };
+    auto row_local = [&](int g) { return g / B / npr * B + g % B; };
+    piv.assign(r11 + B, 0);
+
+    // Move the pivot rows sel of panel k to the top of the panel, in
+    // the local columns of the panel, or in all other local columns
+    // of F11 and F12. This is collective on the process column.
+    auto swap_rows = [&](int k, const std::vector<int>& sel, bool panel) {
+      const int c0 = k * B, w = sel.size(), lc = lcols_before(c0);
+      std::vector<scalar_t*> cols;
+      for (int j=0; j<c11; j++) {
+        bool in_panel = pc == k % npc && j >= lc && j < lc + w;
+        if (in_panel == panel) cols.push_back(A11 + j*ld11);
+      }
+      if (!panel)
+        for (int j=0; j<c12; j++) cols.push_back(A12 + j*ld12);
+      // the same sequence of interchanges as in LAPACK, reduced to a
+      // permutation of the affected rows: at maps a position to the
+      // row originally there, loc maps an original row to a position
+      std::map<int,int> at, loc;
+      auto get = [](const std::map<int,int>& m, int i) {
+        auto it = m.find(i); return it == m.end() ? i : it->second; };
+      for (int i=0; i<w; i++) {
+        const int t = c0 + i, s = get(loc, sel[i]),
+          rt = get(at, t), rs = get(at, s);
+        at[t] = rs;  loc[rs] = t;
+        at[s] = rt;  loc[rt] = s;
+        if (!panel && row_owner(t) == pr) piv[row_local(t)] = s + 1;
+      }
+      std::vector<std::vector<scalar_t>> sbuf(npr);
+      for (auto& a : at)
+        if (a.first != a.second && row_owner(a.second) == pr) {
+          auto& b = sbuf[row_owner(a.first)];
+          const int r = row_local(a.second);
+          for (auto c : cols) b.push_back(c[r]);
+        }
+      std::vector<scalar_t> rbuf;
+      std::vector<scalar_t*> pbuf;
+      ccomm.all_to_all_v(sbuf, rbuf, pbuf);
+      for (auto& a : at)
+        if (a.first != a.second && row_owner(a.first) == pr) {
+          auto& b = pbuf[row_owner(a.second)];
+          const int r = row_local(a.first);
+          for (auto c : cols) c[r] = *b++;
+        }
+    };
+
+    // Tournament pivoting on panel k, followed by the computation of
+    // the L factor of the panel, in F11 and F21. Called by all
+    // processes of the process column owning panel k. Returns the
+    // pivot rows and the LU factors of the diagonal block.
+    auto factor_panel = [&]
+      (int k, std::vector<int>& sel, std::vector<scalar_t>& LU11) {
+      const int c0 = k * B, w = std::min(B, n - c0),
+        r0 = lrows_before(c0), m = r11 - r0, lc = lcols_before(c0),
+        nc = std::min(m, w);
+      int info;
+      // local candidates, with partial pivoting on the local rows
+      std::vector<int> cand(m);
+      std::iota(cand.begin(), cand.end(), 0);
+      if (nc) {
+        DenseM_t W(m, w);
+        for (int j=0; j<w; j++)
+          std::copy(A11+r0+(lc+j)*ld11, A11+r0+(lc+j)*ld11+m, W.ptr(0, j));
+        std::vector<int> ipiv(nc);
+        blas::getrf(m, w, W.data(), W.ld(), ipiv.data(), &info);
+        for (int i=0; i<nc; i++) std::swap(cand[i], cand[ipiv[i]-1]);
+      }
+      std::vector<int> cnt(npr), dsp(npr);
+      MPI_Allgather(&nc, 1, MPI_INT, cnt.data(), 1, MPI_INT, ccomm.comm());
+      int tot = 0;
+      for (int p=0; p<npr; p++) { dsp[p] = tot; tot += cnt[p]; }
+      std::vector<int> lrow(nc), grow(tot);
+      std::vector<scalar_t> lval(nc*w), gval(tot*w);
+      for (int i=0; i<nc; i++) {
+        lrow[i] = F11_.rowl2g_fixed(r0+cand[i]);
+        for (int j=0; j<w; j++)
+          lval[i*w+j] = A11[r0+cand[i]+(lc+j)*ld11];
+      }
+      MPI_Allgatherv
+        (lrow.data(), nc, MPI_INT, grow.data(), cnt.data(), dsp.data(),
+         MPI_INT, ccomm.comm());
+      for (int p=0; p<npr; p++) { cnt[p] *= w; dsp[p] *= w; }
+      MPI_Allgatherv
+        (lval.data(), nc*w, mpi_type<scalar_t>(), gval.data(), cnt.data(),
+         dsp.data(), mpi_type<scalar_t>(), ccomm.comm());
+      // the tournament, the same on all processes of this column
+      DenseM_t S(tot, w);
+      for (int i=0; i<tot; i++)
+        for (int j=0; j<w; j++)
+          S(i, j) = gval[i*w+j];
+      std::vector<int> ipiv(w), perm(tot);
+      blas::getrf(tot, w, S.data(), S.ld(), ipiv.data(), &info);
+      if (info) {
+        std::cerr << "ERROR: LU factorization of DistributedMatrix failed"
+                  << " with info = " << c0 + info << std::endl;
+        exit(1);
+      }
+      std::iota(perm.begin(), perm.end(), 0);
+      for (int i=0; i<w; i++) std::swap(perm[i], perm[ipiv[i]-1]);
+      sel.resize(w);
+      LU11.resize(w*w);
+      for (int i=0; i<w; i++) sel[i] = grow[perm[i]];
+      for (int j=0; j<w; j++)
+        std::copy(S.ptr(0, j), S.ptr(0, j)+w, &LU11[j*w]);
+      swap_rows(k, sel, true);
+      if (pr == row_owner(c0))
+        for (int j=0; j<w; j++)
+          std::copy(&LU11[j*w], &LU11[j*w]+w, A11+r0+(lc+j)*ld11);
+      const int r1 = lrows_before(c0+w);
+      if (r11 > r1)
+        blas::trsm('R', 'U', 'N', 'N', r11-r1, w, scalar_t(1.),
+                   LU11.data(), w, A11+r1+lc*ld11, ld11);
+      if (r21)
+        blas::trsm('R', 'U', 'N', 'N', r21, w, scalar_t(1.),
+                   LU11.data(), w, A21+lc*ld21, ld21);
+    };
+
+    std::vector<int> sel;
+    std::vector<scalar_t> LU11, Lb, Ub;
+    if (pc == 0) factor_panel(0, sel, LU11);
+    for (int k=0; k<npan; k++) {
+      const int c0 = k * B, w = std::min(B, n - c0),
+        pck = k % npc, prk = k % npr,
+        r0 = lrows_before(c0), r1 = lrows_before(c0+w),
+        c1 = lcols_before(c0+w), m1 = r11 - r1, n1 = c11 - c1;
+      sel.resize(w);
+      LU11.resize(w*w);
+      MPI_Bcast(sel.data(), w, MPI_INT, pck, rcomm.comm());
+      MPI_Bcast(LU11.data(), w*w, mpi_type<scalar_t>(), pck, rcomm.comm());
+      swap_rows(k, sel, false);
+      // block row of U, right of the panel, in F11 and F12
+      Ub.resize(w*(n1+c12));
+      if (pr == prk) {
+        if (n1)
+          blas::trsm('L', 'L', 'N', 'U', w, n1, scalar_t(1.),
+                     LU11.data(), w, A11+r0+c1*ld11, ld11);
+        if (c12)
+          blas::trsm('L', 'L', 'N', 'U', w, c12, scalar_t(1.),
+                     LU11.data(), w, A12+r0, ld12);
+        for (int j=0; j<n1; j++)
+          std::copy(A11+r0+(c1+j)*ld11, A11+r0+(c1+j)*ld11+w, Ub.data()+j*w);
+        for (int j=0; j<c12; j++)
+          std::copy(A12+r0+j*ld12, A12+r0+j*ld12+w, Ub.data()+(n1+j)*w);
+      }
+      MPI_Bcast(Ub.data(), Ub.size(), mpi_type<scalar_t>(), prk, ccomm.comm());
+      // block column of L, below the panel, in F11 and F21
+      Lb.resize((m1+r21)*w);
+      if (pc == pck) {
+        const int lc = lcols_before(c0);
+        for (int j=0; j<w; j++) {
+          std::copy(A11+r1+(lc+j)*ld11, A11+r11+(lc+j)*ld11,
+                    Lb.data()+j*m1);
+          if (r21)
+            std::copy(A21+(lc+j)*ld21, A21+(lc+j)*ld21+r21,
+                      Lb.data()+m1*w+j*r21);
+        }
+      }
+      MPI_Bcast(Lb.data(), Lb.size(), mpi_type<scalar_t>(), pck, rcomm.comm());
+      const scalar_t *L1 = Lb.data(), *L2 = L1 + m1*w,
+        *U1 = Ub.data(), *U2 = U1 + n1*w;
+      // trailing update of the local columns [cb, ce) of F11 and F21
+      auto update = [&](int cb, int ce) {
+        if (ce <= cb) return;
+        if (m1)
+          blas::gemm('N', 'N', m1, ce-cb, w, scalar_t(-1.), L1, m1,
+                     U1+(cb-c1)*w, w, scalar_t(1.), A11+r1+cb*ld11, ld11);
+        if (r21)
+          blas::gemm('N', 'N', r21, ce-cb, w, scalar_t(-1.), L2, r21,
+                     U1+(cb-c1)*w, w, scalar_t(1.), A21+cb*ld21, ld21);
+      };
+      int cn = c1;
+      if (k+1 < npan && pc == (k+1) % npc) {
+        // lookahead: the next panel is the first block of local columns
+        cn = c1 + std::min(B, n - c0 - w);
+        update(c1, cn);
+        factor_panel(k+1, sel, LU11);
+      }
+      update(cn, c11);
+      if (c12) {
+        if (m1)
+          blas::gemm('N', 'N', m1, c12, w, scalar_t(-1.), L1, m1,
+                     U2, w, scalar_t(1.), A12+r1, ld12);
+        if (r21)
+          blas::gemm('N', 'N', r21, c12, w, scalar_t(-1.), L2, r21,
+                     U2, w, scalar_t(1.), A22, ld22);
       }
     }
   }
@@ -199,10 +421,13 @@ namespace strumpack {
       lchild_->multifrontal_factorization(A, opts, etree_level+1, task_depth);
     if (visit(rchild_))
       rchild_->multifrontal_factorization(A, opts, etree_level+1, task_depth);
+    TraceSpan trace("factor_dense_MPI", this->sep_, etree_level,
+                    this->dim_sep()+this->dim_upd());
     build_front(A);
     if (lchild_) lchild_->release_work_memory();
     if (rchild_) rchild_->release_work_memory();
-    partial_factorization();
+    partial_factorization(opts);
+    trace.set_bytes(this->node_factor_nonzeros() * sizeof(scalar_t));
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -65,34 +65,50 @@ namespace strumpack {
      const std::vector<std::size_t>& I, int task_depth);
 
     void release_work_memory() override;
+    int initial_samples(const HSS::HSSOptions<scalar_t>& opts) const;
     void random_sampling
     (const SpMat_t& A, const SPOptions<scalar_t>& opts, DenseM_t& Rr,
      DenseM_t& Rc, DenseM_t& Sr, DenseM_t& Sc, int etree_level,
      int task_depth); // TODO const?
+    void random_vectors
+    (const SPOptions<scalar_t>& opts, DenseM_t& R,
+     std::uint32_t col0) const;
     void element_extraction
     (const SpMat_t& A, const std::vector<std::size_t>& I,
      const std::vector<std::size_t>& J, DenseM_t& B, int task_depth);
+    void element_extraction
+    (const SpMat_t& A, const std::vector<std::vector<std::size_t>>& I,
+     const std::vector<std::vector<std::size_t>>& J,
+     std::vector<DenseMW_t>& B, int task_depth);
     void extract_CB_sub_matrix
     (const std::vector<std::size_t>& I, const std::vector<std::size_t>& J,
      DenseM_t& B, int task_depth) const;
+    void extract_CB_sub_matrix_blocks
+    (const std::vector<std::vector<std::size_t>>& I,
+     const std::vector<std::vector<std::size_t>>& J,
+     std::vector<DenseMW_t>& B, int task_depth) const override;
 
     void multifrontal_factorization
+    (const SpMat_t& A, const SPOptions<scalar_t>& opts,
+     int etree_level=0, int task_depth=0) override;
+    void factor_node
     (const SpMat_t& A, const SPOptions<scalar_t>& opts,
      int etree_level=0, int task_depth=0) override;
 
     void forward_multifrontal_solve
-    (DenseM_t& b, DenseM_t* work, int etree_level=0,
-     int task_depth=0) const override;
+    (DenseM_t& b, DenseM_t* work, const SolvePruning* prune,
+     int etree_level=0, int task_depth=0) const override;
     void backward_multifrontal_solve
-    (DenseM_t& y, DenseM_t* work, int etree_level=0,
-     int task_depth=0) const override;
+    (DenseM_t& y, DenseM_t* work, const SolvePruning* prune,
+     int etree_level=0, int task_depth=0) const override;
 
     integer_t maximum_rank(int task_depth=0) const override;
+    integer_t front_rank() const override { return _H.rank(); }
     void print_rank_statistics(std::ostream &out) const override;
     bool isHSS() const override { return true; };
     std::string type() const override { return "FrontalMatrixHSS"; }
 
-    int random_samples() const { return R1.cols(); };
+    int random_samples() const override { return Sr2.cols(); }
     void bisection_partitioning
     (const SPOptions<scalar_t>& opts, integer_t* sorder,
      bool isroot=true, int task_depth=0) override;
@@ -121,25 +137,28 @@ namespace strumpack {
         then later used to sample the Schur complement when
         compressing the parent front */
     DenseM_t R1;        /* top of the random matrix used to construct
-                           HSS matrix of this front */
+                           HSS matrix of this front, not stored
+                           if opts.HSS_regenerate_random() */
     DenseM_t Sr2, Sc2;  /* bottom of the sample matrix used to
                            construct HSS matrix of this front */
     std::uint32_t _sampled_columns = 0;
 
+    /** partitioning used to construct _H, kept to rebuild _H when
+        the front is factored again with new matrix values */
+    HSS::HSSPartitionTree _hss_tree;
+
   private:
     FrontalMatrixHSS(const FrontalMatrixHSS&) = delete;
     FrontalMatrixHSS& operator=(FrontalMatrixHSS const&) = delete;
 
     void draw_node(std::ostream& of, bool is_root) const override;
 
-    void multifrontal_factorization_node
-    (const SpMat_t& A, const SPOptions<scalar_t>& opts,
-     int etree_level, int task_depth);
-
     void fwd_solve_node
-    (DenseM_t& b, DenseM_t* work, int etree_level, int task_depth) const;
+    (DenseM_t& b, DenseM_t* work, const SolvePruning* prune,
+     int etree_level, int task_depth) const;
     void bwd_solve_node
-    (DenseM_t& y, DenseM_t* work, int etree_level, int task_depth) const;
+    (DenseM_t& y, DenseM_t* work, const SolvePruning* prune,
+     int etree_level, int task_depth) const;
 
     long long node_factor_nonzeros() const override;
 
@@ -277,6 +296,87 @@ namespace strumpack {
     }
   }
 
+  /**
+   * Batched version of extract_CB_sub_matrix. The HSS part of all
+   * blocks is extracted with a single call to HSSMatrix::extract. For
+   * the low-rank part, the required rows/columns of the two factors
+   * are gathered for all blocks at once, in one buffer per factor,
+   * followed by one gemm per block, which also accumulates the HSS
+   * part, before a single scatter to B. The gemms are not batched,
+   * since the BLAS wrappers have no batched gemm, but they run as
+   * independent tasks. For many small blocks, the overhead of these
+   * separate calls can still be significant.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixHSS<scalar_t,integer_t>::extract_CB_sub_matrix_blocks
+  (const std::vector<std::vector<std::size_t>>& I,
+   const std::vector<std::vector<std::size_t>>& J,
+   std::vector<DenseMW_t>& B, int task_depth) const {
+    const auto nb = I.size();
+    std::vector<std::vector<std::size_t>> lI(nb), oI(nb), lJ(nb), oJ(nb);
+    std::vector<std::size_t> offI(nb+1, 0), offJ(nb+1, 0);
+    for (std::size_t k=0; k<nb; k++) {
+      this->find_upd_indices(J[k], lJ[k], oJ[k]);
+      if (!lJ[k].empty()) this->find_upd_indices(I[k], lI[k], oI[k]);
+      if (lI[k].empty()) lJ[k].clear();
+      offI[k+1] = offI[k] + lI[k].size();
+      offJ[k+1] = offJ[k] + lJ[k].size();
+    }
+    if (!offI[nb]) return;
+
+#pragma omp parallel if(!omp_in_parallel())
+#pragma omp single
+    {
+      auto M = _H.child(1)->extract(lI, lJ);
+      const bool theta = _Theta.cols() < _Phi.cols();
+      // S = F22 - _Theta * _ThetaVhatC_or_VhatCPhiC, or
+      // S = F22 - _ThetaVhatC_or_VhatCPhiC * _Phi'
+      const auto& L = theta ? _Theta : _ThetaVhatC_or_VhatCPhiC;
+      const auto r = L.cols();
+      DenseM_t Lg(offI[nb], r), Rg;
+      if (theta) Rg = DenseM_t(r, offJ[nb]);
+      else Rg = DenseM_t(offJ[nb], r);
+      for (std::size_t k=0; k<nb; k++) {
+        for (std::size_t i=0; i<lI[k].size(); i++)
+          copy(1, r, L, lI[k][i], 0, Lg, offI[k]+i, 0);
+        for (std::size_t j=0; j<lJ[k].size(); j++)
+          if (theta)
+            copy(r, 1, _ThetaVhatC_or_VhatCPhiC, 0, lJ[k][j],
+                 Rg, 0, offJ[k]+j);
+          else copy(1, r, _Phi, lJ[k][j], 0, Rg, offJ[k]+j, 0);
+      }
+      for (std::size_t k=0; k<nb; k++) {
+        if (lI[k].empty()) continue;
+#pragma omp task default(shared) firstprivate(k)                        \
+  if(task_depth < params::task_recursion_cutoff_level)
+        {
+          auto m = lI[k].size(), n = lJ[k].size();
+          DenseMW_t Lk(m, r, Lg, offI[k], 0);
+          if (theta) {
+            DenseMW_t Rk(r, n, Rg, 0, offJ[k]);
+            gemm(Trans::N, Trans::N, scalar_t(-1.), Lk, Rk,
+                 scalar_t(1.), M[k], task_depth);
+            STRUMPACK_EXTRACTION_FLOPS
+              (gemm_flops(Trans::N, Trans::N, scalar_t(-1.), Lk, Rk,
+                          scalar_t(1.)));
+          } else {
+            DenseMW_t Rk(n, r, Rg, offJ[k], 0);
+            gemm(Trans::N, Trans::C, scalar_t(-1.), Lk, Rk,
+                 scalar_t(1.), M[k], task_depth);
+            STRUMPACK_EXTRACTION_FLOPS
+              (gemm_flops(Trans::N, Trans::C, scalar_t(-1.), Lk, Rk,
+                          scalar_t(1.)));
+          }
+          for (std::size_t j=0; j<n; j++)
+            for (std::size_t i=0; i<m; i++)
+              B[k](oI[k][i], oJ[k][j]) += M[k](i, j);
+          STRUMPACK_EXTRACTION_FLOPS(m*n);
+        }
+      }
+#pragma omp taskwait
+    }
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixHSS<scalar_t,integer_t>::sample_CB
   (const SPOptions<scalar_t>& opts, const DenseM_t& R,
@@ -284,11 +384,15 @@ namespace strumpack {
     if (!dim_upd()) return;
     auto I = this->upd_to_parent(pa);
     auto cR = R.extract_rows(I);
-    auto dchild = R1.cols();
+    std::size_t dchild = random_samples();
     auto dall = R.cols();
     if (dchild > 0 && opts.indirect_sampling()) {
       DenseM_t cSr, cSc;
       DenseMW_t cRd0(cR.rows(), dchild, cR, 0, 0);
+      if (opts.HSS_regenerate_random()) {
+        R1 = DenseM_t(dim_sep(), dchild);
+        random_vectors(opts, R1, 0);
+      }
       _H.Schur_product_indirect(_ULV, _DUB01, R1, cRd0, Sr2, Sc2, cSr, cSc);
       DenseMW_t(Sr.rows(), dchild, Sr, 0, 0)
         .scatter_rows_add(I, cSr, task_depth);
@@ -357,8 +461,14 @@ namespace strumpack {
     if (task_depth == 0)
 #pragma omp parallel if(!omp_in_parallel())
 #pragma omp single
-      multifrontal_factorization_node(A, opts, etree_level, task_depth);
-    else multifrontal_factorization_node(A, opts, etree_level, task_depth);
+      {
+        this->factor_children(A, opts, etree_level, task_depth);
+        factor_node(A, opts, etree_level, task_depth);
+      }
+    else {
+      this->factor_children(A, opts, etree_level, task_depth);
+      factor_node(A, opts, etree_level, task_depth);
+    }
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -371,39 +481,8 @@ namespace strumpack {
     const auto dsep = dim_sep();
     const auto dupd = dim_upd();
     if (opts.indirect_sampling()) {
-      auto rgen = random::make_random_generator<real_t>
-        (opts.HSS_options().random_engine(),
-         opts.HSS_options().random_distribution());
-      auto dd = opts.HSS_options().dd();
-      auto d0 = opts.HSS_options().d0();
-      integer_t d = Rr.cols();
-      integer_t m = Rr.rows();
-      if (d0 % dd == 0) {
-        for (integer_t c=0; c<d; c+=dd) {
-          integer_t r = 0, cs = c + _sampled_columns;
-          for (; r<dsep; r++) {
-            rgen->seed(std::uint32_t(r+sep_begin_), std::uint32_t(cs));
-            for (integer_t cc=c; cc<c+dd; cc++)
-              Rr(r,cc) = Rc(r,cc) = rgen->get();
-          }
-          for (; r<m; r++) {
-            rgen->seed(std::uint32_t(this->upd_[r-dsep]),
-                       std::uint32_t(cs));
-            for (integer_t cc=c; cc<c+dd; cc++)
-              Rr(r,cc) = Rc(r,cc) = rgen->get();
-          }
-        }
-      } else {
-        for (integer_t c=0; c<d; c++) {
-          integer_t r = 0, cs = c + _sampled_columns;
-          for (; r<dsep; r++)
-            Rr(r,c) = Rc(r,c) = rgen->get(r+sep_begin_, cs);
-          for (; r<m; r++)
-            Rr(r,c) = Rc(r,c) = rgen->get(this->upd_[r-dsep], cs);
-        }
-      }
-      STRUMPACK_FLOPS(rgen->flops_per_prng()*d*m);
-      STRUMPACK_RANDOM_FLOPS(rgen->flops_per_prng()*d*m);
+      random_vectors(opts, Rr, _sampled_columns);
+      Rc.copy(Rr);
     }
 
     A.front_multiply
@@ -417,15 +496,63 @@ namespace strumpack {
       auto dold = R1.cols();
       auto dd = Rr.cols();
       auto dnew = dold + dd;
-      R1.resize(dsep, dnew);
+      if (!opts.HSS_regenerate_random()) {
+        R1.resize(dsep, dnew);
+        copy(dsep, dd, Rr, 0, 0, R1, 0, dold);
+      }
       Sr2.resize(dupd, dnew);
       Sc2.resize(dupd, dnew);
-      copy(dsep, dd, Rr, 0, 0, R1, 0, dold);
       copy(dupd, dd, Sr, dsep, 0, Sr2, 0, dold);
       copy(dupd, dd, Sc, dsep, 0, Sc2, 0, dold);
     }
   }
 
+  /**
+   * Fill R with the random vectors for indirect sampling, for
+   * samples col0, ..., col0+R.cols()-1. Row r of R corresponds to
+   * row r of the front, i.e., to separator row sep_begin_+r or to
+   * update row upd_[r-dim_sep()]. The generator is seeded with the
+   * global row index and the (start of the block of dd) sample
+   * index, so the same random vectors are obtained for any subset of
+   * rows or samples, in any front. This is what allows the children
+   * to regenerate R1 instead of storing it, see
+   * SPOptions::enable_HSS_regenerate_random().
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixHSS<scalar_t,integer_t>::random_vectors
+  (const SPOptions<scalar_t>& opts, DenseM_t& R,
+   std::uint32_t col0) const {
+    auto rgen = random::make_random_generator<real_t>
+      (opts.HSS_options().random_engine(),
+       opts.HSS_options().random_distribution());
+    const integer_t dsep = dim_sep();
+    const integer_t d = R.cols();
+    const integer_t m = R.rows();
+    auto grow = [&](integer_t r) {
+      return std::uint32_t((r < dsep) ? r+sep_begin_ : this->upd_[r-dsep]);
+    };
+    const std::uint32_t dd = opts.HSS_options().dd();
+    if (opts.HSS_options().d0() % dd == 0) {
+      for (integer_t c=0; c<d; ) {
+        std::uint32_t cs = c + col0, cb = (cs / dd) * dd;
+        integer_t ce = std::min(d, integer_t(c + cb + dd - cs));
+        for (integer_t r=0; r<m; r++) {
+          rgen->seed(grow(r), cb);
+          rgen->discard(cs - cb);
+          for (integer_t cc=c; cc<ce; cc++)
+            R(r,cc) = rgen->get();
+        }
+        c = ce;
+      }
+    } else {
+      for (integer_t c=0; c<d; c++)
+        for (integer_t r=0; r<m; r++)
+          R(r,c) = rgen->get(grow(r), c + col0);
+    }
+    STRUMPACK_FLOPS(rgen->flops_per_prng()*d*m);
+    STRUMPACK_RANDOM_FLOPS(rgen->flops_per_prng()*d*m);
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixHSS<scalar_t,integer_t>::element_extraction
   (const SpMat_t& A, const std::vector<std::size_t>& I,
@@ -447,38 +574,55 @@ namespace strumpack {
       rchild_->extract_CB_sub_matrix(gI, gJ, B, task_depth);
   }
 
+  /**
+   * Batched version of element_extraction, used when compressing the
+   * front level by level.
+   */
   template<typename scalar_t,typename integer_t> void
-  FrontalMatrixHSS<scalar_t,integer_t>::multifrontal_factorization_node
+  FrontalMatrixHSS<scalar_t,integer_t>::element_extraction
+  (const SpMat_t& A, const std::vector<std::vector<std::size_t>>& I,
+   const std::vector<std::vector<std::size_t>>& J,
+   std::vector<DenseMW_t>& B, int task_depth) {
+    const auto nb = I.size();
+    const auto dsep = dim_sep();
+    std::vector<std::vector<std::size_t>> gI(nb), gJ(nb);
+    for (std::size_t k=0; k<nb; k++) {
+      gI[k].reserve(I[k].size());
+      gJ[k].reserve(J[k].size());
+      for (auto i : I[k])
+        gI[k].push_back
+          ((integer_t(i) < dsep) ? i+sep_begin_ : this->upd_[i-dsep]);
+      for (auto j : J[k])
+        gJ[k].push_back
+          ((integer_t(j) < dsep) ? j+sep_begin_ : this->upd_[j-dsep]);
+      A.extract_separator(sep_end_, gI[k], gJ[k], B[k], task_depth);
+    }
+    if (lchild_)
+      lchild_->extract_CB_sub_matrix_blocks(gI, gJ, B, task_depth);
+    if (rchild_)
+      rchild_->extract_CB_sub_matrix_blocks(gI, gJ, B, task_depth);
+  }
+
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixHSS<scalar_t,integer_t>::factor_node
   (const SpMat_t& A, const SPOptions<scalar_t>& opts,
    int etree_level, int task_depth) {
-    bool tasked = task_depth < params::task_recursion_cutoff_level;
-    if (tasked) {
-      if (lchild_)
-#pragma omp task default(shared)                                        \
-  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-        lchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth+1);
-      if (rchild_)
-#pragma omp task default(shared)                                        \
-  final(task_depth >= params::task_recursion_cutoff_level-1) mergeable
-        rchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth+1);
-#pragma omp taskwait
-    } else {
-      if (lchild_)
-        lchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth);
-      if (rchild_)
-        rchild_->multifrontal_factorization
-          (A, opts, etree_level+1, task_depth);
+    TraceSpan trace("factor_HSS", this->sep_, etree_level,
+                    this->dim_sep()+this->dim_upd());
+    if (!_H.is_untouched()) {
+      // refactorization, the previous compression (and the trailing
+      // block, see release_work_memory) is lost
+      _H = HSS::HSSMatrix<scalar_t>(_hss_tree, opts.HSS_options());
+      _sampled_columns = 0;
     }
     _H.set_openmp_task_depth(task_depth);
     auto mult = [&](DenseM_t& Rr, DenseM_t& Rc, DenseM_t& Sr, DenseM_t& Sc) {
       random_sampling(A, opts, Rr, Rc, Sr, Sc, etree_level, task_depth);
       _sampled_columns += Rr.cols();
     };
-    auto elem = [&](const std::vector<std::size_t>& I,
-                    const std::vector<std::size_t>& J, DenseM_t& B) {
+    auto elem = [&](const std::vector<std::vector<std::size_t>>& I,
+                    const std::vector<std::vector<std::size_t>>& J,
+                    std::vector<DenseMW_t>& B) {
       element_extraction(A, I, J, B, task_depth);
     };
     auto HSSopts = opts.HSS_options();
@@ -487,6 +631,8 @@ namespace strumpack {
       child_samples = lchild_->random_samples();
     if (rchild_)
       child_samples = std::max(child_samples, rchild_->random_samples());
+    if (opts.HSS_rank_estimate())
+      HSSopts.set_d0(initial_samples(HSSopts));
     HSSopts.set_d0(std::max(child_samples - HSSopts.dd(), HSSopts.d0()));
     if (opts.indirect_sampling())
       HSSopts.set_user_defined_random(true);
@@ -514,24 +660,27 @@ namespace strumpack {
       } else
         _ULV = _H.factor();
     }
+    trace.set_bytes(this->node_factor_nonzeros() * sizeof(scalar_t));
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixHSS<scalar_t,integer_t>::forward_multifrontal_solve
-  (DenseM_t& b, DenseM_t* work, int etree_level, int task_depth) const {
+  (DenseM_t& b, DenseM_t* work, const SolvePruning* prune,
+   int etree_level, int task_depth) const {
     if (task_depth == 0)
 #pragma omp parallel if(!omp_in_parallel())
 #pragma omp single
-      fwd_solve_node(b, work, etree_level, task_depth);
-    else fwd_solve_node(b, work, etree_level, task_depth);
+      fwd_solve_node(b, work, prune, etree_level, task_depth);
+    else fwd_solve_node(b, work, prune, etree_level, task_depth);
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixHSS<scalar_t,integer_t>::fwd_solve_node
-  (DenseM_t& b, DenseM_t* work, int etree_level, int task_depth) const {
+  (DenseM_t& b, DenseM_t* work, const SolvePruning* prune,
+   int etree_level, int task_depth) const {
     DenseMW_t bupd(dim_upd(), b.cols(), work[0], 0, 0);
     bupd.zero();
-    this->fwd_solve_phase1(b, bupd, work, etree_level, task_depth);
+    this->fwd_solve_phase1(b, bupd, work, prune, etree_level, task_depth);
     if (etree_level) {
       if (_Theta.cols() && _Phi.cols()) {
         DenseMW_t bloc(dim_sep(), b.cols(), b, sep_begin_, 0);
@@ -554,17 +703,19 @@ namespace strumpack {
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixHSS<scalar_t,integer_t>::backward_multifrontal_solve
-  (DenseM_t& y, DenseM_t* work, int etree_level, int task_depth) const {
+  (DenseM_t& y, DenseM_t* work, const SolvePruning* prune,
+   int etree_level, int task_depth) const {
     if (task_depth == 0)
 #pragma omp parallel if(!omp_in_parallel())
 #pragma omp single
-      bwd_solve_node(y, work, etree_level, task_depth);
-    else bwd_solve_node(y, work, etree_level, task_depth);
+      bwd_solve_node(y, work, prune, etree_level, task_depth);
+    else bwd_solve_node(y, work, prune, etree_level, task_depth);
   }
 
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixHSS<scalar_t,integer_t>::bwd_solve_node
-  (DenseM_t& y, DenseM_t* work, int etree_level, int task_depth) const {
+  (DenseM_t& y, DenseM_t* work, const SolvePruning* prune,
+   int etree_level, int task_depth) const {
     DenseMW_t yupd(dim_upd(), y.cols(), work[0], 0, 0);
     if (etree_level) {
       if (_Phi.cols() && _Theta.cols()) {
@@ -580,7 +731,25 @@ namespace strumpack {
       DenseMW_t yloc(dim_sep(), y.cols(), y, sep_begin_, 0);
       _H.backward_solve(_ULV, *_ULVwork, yloc);
     }
-    this->bwd_solve_phase2(y, yupd, work, etree_level, task_depth);
+    this->bwd_solve_phase2(y, yupd, work, prune, etree_level, task_depth);
+  }
+
+  /**
+   * Initial number of random samples for the compression of this
+   * front, estimated from the HSS ranks of the children, and rounded
+   * up to a multiple of dd (for the indirect sampling). Returns
+   * opts.d0() if the children are not HSS compressed.
+   */
+  template<typename scalar_t,typename integer_t> int
+  FrontalMatrixHSS<scalar_t,integer_t>::initial_samples
+  (const HSS::HSSOptions<scalar_t>& opts) const {
+    integer_t r = 0;
+    if (lchild_) r = lchild_->front_rank();
+    if (rchild_) r = std::max(r, rchild_->front_rank());
+    if (r == 0) return opts.d0();
+    const int dd = opts.dd();
+    int d0 = ((r + dd - 1) / dd) * dd;
+    return std::max(dd, std::min(d0, opts.max_rank() - dd));
   }
 
   template<typename scalar_t,typename integer_t> integer_t
@@ -625,16 +794,15 @@ namespace strumpack {
   (const SPOptions<scalar_t>& opts, const HSS::HSSPartitionTree& sep_tree,
    bool is_root) {
     assert(sep_tree.size == dim_sep());
-    if (is_root)
-      _H = HSS::HSSMatrix<scalar_t>(sep_tree, opts.HSS_options());
+    if (is_root) _hss_tree = sep_tree;
     else {
-      HSS::HSSPartitionTree hss_tree(this->dim_blk());
-      hss_tree.c.reserve(2);
-      hss_tree.c.push_back(sep_tree);
-      hss_tree.c.emplace_back(dim_upd());
-      hss_tree.c.back().refine(opts.HSS_options().leaf_size());
-      _H = HSS::HSSMatrix<scalar_t>(hss_tree, opts.HSS_options());
+      _hss_tree = HSS::HSSPartitionTree(this->dim_blk());
+      _hss_tree.c.reserve(2);
+      _hss_tree.c.push_back(sep_tree);
+      _hss_tree.c.emplace_back(dim_upd());
+      _hss_tree.c.back().refine(opts.HSS_options().leaf_size());
     }
+    _H = HSS::HSSMatrix<scalar_t>(_hss_tree, opts.HSS_options());
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -669,16 +837,7 @@ namespace strumpack {
     //            if (sorder[i] == part) sorder[i] = -count++;
     // } else for (integer_t i=sep_begin_; i<sep_end_; i++) sorder[i] = -i;
 
-    if (isroot)
-      _H = HSS::HSSMatrix<scalar_t>(sep_tree, opts.HSS_options());
-    else {
-      HSS::HSSPartitionTree hss_tree(this->dim_blk());
-      hss_tree.c.reserve(2);
-      hss_tree.c.push_back(sep_tree);
-      hss_tree.c.emplace_back(dim_upd());
-      hss_tree.c.back().refine(opts.HSS_options().leaf_size());
-      _H = HSS::HSSMatrix<scalar_t>(hss_tree, opts.HSS_options());
-    }
+    set_HSS_partitioning(opts, sep_tree, isroot);
   }
 
 
@@ -143,6 +143,10 @@ namespace strumpack {
                           construct HSS matrix of this front */
     std::uint32_t _sampled_columns = 0;
 
+    /** partitioning used to construct _H, kept to rebuild _H when
+        the front is factored again with new matrix values */
+    HSS::HSSPartitionTree _hss_tree;
+
     using FrontalMatrix<scalar_t,integer_t>::lchild_;
     using FrontalMatrix<scalar_t,integer_t>::rchild_;
     using FrontalMatrix<scalar_t,integer_t>::dim_sep;
@@ -368,6 +372,15 @@ namespace strumpack {
       rchild_->multifrontal_factorization
         (A, opts, etree_level+1, task_depth);
     if (!dim_blk()) return;
+    TraceSpan trace("factor_HSS_MPI", this->sep_, etree_level, dim_blk());
+    if (!_H->is_untouched()) {
+      // refactorization, the previous compression (and the trailing
+      // block, see release_work_memory) is lost
+      _H = std::unique_ptr<HSS::HSSMatrixMPI<scalar_t>>
+        (new HSS::HSSMatrixMPI<scalar_t>
+         (_hss_tree, grid(), opts.HSS_options()));
+      _sampled_columns = 0;
+    }
 
     auto mult = [&](DistM_t& R, DistM_t& Sr, DistM_t& Sc) {
       TIMER_TIME(TaskType::RANDOM_SAMPLING, 0, t_sampling);
@@ -422,6 +435,7 @@ namespace strumpack {
         TIMER_STOP(t_fact);
       }
     }
+    trace.set_bytes(this->node_factor_nonzeros() * sizeof(scalar_t));
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -683,20 +697,17 @@ namespace strumpack {
     //if (!this->active()) return;
     if (Comm().is_null()) return;
     assert(sep_tree.size == dim_sep());
-    if (is_root)
-      _H = std::unique_ptr<HSS::HSSMatrixMPI<scalar_t>>
-        (new HSS::HSSMatrixMPI<scalar_t>
-         (sep_tree, grid(), opts.HSS_options()));
+    if (is_root) _hss_tree = sep_tree;
     else {
-      HSS::HSSPartitionTree hss_tree(dim_blk());
-      hss_tree.c.reserve(2);
-      hss_tree.c.push_back(sep_tree);
-      hss_tree.c.emplace_back(dim_upd());
-      hss_tree.c.back().refine(opts.HSS_options().leaf_size());
-      _H = std::unique_ptr<HSS::HSSMatrixMPI<scalar_t>>
-        (new HSS::HSSMatrixMPI<scalar_t>
-         (hss_tree, grid(), opts.HSS_options()));
+      _hss_tree = HSS::HSSPartitionTree(dim_blk());
+      _hss_tree.c.reserve(2);
+      _hss_tree.c.push_back(sep_tree);
+      _hss_tree.c.emplace_back(dim_upd());
+      _hss_tree.c.back().refine(opts.HSS_options().leaf_size());
     }
+    _H = std::unique_ptr<HSS::HSSMatrixMPI<scalar_t>>
+      (new HSS::HSSMatrixMPI<scalar_t>
+       (_hss_tree, grid(), opts.HSS_options()));
   }
 
   template<typename scalar_t,typename integer_t> void
@@ -717,20 +728,7 @@ namespace strumpack {
     // TODO also communicate the tree to everyone working on this front!!
     // see code in EliminationTreeMPIDist
 
-    if (isroot)
-      _H = std::unique_ptr<HSS::HSSMatrixMPI<scalar_t>>
-        (new HSS::HSSMatrixMPI<scalar_t>
-         (sep_tree, grid(), opts.HSS_options()));
-    else {
-      HSS::HSSPartitionTree hss_tree(dim_blk());
-      hss_tree.c.reserve(2);
-      hss_tree.c.push_back(sep_tree);
-      hss_tree.c.emplace_back(dim_upd());
-      hss_tree.c.back().refine(opts.HSS_options().leaf_size());
-      _H = std::unique_ptr<HSS::HSSMatrixMPI<scalar_t>>
-        (new HSS::HSSMatrixMPI<scalar_t>
-         (hss_tree, grid(), opts.HSS_options()));
-    }
+    set_HSS_partitioning(opts, sep_tree, isroot);
   }
 
 } // end namespace strumpack
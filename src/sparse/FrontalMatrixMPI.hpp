@@ -137,10 +137,24 @@ namespace strumpack {
     virtual void bisection_partitioning
     (const SPOptions<scalar_t>& opts, integer_t* sorder,
      bool isroot=true, int task_depth=0) override;
+    void find_CB_stack_roots
+    (std::vector<F_t*>& roots, bool pa_on_stack, int task_depth=0) override;
 
   protected:
     BLACSGrid blacs_grid_;     // 2D processor grid
 
+    // extend-add messages in flight, see extend_add_post
+    std::vector<std::vector<scalar_t>> ea_sbuf_;
+    std::vector<scalar_t> ea_rbuf_;
+    std::vector<scalar_t*> ea_pbuf_;
+    std::vector<MPI_Request> ea_req_;
+    // number of elements received from each rank in the extend-add,
+    // computed once and reused when refactoring
+    std::vector<std::size_t> ea_rsizes_;
+
+    void extend_add_post();
+    void extend_add_wait(DistM_t& F11, DistM_t& F12, DistM_t& F21, DistM_t& F22);
+
     using FrontalMatrix<scalar_t,integer_t>::lchild_;
     using FrontalMatrix<scalar_t,integer_t>::rchild_;
   };
@@ -313,6 +327,91 @@ namespace strumpack {
       (F11, F12, F21, F22, pbuf, pa, this);
   }
 
+  /**
+   * Pack the contribution blocks of the children that are on this
+   * rank and start sending them to the ranks of this front. This is
+   * called as soon as the children are factored, so that the
+   * messages are in flight while the front is being allocated and
+   * the entries from the sparse matrix are extracted, and while the
+   * ranks of the other child are still factoring. Messages are only
+   * exchanged between ranks that share part of a contribution
+   * block. The number of elements to receive from each rank is
+   * computed from the update indices and the grid shapes the first
+   * time, see ExtendAdd::extend_add_count_from_buffers, so the
+   * message sizes are never communicated. Complete the extend-add
+   * with extend_add_wait.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixMPI<scalar_t,integer_t>::extend_add_post() {
+    if (!lchild_ && !rchild_) return;
+    if (ea_rsizes_.empty()) {
+      ea_rsizes_.resize(this->P());
+      for (auto& ch : {lchild_.get(), rchild_.get()})
+        if (ch) ExtAdd::extend_add_count_from_buffers(ea_rsizes_, this, ch);
+    }
+    ea_sbuf_.resize(this->P());
+    for (auto& ch : {lchild_.get(), rchild_.get()}) {
+      if (ch && Comm().is_root()) {
+        STRUMPACK_FLOPS
+          (static_cast<long long int>(ch->dim_upd())*ch->dim_upd());
+      }
+      if (visit(ch)) ch->extend_add_copy_to_buffers(ea_sbuf_, this);
+    }
+    Comm().all_to_all_v_post
+      (ea_sbuf_, ea_rsizes_, ea_rbuf_, ea_pbuf_, ea_req_, 0);
+  }
+
+  /**
+   * Receive the contribution blocks sent by extend_add_post and add
+   * them to the front, which should be allocated. The children are
+   * mapped to disjoint ranges of ranks, so the contribution block of
+   * the left child is added as soon as all messages from its ranks
+   * have arrived, while the right child can still be busy. To keep
+   * the floating point summation order, and hence the result,
+   * independent of message timing, the right child is always added
+   * after the left child.
+   */
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixMPI<scalar_t,integer_t>::extend_add_wait
+  (DistM_t& F11, DistM_t& F12, DistM_t& F21, DistM_t& F22) {
+    if (!lchild_ && !rchild_) return;
+    const F_t* ch[2] = {lchild_.get(), rchild_.get()};
+    auto add = [&](int c) {
+      ch[c]->extend_add_copy_from_buffers
+        (F11, F12, F21, F22, ea_pbuf_.data()+master(ch[c]), this);
+    };
+    // the receive requests come first in ea_req_, in order of the
+    // source ranks, see all_to_all_v_post
+    std::vector<int> owner;
+    int left[2] = {0, 0};
+    for (int p=0; p<this->P(); p++) {
+      if (!ea_rsizes_[p]) continue;
+      int c = (ch[0] && p >= master(ch[0]) &&
+               p < master(ch[0]) + ch[0]->P()) ? 0 : 1;
+      owner.push_back(c);
+      left[c]++;
+    }
+    // add the children in order, as soon as all their messages are in
+    int next = 0;
+    auto add_ready = [&]() {
+      for (; next<2 && !left[next]; next++)
+        if (ch[next]) add(next);
+    };
+    add_ready();
+    int nr = owner.size(), done;
+    std::vector<int> idx(nr);
+    while (true) {
+      MPI_Waitsome
+        (nr, ea_req_.data(), &done, idx.data(), MPI_STATUSES_IGNORE);
+      if (done == MPI_UNDEFINED) break;
+      for (int i=0; i<done; i++) left[owner[idx[i]]]--;
+      add_ready();
+    }
+    // remaining are the sends
+    Comm().all_to_all_v_wait(ea_sbuf_, ea_req_);
+    std::vector<scalar_t>().swap(ea_rbuf_);
+  }
+
   template<typename scalar_t,typename integer_t> void
   FrontalMatrixMPI<scalar_t,integer_t>::extend_add_column_copy_from_buffers
   (DistM_t& B, DistM_t& Bupd, scalar_t** pbuf,
@@ -410,6 +509,15 @@ namespace strumpack {
       rchild_->bisection_partitioning(opts, sorder, false, task_depth);
   }
 
+  template<typename scalar_t,typename integer_t> void
+  FrontalMatrixMPI<scalar_t,integer_t>::find_CB_stack_roots
+  (std::vector<F_t*>& roots, bool /*pa_on_stack*/, int task_depth) {
+    if (visit(lchild_))
+      lchild_->find_CB_stack_roots(roots, false, task_depth);
+    if (visit(rchild_))
+      rchild_->find_CB_stack_roots(roots, false, task_depth);
+  }
+
 } // end namespace strumpack
 
 #endif //FRONTAL_MATRIX_MPI_HPP
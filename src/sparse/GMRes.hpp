@@ -33,6 +33,7 @@
 
 #include "StrumpackParameters.hpp"
 #include "CompressedSparseMatrix.hpp"
+#include "dense/DenseMatrix.hpp"
 
 namespace strumpack {
 
@@ -146,6 +147,172 @@ namespace strumpack {
     return rho;
   }
 
+  /*
+   * Left preconditioned restarted GMRes for multiple right-hand
+   * sides, the columns of b. Every column has its own Krylov
+   * subspace, but the iterations for all columns are done in
+   * lockstep, so that the matrix-vector product and the
+   * preconditioner are applied to a block of vectors at once (the
+   * columns that did not converge yet). With the multifrontal
+   * preconditioner, this replaces the triangular solves and
+   * matrix-vector products in every front by the corresponding
+   * matrix-matrix operations. totit is the number of (block)
+   * iterations. Returns the largest residual norm.
+   */
+  template<typename scalar_t> typename RealType<scalar_t>::value_type
+  BlockGMRes
+  (const std::function<void(const DenseMatrix<scalar_t>&,
+                            DenseMatrix<scalar_t>&)>& spmv,
+   const std::function<void(DenseMatrix<scalar_t>&)>& preconditioner,
+   DenseMatrix<scalar_t>& x, const DenseMatrix<scalar_t>& b,
+   typename RealType<scalar_t>::value_type rtol,
+   typename RealType<scalar_t>::value_type atol, int& totit, int maxit,
+   int restart, GramSchmidtType GStype, bool non_zero_guess, bool verbose) {
+    using real_t = typename RealType<scalar_t>::value_type;
+    using DenseM_t = DenseMatrix<scalar_t>;
+    if (restart > maxit) restart = maxit;
+    const std::size_t n = x.rows(), m = x.cols();
+    const int ldh = restart+1;
+    // column k of the Krylov basis for right-hand side c is column
+    // c+k*m of V, so the k-th basis vectors of all right-hand sides
+    // form a contiguous block
+    DenseM_t V(n, m*(restart+1)), hess(ldh, m*restart),
+      b_(ldh, m), givens_c(restart, m), givens_s(restart, m);
+    DenseM_t b_prec(b);
+    preconditioner(b_prec);
+    std::vector<real_t> rho(m), rho0(m);
+    std::vector<int> nrit(m);
+    std::vector<bool> conv(m, false);
+    // active columns, apply spmv/preconditioner to the block of
+    // columns c+k*m, for all active c
+    std::vector<std::size_t> act;
+    auto gather = [&](const DenseM_t& X, std::size_t k) {
+      DenseM_t Xa(n, act.size());
+      for (std::size_t j=0; j<act.size(); j++)
+        std::copy(X.ptr(0, act[j]+k*m), X.ptr(0, act[j]+k*m)+n,
+                  Xa.ptr(0, j));
+      return Xa;
+    };
+    auto scatter = [&](const DenseM_t& Xa, DenseM_t& X, std::size_t k) {
+      for (std::size_t j=0; j<act.size(); j++)
+        std::copy(Xa.ptr(0, j), Xa.ptr(0, j)+n, X.ptr(0, act[j]+k*m));
+    };
+    auto max_rel_res = [&]() {
+      real_t r = 0.;
+      for (auto c : act) r = std::max(r, rho[c]/rho0[c]);
+      return r;
+    };
+    totit = 0;
+    if (!non_zero_guess) x.zero();
+    while (true) {
+      act.clear();
+      for (std::size_t c=0; c<m; c++)
+        if (!conv[c]) act.push_back(c);
+      if (act.empty()) break;
+      auto Xa = gather(x, 0);
+      if (non_zero_guess || totit > 0) {
+        DenseM_t R(n, act.size());
+        spmv(Xa, R);
+        preconditioner(R);
+        for (std::size_t j=0; j<act.size(); j++)
+          blas::axpby(n, scalar_t(1.), b_prec.ptr(0, act[j]), 1,
+                      scalar_t(-1.), R.ptr(0, j), 1);
+        scatter(R, V, 0);
+      } else scatter(gather(b_prec, 0), V, 0);
+      for (auto c : act) {
+        rho[c] = blas::nrm2(n, V.ptr(0, c), 1);
+        if (totit == 0) rho0[c] = rho[c];
+        if (rho[c]/rho0[c] < rtol || rho[c] < atol) conv[c] = true;
+      }
+      act.erase(std::remove_if(act.begin(), act.end(),
+                               [&](std::size_t c) { return conv[c]; }),
+                act.end());
+      if (act.empty()) break;
+      for (auto c : act) {
+        blas::scal(n, scalar_t(1.)/rho[c], V.ptr(0, c), 1);
+        b_(0, c) = rho[c];
+        for (int i=1; i<=restart; i++) b_(i, c) = scalar_t(0.);
+        nrit[c] = restart-1;
+      }
+      if (verbose)
+        std::cout << "GMRES it. " << totit << "\tnrhs = " << act.size()
+                  << "\tmax rel.res = " << std::setw(12)
+                  << max_rel_res() << "\t restart!" << std::endl;
+      // columns that converge in this restart cycle are removed from
+      // act, but their solution still needs to be updated
+      auto cycle = act;
+      for (int it=0; it<restart && !act.empty(); it++) {
+        totit++;
+        if (act.size() == m) {
+          DenseMatrixWrapper<scalar_t> Vit(n, m, V, 0, it*m),
+            Vit1(n, m, V, 0, (it+1)*m);
+          spmv(Vit, Vit1);
+          preconditioner(Vit1);
+        } else {
+          DenseM_t W(n, act.size());
+          spmv(gather(V, it), W);
+          preconditioner(W);
+          scatter(W, V, it+1);
+        }
+        for (auto c : act) {
+          auto v = V.ptr(0, c);
+          auto w = V.ptr(0, c+(it+1)*m);
+          auto h = hess.ptr(0, c*restart+it);
+          auto gc = givens_c.ptr(0, c);
+          auto gs = givens_s.ptr(0, c);
+          auto bc = b_.ptr(0, c);
+          if (GStype == GramSchmidtType::CLASSICAL) {
+            blas::gemv('C', n, it+1, scalar_t(1.), v, n*m, w, 1,
+                       scalar_t(0.), h, 1);
+            blas::gemv('N', n, it+1, scalar_t(-1.), v, n*m, h, 1,
+                       scalar_t(1.), w, 1);
+          } else if (GStype == GramSchmidtType::MODIFIED) {
+            for (int k=0; k<=it; k++) {
+              h[k] = blas::dotc(n, v+k*n*m, 1, w, 1);
+              blas::axpy(n, scalar_t(-h[k]), v+k*n*m, 1, w, 1);
+            }
+          }
+          h[it+1] = blas::nrm2(n, w, 1);
+          blas::scal(n, scalar_t(1.)/h[it+1], w, 1);
+          for (int k=1; k<it+1; k++) {
+            scalar_t gamma = blas::my_conj(gc[k-1])*h[k-1]
+              + blas::my_conj(gs[k-1])*h[k];
+            h[k] = -gs[k-1]*h[k-1] + gc[k-1]*h[k];
+            h[k-1] = gamma;
+          }
+          scalar_t delta =
+            std::sqrt(std::pow(std::abs(h[it]),scalar_t(2))
+                      + std::pow(h[it+1],scalar_t(2)));
+          gc[it] = h[it] / delta;
+          gs[it] = h[it+1] / delta;
+          h[it] = blas::my_conj(gc[it])*h[it] + blas::my_conj(gs[it])*h[it+1];
+          bc[it+1] = -gs[it]*bc[it];
+          bc[it] = blas::my_conj(gc[it])*bc[it];
+          rho[c] = std::abs(bc[it+1]);
+          if (rho[c] < atol || rho[c]/rho0[c] < rtol || totit >= maxit) {
+            conv[c] = true;
+            nrit[c] = it;
+          }
+        }
+        if (verbose)
+          std::cout << "GMRES it. " << totit << "\tnrhs = " << act.size()
+                    << "\tmax rel.res = " << std::setw(12)
+                    << max_rel_res() << std::endl;
+        act.erase(std::remove_if(act.begin(), act.end(),
+                                 [&](std::size_t c) { return conv[c]; }),
+                  act.end());
+      }
+      for (auto c : cycle) {
+        blas::trsv('U', 'N', 'N', nrit[c]+1, hess.ptr(0, c*restart), ldh,
+                   b_.ptr(0, c), 1);
+        blas::gemv('N', n, nrit[c]+1, scalar_t(1.), V.ptr(0, c), n*m,
+                   b_.ptr(0, c), 1, scalar_t(1.), x.ptr(0, c), 1);
+      }
+      if (totit >= maxit) break;
+    }
+    return *std::max_element(rho.begin(), rho.end());
+  }
+
 } // end namespace strumpack
 
 #endif // GMRES_HPP
@@ -36,6 +36,7 @@
 #include "StrumpackParameters.hpp"
 #include "CompressedSparseMatrix.hpp"
 #include "dense/DistributedVector.hpp"
+#include "dense/DenseMatrix.hpp"
 
 namespace strumpack {
 
@@ -157,6 +158,196 @@ namespace strumpack {
     return rho;
   }
 
+  /**
+   * Left preconditioned restarted GMRes for multiple right-hand
+   * sides, see BlockGMRes. Collective operation on comm. The local
+   * rows of x and b are stored as the columns of a DenseMatrix. The
+   * inner products and norms of all active columns are combined in a
+   * single reduction.
+   */
+  template<typename scalar_t> typename RealType<scalar_t>::value_type
+  BlockGMResMPI
+  (const MPIComm& comm,
+   const std::function<void(const DenseMatrix<scalar_t>&,
+                            DenseMatrix<scalar_t>&)>& spmv,
+   const std::function<void(DenseMatrix<scalar_t>&)>& preconditioner,
+   DenseMatrix<scalar_t>& x, const DenseMatrix<scalar_t>& b,
+   typename RealType<scalar_t>::value_type rtol,
+   typename RealType<scalar_t>::value_type atol, int& totit, int maxit,
+   int restart, GramSchmidtType GStype, bool non_zero_guess, bool verbose) {
+    using real_t = typename RealType<scalar_t>::value_type;
+    using DenseM_t = DenseMatrix<scalar_t>;
+    if (restart > maxit) restart = maxit;
+    const std::size_t n = x.rows(), m = x.cols();
+    const int ldh = restart+1;
+    // column k of the Krylov basis for right-hand side c is column
+    // c+k*m of V, see BlockGMRes
+    DenseM_t V(n, m*(restart+1)), hess(ldh, m*restart),
+      b_(ldh, m), givens_c(restart, m), givens_s(restart, m);
+    DenseM_t b_prec(b);
+    preconditioner(b_prec);
+    std::vector<real_t> rho(m), rho0(m);
+    std::vector<int> nrit(m);
+    std::vector<bool> conv(m, false);
+    std::vector<std::size_t> act;
+    std::vector<scalar_t> buf;
+    auto gather = [&](const DenseM_t& X, std::size_t k) {
+      DenseM_t Xa(n, act.size());
+      for (std::size_t j=0; j<act.size(); j++)
+        std::copy(X.ptr(0, act[j]+k*m), X.ptr(0, act[j]+k*m)+n,
+                  Xa.ptr(0, j));
+      return Xa;
+    };
+    auto scatter = [&](const DenseM_t& Xa, DenseM_t& X, std::size_t k) {
+      for (std::size_t j=0; j<act.size(); j++)
+        std::copy(Xa.ptr(0, j), Xa.ptr(0, j)+n, X.ptr(0, act[j]+k*m));
+    };
+    // norms of columns c+k*m of V, for all active c, in one reduction
+    auto norms = [&](std::size_t k) {
+      std::vector<real_t> nrm(act.size());
+      for (std::size_t j=0; j<act.size(); j++) {
+        auto l = blas::nrm2(n, V.ptr(0, act[j]+k*m), 1);
+        nrm[j] = l * l;
+      }
+      comm.all_reduce(nrm.data(), nrm.size(), MPI_SUM);
+      for (auto& v : nrm) v = std::sqrt(v);
+      return nrm;
+    };
+    auto max_rel_res = [&]() {
+      real_t r = 0.;
+      for (auto c : act) r = std::max(r, rho[c]/rho0[c]);
+      return r;
+    };
+    totit = 0;
+    if (!non_zero_guess) x.zero();
+    while (true) {
+      act.clear();
+      for (std::size_t c=0; c<m; c++)
+        if (!conv[c]) act.push_back(c);
+      if (act.empty()) break;
+      if (non_zero_guess || totit > 0) {
+        DenseM_t R(n, act.size());
+        spmv(gather(x, 0), R);
+        preconditioner(R);
+        for (std::size_t j=0; j<act.size(); j++)
+          blas::axpby(n, scalar_t(1.), b_prec.ptr(0, act[j]), 1,
+                      scalar_t(-1.), R.ptr(0, j), 1);
+        scatter(R, V, 0);
+      } else scatter(gather(b_prec, 0), V, 0);
+      auto nrm = norms(0);
+      for (std::size_t j=0; j<act.size(); j++) {
+        auto c = act[j];
+        rho[c] = nrm[j];
+        if (totit == 0) rho0[c] = rho[c];
+        if (rho[c] < atol || rho[c]/rho0[c] < rtol) conv[c] = true;
+      }
+      act.erase(std::remove_if(act.begin(), act.end(),
+                               [&](std::size_t c) { return conv[c]; }),
+                act.end());
+      if (act.empty()) break;
+      for (auto c : act) {
+        blas::scal(n, scalar_t(1.)/rho[c], V.ptr(0, c), 1);
+        b_(0, c) = rho[c];
+        for (int i=1; i<=restart; i++) b_(i, c) = scalar_t(0.);
+        nrit[c] = restart-1;
+      }
+      if (verbose)
+        std::cout << "GMRES it. " << totit << "\tnrhs = " << act.size()
+                  << "\tmax rel.res = " << std::setw(12)
+                  << max_rel_res() << "\t restart!" << std::endl;
+      auto cycle = act;
+      for (int it=0; it<restart && !act.empty(); it++) {
+        totit++;
+        if (act.size() == m) {
+          DenseMatrixWrapper<scalar_t> Vit(n, m, V, 0, it*m),
+            Vit1(n, m, V, 0, (it+1)*m);
+          spmv(Vit, Vit1);
+          preconditioner(Vit1);
+        } else {
+          DenseM_t W(n, act.size());
+          spmv(gather(V, it), W);
+          preconditioner(W);
+          scatter(W, V, it+1);
+        }
+        const auto na = act.size();
+        if (GStype == GramSchmidtType::CLASSICAL) {
+          buf.resize(na*(it+1));
+          for (std::size_t j=0; j<na; j++)
+            blas::gemv('C', n, it+1, scalar_t(1.), V.ptr(0, act[j]), n*m,
+                       V.ptr(0, act[j]+(it+1)*m), 1, scalar_t(0.),
+                       &buf[j*(it+1)], 1);
+          comm.all_reduce(buf.data(), buf.size(), MPI_SUM);
+          for (std::size_t j=0; j<na; j++) {
+            auto c = act[j];
+            auto h = hess.ptr(0, c*restart+it);
+            std::copy(&buf[j*(it+1)], &buf[(j+1)*(it+1)], h);
+            blas::gemv('N', n, it+1, scalar_t(-1.), V.ptr(0, c), n*m,
+                       h, 1, scalar_t(1.), V.ptr(0, c+(it+1)*m), 1);
+          }
+        } else if (GStype == GramSchmidtType::MODIFIED) {
+          buf.resize(na);
+          for (int k=0; k<=it; k++) {
+            for (std::size_t j=0; j<na; j++)
+              buf[j] = blas::dotc(n, V.ptr(0, act[j]+k*m), 1,
+                                  V.ptr(0, act[j]+(it+1)*m), 1);
+            comm.all_reduce(buf.data(), na, MPI_SUM);
+            for (std::size_t j=0; j<na; j++) {
+              auto c = act[j];
+              hess(k, c*restart+it) = buf[j];
+              blas::axpy(n, scalar_t(-buf[j]), V.ptr(0, c+k*m), 1,
+                         V.ptr(0, c+(it+1)*m), 1);
+            }
+          }
+        }
+        nrm = norms(it+1);
+        for (std::size_t j=0; j<na; j++) {
+          auto c = act[j];
+          auto w = V.ptr(0, c+(it+1)*m);
+          auto h = hess.ptr(0, c*restart+it);
+          auto gc = givens_c.ptr(0, c);
+          auto gs = givens_s.ptr(0, c);
+          auto bc = b_.ptr(0, c);
+          h[it+1] = nrm[j];
+          blas::scal(n, scalar_t(1.)/h[it+1], w, 1);
+          for (int k=1; k<it+1; k++) {
+            scalar_t gamma = blas::my_conj(gc[k-1])*h[k-1]
+              + blas::my_conj(gs[k-1])*h[k];
+            h[k] = -gs[k-1]*h[k-1] + gc[k-1]*h[k];
+            h[k-1] = gamma;
+          }
+          scalar_t delta =
+            std::sqrt(std::pow(std::abs(h[it]),scalar_t(2))
+                      + std::pow(h[it+1],scalar_t(2)));
+          gc[it] = h[it] / delta;
+          gs[it] = h[it+1] / delta;
+          h[it] = blas::my_conj(gc[it])*h[it] + blas::my_conj(gs[it])*h[it+1];
+          bc[it+1] = -gs[it]*bc[it];
+          bc[it] = blas::my_conj(gc[it])*bc[it];
+          rho[c] = std::abs(bc[it+1]);
+          if (rho[c] < atol || rho[c]/rho0[c] < rtol || totit >= maxit) {
+            conv[c] = true;
+            nrit[c] = it;
+          }
+        }
+        if (verbose)
+          std::cout << "GMRES it. " << totit << "\tnrhs = " << act.size()
+                    << "\tmax rel.res = " << std::setw(12)
+                    << max_rel_res() << std::endl;
+        act.erase(std::remove_if(act.begin(), act.end(),
+                                 [&](std::size_t c) { return conv[c]; }),
+                  act.end());
+      }
+      for (auto c : cycle) {
+        blas::trsv('U', 'N', 'N', nrit[c]+1, hess.ptr(0, c*restart), ldh,
+                   b_.ptr(0, c), 1);
+        blas::gemv('N', n, nrit[c]+1, scalar_t(1.), V.ptr(0, c), n*m,
+                   b_.ptr(0, c), 1, scalar_t(1.), x.ptr(0, c), 1);
+      }
+      if (totit >= maxit) break;
+    }
+    return *std::max_element(rho.begin(), rho.end());
+  }
+
 } // end namespace strumpack
 
 #endif // GMRESMPI_HPP
@@ -0,0 +1,142 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#ifndef SOLVE_WORKSPACE_HPP
+#define SOLVE_WORKSPACE_HPP
+
+#include <vector>
+#include <algorithm>
+#include "dense/DenseMatrix.hpp"
+
+namespace strumpack {
+
+  /**
+   * \class SolveWorkspace
+   *
+   * \brief Work memory for the multifrontal forward and backward
+   * solves, kept by the EliminationTree and reused by repeated solves
+   * with the same number of right-hand sides.
+   *
+   * Every front needs a dim_upd x nrhs work matrix during the solve,
+   * and passes the next level of work matrices on to its
+   * children. The work matrices used by a task form a stack, with one
+   * matrix per level, sized for the largest dim_upd at that level. The
+   * root, and every front that is solved in a separate task, get their
+   * own stack. A stack is only allocated when it is first used, by the
+   * task that uses it, so the memory is first touched by (and local
+   * to) the thread doing the solve for that subtree.
+   *
+   * The layout follows the task creation in the solve, so it depends
+   * on the task recursion cutoff level it was set up for. A
+   * workspace can only be used by one solve at a time.
+   */
+  template<typename scalar_t> class SolveWorkspace {
+    using DenseM_t = DenseMatrix<scalar_t>;
+
+  public:
+    SolveWorkspace() {}
+
+    /**
+     * Remove all stacks, and prepare for solves with nrhs right-hand
+     * sides, with tasks created up to the given task recursion
+     * cutoff level.
+     */
+    void reset(std::size_t nrhs, int task_cutoff) {
+      nrhs_ = nrhs;
+      task_cutoff_ = task_cutoff;
+      rows_.clear();
+      stacks_.clear();
+    }
+
+    /**
+     * Add a stack, with rows[l] the number of rows of the work
+     * matrix for level l. Returns the index of the new stack. This
+     * should not be called while solving.
+     */
+    int add_stack(std::vector<std::size_t>&& rows) {
+      rows_.push_back(std::move(rows));
+      stacks_.emplace_back();
+      return rows_.size() - 1;
+    }
+
+    /**
+     * Return the work matrices of stack s, allocating them on first
+     * use. Different stacks can be used concurrently.
+     */
+    DenseM_t* stack(int s) {
+      auto& st = stacks_[s];
+      if (st.empty()) {
+        st.resize(rows_[s].size());
+        for (std::size_t l=0; l<st.size(); l++)
+          st[l] = DenseM_t(rows_[s][l], nrhs_);
+      }
+      return st.data();
+    }
+
+    std::size_t nrhs() const { return nrhs_; }
+    int task_cutoff() const { return task_cutoff_; }
+    bool empty() const { return stacks_.empty(); }
+
+  private:
+    std::size_t nrhs_ = 0;
+    int task_cutoff_ = -1;
+    std::vector<std::vector<std::size_t>> rows_;
+    std::vector<std::vector<DenseM_t>> stacks_;
+  };
+
+  /**
+   * \class SolvePruning
+   *
+   * \brief The fronts visited by a pruned solve, see
+   * FrontalMatrix::prune_backward and FrontalMatrix::prune_forward.
+   *
+   * This is indexed by the separator number of the front. It is
+   * computed before the solve, and is only read during the solve, so
+   * solves with different pruning do not interfere.
+   */
+  class SolvePruning {
+  public:
+    /**
+     * Prepare for a tree with n fronts, all visited.
+     */
+    void reset(std::size_t n) {
+      fwd_.assign(n, true);
+      bwd_.assign(n, true);
+    }
+    bool forward(std::size_t f) const { return fwd_[f]; }
+    bool backward(std::size_t f) const { return bwd_[f]; }
+    void set_forward(std::size_t f, bool v) { fwd_[f] = v; }
+    void set_backward(std::size_t f, bool v) { bwd_[f] = v; }
+
+  private:
+    std::vector<bool> fwd_, bwd_;
+  };
+
+} // end namespace strumpack
+
+#endif // SOLVE_WORKSPACE_HPP
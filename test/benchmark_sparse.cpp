@@ -0,0 +1,263 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <complex>
+#include <limits>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+
+using namespace strumpack;
+
+/*
+ * Benchmark the sparse solver on a number of model problems,
+ * discretized on regular 2D or 3D grids, for different grid sizes,
+ * front types and thread counts. One CSV line is printed for every
+ * run, so the results can easily be compared between versions.
+ *
+ * Options (all other options are passed to the solver):
+ *   --bench_problem p1,p2,..   poisson2d, poisson3d, convdiff3d,
+ *                              helmholtz3d (default: all)
+ *   --bench_n n1,n2,..         grid points per dimension (default:
+ *                              256 for 2D problems, 32 for 3D)
+ *   --bench_compression c1,..  none, blr, hss (default: all)
+ *   --bench_threads t1,t2,..   OpenMP threads (default: max threads)
+ *   --bench_repeat r           repeat every run r times, report the
+ *                              minimum times (default: 1)
+ *   --bench_output file        write CSV to file instead of stdout
+ */
+
+template<typename T> vector<T> parse_list(const string& s) {
+  vector<T> l;
+  istringstream iss(s);
+  string item;
+  while (getline(iss, item, ',')) {
+    istringstream is(item);
+    T v; is >> v;
+    l.push_back(v);
+  }
+  return l;
+}
+
+/*
+ * Matrix for a 7-point (3D) or 5-point (2D, nz == 1) stencil on an
+ * nx x ny x nz grid, with lexicographic ordering. c holds the
+ * coefficients for the center, and the x-1, x+1, y-1, y+1, z-1, z+1
+ * neighbors.
+ */
+template<typename scalar_t> CSRMatrix<scalar_t,int>
+stencil_matrix(int nx, int ny, int nz, const scalar_t c[7]) {
+  int N = nx * ny * nz;
+  // the center, and both neighbors along each edge of the grid
+  int nnz = N + 2 * ((nx-1)*ny*nz + nx*(ny-1)*nz + nx*ny*(nz-1));
+  CSRMatrix<scalar_t,int> A(N, nnz);
+  auto ptr = A.ptr();
+  auto ind = A.ind();
+  auto val = A.val();
+  nnz = 0;
+  ptr[0] = 0;
+  for (int z=0; z<nz; z++)
+    for (int y=0; y<ny; y++)
+      for (int x=0; x<nx; x++) {
+        int r = x + y*nx + z*nx*ny;
+        if (z > 0)    { val[nnz] = c[5]; ind[nnz++] = r - nx*ny; }
+        if (y > 0)    { val[nnz] = c[3]; ind[nnz++] = r - nx; }
+        if (x > 0)    { val[nnz] = c[1]; ind[nnz++] = r - 1; }
+        val[nnz] = c[0]; ind[nnz++] = r;
+        if (x < nx-1) { val[nnz] = c[2]; ind[nnz++] = r + 1; }
+        if (y < ny-1) { val[nnz] = c[4]; ind[nnz++] = r + nx; }
+        if (z < nz-1) { val[nnz] = c[6]; ind[nnz++] = r + nx*ny; }
+        ptr[r+1] = nnz;
+      }
+  A.set_symm_sparse();
+  return A;
+}
+
+struct Run {
+  string problem, compression;
+  int n, threads;
+};
+
+struct Result {
+  double reorder = numeric_limits<double>::max();
+  double factor = numeric_limits<double>::max();
+  double solve = numeric_limits<double>::max();
+  long long factor_flops = 0, solve_flops = 0;
+  double factor_MB = 0., peak_MB = 0., residual = 0., error = 0.;
+  int its = 0;
+  bool ok = true;
+};
+
+template<typename scalar_t> Result
+benchmark(int argc, char* argv[], CSRMatrix<scalar_t,int>& A,
+          int nx, int ny, int nz, const Run& run, int repeat) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  Result res;
+  int N = A.size();
+  vector<scalar_t> b(N), x(N), x_exact(N, scalar_t(1.)/sqrt(real_t(N)));
+  A.spmv(x_exact.data(), b.data());
+  for (int r=0; r<repeat; r++) {
+    StrumpackSparseSolver<scalar_t,int> spss(false);
+    auto& opts = spss.options();
+    opts.set_matching(MatchingJob::NONE);
+    opts.set_reordering_method(ReorderingStrategy::GEOMETRIC);
+    opts.set_HSS_min_sep_size(128);
+    opts.set_BLR_min_sep_size(128);
+    if (run.compression == "blr") opts.enable_BLR();
+    else if (run.compression == "hss") opts.enable_HSS();
+    opts.set_from_command_line(argc, argv);
+    spss.set_matrix(A);
+
+    TaskTimer t_reorder("reorder"), t_factor("factor"), t_solve("solve");
+    t_reorder.time([&](){
+        res.ok &= spss.reorder(nx, ny, nz) == ReturnCode::SUCCESS; });
+    long long f0 = params::flops;
+    t_factor.time([&](){
+        res.ok &= spss.factor() == ReturnCode::SUCCESS; });
+    long long f1 = params::flops;
+    fill(x.begin(), x.end(), scalar_t(0.));
+    t_solve.time([&](){
+        res.ok &= spss.solve(b.data(), x.data()) == ReturnCode::SUCCESS; });
+    long long f2 = params::flops;
+
+    res.reorder = min(res.reorder, t_reorder.elapsed());
+    res.factor = min(res.factor, t_factor.elapsed());
+    res.solve = min(res.solve, t_solve.elapsed());
+    res.factor_flops = f1 - f0;
+    res.solve_flops = f2 - f1;
+    res.factor_MB = spss.factor_memory() / 1e6;
+    res.peak_MB = spss.peak_memory(SolverPhase::FACTOR) / 1e6;
+    res.its = spss.Krylov_iterations();
+  }
+  res.residual = A.max_scaled_residual(x.data(), b.data());
+  blas::axpy(N, scalar_t(-1.), x_exact.data(), 1, x.data(), 1);
+  res.error = blas::nrm2(N, x.data(), 1) / blas::nrm2(N, x_exact.data(), 1);
+  return res;
+}
+
+int main(int argc, char* argv[]) {
+  vector<string> problems
+    {"poisson2d", "poisson3d", "convdiff3d", "helmholtz3d"};
+  vector<string> compression{"none", "blr", "hss"};
+  vector<int> sizes, threads;
+#if defined(_OPENMP)
+  threads.push_back(omp_get_max_threads());
+#else
+  threads.push_back(1);
+#endif
+  int repeat = 1;
+  string output;
+  for (int i=1; i<argc-1; i++) {
+    string o(argv[i]), v(argv[i+1]);
+    if (o == "--bench_problem") problems = parse_list<string>(v);
+    else if (o == "--bench_n") sizes = parse_list<int>(v);
+    else if (o == "--bench_compression") compression = parse_list<string>(v);
+    else if (o == "--bench_threads") threads = parse_list<int>(v);
+    else if (o == "--bench_repeat") repeat = max(1, stoi(v));
+    else if (o == "--bench_output") output = v;
+  }
+
+  ofstream fout;
+  if (!output.empty()) fout.open(output);
+  ostream& out = output.empty() ? cout : fout;
+  out << "problem,n,N,nnz,scalar,compression,threads,"
+      << "reorder_s,factor_s,solve_s,factor_GFlops,solve_GFlops,"
+      << "factor_MB,peak_factor_MB,iterations,residual,error" << endl;
+
+  int failed = 0;
+  for (auto& p : problems) {
+    bool p2d = p == "poisson2d";
+    auto ns = sizes;
+    if (ns.empty()) ns.push_back(p2d ? 256 : 32);
+    for (auto n : ns) {
+      int nz = p2d ? 1 : n;
+      // all matrices are scaled by h^2, with h = 1/(n+1)
+      double h = 1. / (n + 1);
+      CSRMatrix<double,int> Ad;
+      CSRMatrix<complex<double>,int> Az;
+      if (p == "poisson2d") {
+        double c[7] = {4., -1., -1., -1., -1., 0., 0.};
+        Ad = stencil_matrix(n, n, 1, c);
+      } else if (p == "poisson3d") {
+        double c[7] = {6., -1., -1., -1., -1., -1., -1.};
+        Ad = stencil_matrix(n, n, n, c);
+      } else if (p == "convdiff3d") {
+        // -Laplacian + beta (1,1,1).grad, first order upwind
+        double bh = 50. * h;
+        double c[7] = {6. + 3. * bh, -1. - bh, -1., -1. - bh, -1.,
+                       -1. - bh, -1.};
+        Ad = stencil_matrix(n, n, n, c);
+      } else if (p == "helmholtz3d") {
+        // -Laplacian - k^2 (1 + 0.05i), 10 points per wavelength
+        double kh = 2. * M_PI / 10.;
+        complex<double> d = 6. - kh * kh * complex<double>(1., .05);
+        complex<double> c[7] = {d, -1., -1., -1., -1., -1., -1.};
+        Az = stencil_matrix(n, n, n, c);
+      } else {
+        cerr << "# unknown problem " << p << endl;
+        failed++;
+        continue;
+      }
+      for (auto& comp : compression) {
+        for (auto t : threads) {
+#if defined(_OPENMP)
+          omp_set_num_threads(t);
+#endif
+          params::num_threads = t;
+          params::task_recursion_cutoff_level =
+            (t == 1) ? 0 : std::log2(t) + 3;
+          Run run{p, comp, n, t};
+          bool cplx = Az.size() > 0;
+          auto r = cplx ?
+            benchmark(argc, argv, Az, n, n, nz, run, repeat) :
+            benchmark(argc, argv, Ad, n, n, nz, run, repeat);
+          if (!r.ok) failed++;
+          out << p << "," << n << ","
+              << (cplx ? Az.size() : Ad.size()) << ","
+              << (cplx ? Az.nnz() : Ad.nnz()) << ","
+              << (cplx ? "z" : "d") << "," << comp << "," << t << ","
+              << r.reorder << "," << r.factor << "," << r.solve << ",";
+#if defined(STRUMPACK_COUNT_FLOPS)
+          out << r.factor_flops / r.factor / 1e9 << ","
+              << r.solve_flops / r.solve / 1e9 << ",";
+#else
+          out << "nan,nan,";
+#endif
+          out << r.factor_MB << "," << r.peak_MB << "," << r.its << ","
+              << r.residual << "," << r.error << endl;
+        }
+      }
+    }
+  }
+  return failed;
+}
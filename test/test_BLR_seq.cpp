@@ -125,6 +125,51 @@ int run(int argc, char* argv[]) {
   if (blr_opts.verbose()) A.print("A");
   cout << "# tol = " << blr_opts.rel_tol() << endl;
 
+  // compress with the diagonal tiles dense
+  vector<size_t> tiles;
+  for (int i=0; i<m; i+=blr_opts.leaf_size())
+    tiles.push_back(min(blr_opts.leaf_size(), m-i));
+  DenseMatrix<double> Acopy(A);
+  BLRMatrix<double> B
+    (Acopy, tiles, tiles, [](size_t i, size_t j) { return i != j; },
+     blr_opts);
+  auto Bdense = B.dense();
+  Bdense.scaled_add(-1., A);
+  cout << "# rank(B) = " << B.maximum_rank() << endl;
+  cout << "# relative error = ||A-B||_F/||A||_F = "
+       << Bdense.normF() / A.normF() << endl;
+  if (Bdense.normF() / A.normF() > ERROR_TOLERANCE
+      * max(blr_opts.rel_tol(),blr_opts.abs_tol())) {
+    cout << "ERROR: compression error too big!!" << endl;
+    return 1;
+  }
+
+  // extract a random submatrix, tile by tile, and compare with the
+  // same submatrix of the expanded BLR matrix
+  {
+    Bdense = B.dense();
+    mt19937 gen(1);
+    uniform_int_distribution<size_t> rnd(0, m-1);
+    size_t ni = min(m, 37), nj = min(m, 23);
+    vector<size_t> I(ni), J(nj), oI(ni), oJ(nj);
+    for (auto& i : I) i = rnd(gen);
+    for (auto& j : J) j = rnd(gen);
+    for (size_t i=0; i<ni; i++) oI[i] = i;
+    for (size_t j=0; j<nj; j++) oJ[j] = nj-1-j;
+    DenseMatrix<double> E(ni, nj);
+    E.zero();
+    B.extract_add(I, J, E, oI, oJ);
+    double err = 0.;
+    for (size_t j=0; j<nj; j++)
+      for (size_t i=0; i<ni; i++)
+        err = max(err, abs(E(oI[i], oJ[j]) - Bdense(I[i], J[j])));
+    cout << "# extraction error = " << err << endl;
+    if (err > SOLVE_TOLERANCE * Bdense.normF()) {
+      cout << "ERROR: extracted elements are wrong!!" << endl;
+      return 1;
+    }
+  }
+
   //BLRMatrix<double> B(A, blr_opts);
   // if (H.is_compressed()) {
   //   cout << "# created H matrix of dimension "
@@ -0,0 +1,191 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <vector>
+#include <random>
+#include <complex>
+using namespace std;
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+#include "sparse/CSRMatrix.hpp"
+using namespace strumpack;
+
+
+/*
+ * Random n x n matrix with an irregular number of nonzeros per row:
+ * some empty rows, and one row with half of the columns, so that the
+ * nonzero balanced row partitioning is not trivial.
+ */
+template<typename scalar_t> CSRMatrix<scalar_t,int> random_matrix(int n) {
+  mt19937 gen(13);
+  uniform_int_distribution<int> col(0, n-1);
+  uniform_real_distribution<double> val(-1., 1.);
+  vector<int> ptr(n+1), ind;
+  vector<scalar_t> v;
+  for (int r=0; r<n; r++) {
+    ptr[r] = ind.size();
+    int nnz = (r == n/3) ? n/2 : (r*7) % 13;
+    for (int k=0; k<nnz; k++) {
+      ind.push_back(col(gen));
+      v.push_back(scalar_t(val(gen)));
+    }
+  }
+  ptr[n] = ind.size();
+  return CSRMatrix<scalar_t,int>(n, ptr.data(), ind.data(), v.data());
+}
+
+/*
+ * The blocked multiple right-hand side spmv and max_scaled_residual
+ * should give the same results as applying the single vector
+ * versions column by column, also for a number of columns that is
+ * not a multiple of the block size, and for a leading dimension
+ * larger than the number of rows.
+ */
+template<typename scalar_t> int test_spmm(int n, int m) {
+  using real_t = typename RealType<scalar_t>::value_type;
+  auto A = random_matrix<scalar_t>(n);
+  DenseMatrix<scalar_t> Xbig(n+5, m), Ybig(n+3, m), B(n, m);
+  Xbig.random();
+  B.random();
+  DenseMatrixWrapper<scalar_t> X(n, m, Xbig, 2, 0), Y(n, m, Ybig, 1, 0);
+  A.spmv(X, Y);
+  vector<scalar_t> x(n), y(n), b(n);
+  real_t err = 0., nrm = 0., res = 0.;
+  for (int c=0; c<m; c++) {
+    for (int i=0; i<n; i++) x[i] = X(i, c);
+    A.spmv(x.data(), y.data());
+    for (int i=0; i<n; i++) {
+      err = std::max(err, std::abs(y[i] - Y(i, c)));
+      nrm = std::max(nrm, std::abs(y[i]));
+    }
+    for (int i=0; i<n; i++) b[i] = B(i, c);
+    res = std::max(res, A.max_scaled_residual(x.data(), b.data()));
+  }
+  auto eps = blas::lamch<real_t>('E');
+  if (err > 10 * eps * n * nrm) {
+    cout << "# ERROR: spmv with " << m << " columns differs from the"
+         << " single vector spmv, error = " << err / nrm << endl;
+    return 1;
+  }
+  auto resm = A.max_scaled_residual(X, B);
+  if (std::abs(resm - res) > 10 * eps * res) {
+    cout << "# ERROR: max_scaled_residual with " << m << " columns = "
+         << resm << ", column by column = " << res << endl;
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * The row partitioning depends on the number of threads, the result
+ * of the multiple right-hand side spmv should not.
+ */
+template<typename scalar_t> int test_threads(int n, int m) {
+#if defined(_OPENMP)
+  auto A = random_matrix<scalar_t>(n);
+  DenseMatrix<scalar_t> X(n, m), Y1(n, m), Y4(n, m);
+  X.random();
+  int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  A.spmv(X, Y1);
+  omp_set_num_threads(std::max(4, threads));
+  A.spmv(X, Y4);
+  omp_set_num_threads(threads);
+  for (int j=0; j<m; j++)
+    for (int i=0; i<n; i++)
+      if (Y1(i,j) != Y4(i,j)) {
+        cout << "# ERROR: CSRMatrix::spmv depends on the"
+             << " number of threads" << endl;
+        return 1;
+      }
+#endif
+  return 0;
+}
+
+/*
+ * A matrix can be allocated with more nonzeros than its row pointers
+ * use, for instance CSRMatrix(n, nnz) filled with fewer entries. The
+ * rows should still be split based on ptr[n], and the products
+ * should not touch anything beyond row n-1.
+ */
+template<typename scalar_t> int test_allocated(int n, int m) {
+  auto R = random_matrix<scalar_t>(n);
+  CSRMatrix<scalar_t,int> A(n, 3 * R.nnz());
+  std::copy(R.ptr(), R.ptr()+n+1, A.ptr());
+  std::copy(R.ind(), R.ind()+R.nnz(), A.ind());
+  std::copy(R.val(), R.val()+R.nnz(), A.val());
+  const scalar_t guard(-7.);
+  DenseMatrix<scalar_t> X(n, m), B(n, m), Ybig(n+1, m), YR(n, m);
+  X.random();
+  B.random();
+  Ybig.fill(guard);
+  DenseMatrixWrapper<scalar_t> Y(n, m, Ybig, 0, 0);
+  vector<scalar_t> y(n+1, guard);
+  int err = 0;
+#if defined(_OPENMP)
+  int threads = omp_get_max_threads();
+  omp_set_num_threads(std::max(4, threads));
+#endif
+  A.spmv(X, Y);
+  A.spmv(X.data(), y.data());
+  auto res = A.max_scaled_residual(X, B);
+#if defined(_OPENMP)
+  omp_set_num_threads(threads);
+#endif
+  R.spmv(X, YR);
+  for (int j=0; j<m; j++) {
+    if (Ybig(n, j) != guard) err++;
+    for (int i=0; i<n; i++)
+      if (Y(i, j) != YR(i, j)) err++;
+  }
+  for (int i=0; i<n; i++)
+    if (y[i] != YR(i, 0)) err++;
+  if (y[n] != guard) err++;
+  if (res != R.max_scaled_residual(X, B)) err++;
+  if (err)
+    cout << "# ERROR: spmv wrong for a matrix with more nonzeros"
+         << " allocated than used" << endl;
+  return err ? 1 : 0;
+}
+
+int main() {
+  int err = 0;
+  for (int m : {1, 2, 7, 8, 9, 17}) {
+    err += test_spmm<double>(500, m);
+    err += test_spmm<complex<double>>(300, m);
+  }
+  err += test_spmm<float>(1000, 13);
+  err += test_threads<double>(2000, 11);
+  err += test_allocated<double>(400, 9);
+  if (err) return 1;
+  cout << "# all CSRMatrix spmv tests passed" << endl;
+  return 0;
+}
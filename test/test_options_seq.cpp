@@ -0,0 +1,199 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <complex>
+using namespace std;
+
+#include "StrumpackOptions.hpp"
+using namespace strumpack;
+
+#define CHECK(o, p, f)                                          \
+  if (!(o.f() == p.f())) {                                      \
+    cout << "# ERROR: " #f " was not copied" << endl;           \
+    err++;                                                      \
+  }
+
+/*
+ * Set every option to a value different from its default. The
+ * tolerances are powers of 2, so they are the same in single and
+ * double precision.
+ */
+template<typename scalar_t> void set_options(SPOptions<scalar_t>& o) {
+  o.set_verbose(false);
+  o.set_maxit(17);
+  o.set_rel_tol(.25);
+  o.set_abs_tol(.125);
+  o.set_Krylov_solver(KrylovSolver::GMRES);
+  o.set_gmres_restart(11);
+  o.set_GramSchmidt_type(GramSchmidtType::CLASSICAL);
+  o.set_solve_batch_size(3);
+  o.set_reordering_method(ReorderingStrategy::GEOMETRIC);
+  o.set_nd_param(5);
+  o.set_dimensions(4, 5, 6);
+  o.set_components(2);
+  o.set_separator_width(3);
+  o.enable_METIS_NodeNDP();
+  o.enable_MUMPS_SYMQAMD();
+  o.enable_agg_amalg();
+  o.set_matching(MatchingJob::MAX_CARDINALITY);
+  o.enable_assembly_tree_log();
+  o.enable_HSS();
+  o.set_HSS_min_front_size(7);
+  o.set_HSS_min_sep_size(9);
+  o.set_BLR_min_front_size(13);
+  o.set_BLR_min_sep_size(15);
+  o.set_separator_ordering_level(2);
+  o.enable_indirect_sampling();
+  o.enable_HSS_rank_estimate();
+  o.enable_HSS_regenerate_random();
+  o.enable_replace_tiny_pivots();
+  o.disable_DAG_scheduler();
+  o.enable_mixed_precision();
+  o.enable_lookahead_LU();
+  o.set_trace_file("options.json");
+  auto& h = o.HSS_options();
+  h.set_rel_tol(.5);
+  h.set_abs_tol(.0625);
+  h.set_leaf_size(17);
+  h.set_d0(19);
+  h.set_dd(7);
+  h.set_p(3);
+  h.set_max_rank(99);
+  h.set_random_engine(random::RandomEngine::LINEAR);
+  h.set_random_distribution(random::RandomDistribution::UNIFORM);
+  h.set_compression_algorithm(HSS::CompressionAlgorithm::ORIGINAL);
+  h.set_user_defined_random(true);
+  h.set_synchronized_compression(true);
+  h.set_log_ranks(true);
+  h.set_verbose(false);
+  auto& b = o.BLR_options();
+  b.set_rel_tol(.375);
+  b.set_abs_tol(.03125);
+  b.set_leaf_size(21);
+  b.set_max_rank(77);
+  b.set_low_rank_algorithm(BLR::LowRankAlgorithm::ACA);
+  b.set_admissibility(BLR::Admissibility::WEAK);
+  b.set_factor_algorithm(BLR::FactorAlgorithm::CUFS);
+  b.set_CB_compression(true);
+  b.set_verbose(false);
+}
+
+template<typename a_t, typename b_t> int
+compare(const SPOptions<a_t>& o, const SPOptions<b_t>& p) {
+  int err = 0;
+  CHECK(o, p, verbose);
+  CHECK(o, p, maxit);
+  CHECK(o, p, rel_tol);
+  CHECK(o, p, abs_tol);
+  CHECK(o, p, Krylov_solver);
+  CHECK(o, p, gmres_restart);
+  CHECK(o, p, GramSchmidt_type);
+  CHECK(o, p, solve_batch_size);
+  CHECK(o, p, reordering_method);
+  CHECK(o, p, nd_param);
+  CHECK(o, p, nx);
+  CHECK(o, p, ny);
+  CHECK(o, p, nz);
+  CHECK(o, p, components);
+  CHECK(o, p, separator_width);
+  CHECK(o, p, use_METIS_NodeNDP);
+  CHECK(o, p, use_MUMPS_SYMQAMD);
+  CHECK(o, p, use_agg_amalg);
+  CHECK(o, p, matching);
+  CHECK(o, p, log_assembly_tree);
+  CHECK(o, p, use_HSS);
+  CHECK(o, p, use_BLR);
+  CHECK(o, p, HSS_min_front_size);
+  CHECK(o, p, HSS_min_sep_size);
+  CHECK(o, p, BLR_min_front_size);
+  CHECK(o, p, BLR_min_sep_size);
+  CHECK(o, p, separator_ordering_level);
+  CHECK(o, p, indirect_sampling);
+  CHECK(o, p, HSS_rank_estimate);
+  CHECK(o, p, HSS_regenerate_random);
+  CHECK(o, p, replace_tiny_pivots);
+  CHECK(o, p, use_DAG_scheduler);
+  CHECK(o, p, mixed_precision);
+  CHECK(o, p, lookahead_LU);
+  CHECK(o, p, trace_file);
+  auto& h = o.HSS_options();
+  auto& hp = p.HSS_options();
+  CHECK(h, hp, rel_tol);
+  CHECK(h, hp, abs_tol);
+  CHECK(h, hp, leaf_size);
+  CHECK(h, hp, d0);
+  CHECK(h, hp, dd);
+  CHECK(h, hp, p);
+  CHECK(h, hp, max_rank);
+  CHECK(h, hp, random_engine);
+  CHECK(h, hp, random_distribution);
+  CHECK(h, hp, compression_algorithm);
+  CHECK(h, hp, user_defined_random);
+  CHECK(h, hp, synchronized_compression);
+  CHECK(h, hp, log_ranks);
+  CHECK(h, hp, verbose);
+  auto& b = o.BLR_options();
+  auto& bp = p.BLR_options();
+  CHECK(b, bp, rel_tol);
+  CHECK(b, bp, abs_tol);
+  CHECK(b, bp, leaf_size);
+  CHECK(b, bp, max_rank);
+  CHECK(b, bp, low_rank_algorithm);
+  CHECK(b, bp, admissibility);
+  CHECK(b, bp, factor_algorithm);
+  CHECK(b, bp, CB_compression);
+  CHECK(b, bp, verbose);
+  return err;
+}
+
+/*
+ * Copy the options to the lower precision, as done for the mixed
+ * precision factorization, and back, and check that no option was
+ * lost.
+ */
+template<typename scalar_t, typename lower_t> int test_round_trip() {
+  SPOptions<scalar_t> o;
+  set_options(o);
+  SPOptions<lower_t> lo(o);
+  SPOptions<scalar_t> o2(lo);
+  return compare(o, lo) + compare(o, o2);
+}
+
+int main() {
+  int err = test_round_trip<double,float>();
+  err += test_round_trip<complex<double>,complex<float>>();
+  SPOptions<double> o;
+  o.set_solve_batch_size(0);
+  if (o.solve_batch_size() != 1) {
+    cout << "# ERROR: invalid solve batch size was accepted" << endl;
+    err++;
+  }
+  if (!err) cout << "# all options copied" << endl;
+  return err;
+}
@@ -0,0 +1,83 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <complex>
+using namespace std;
+
+#include "dense/DistributedMatrix.hpp"
+using namespace strumpack;
+
+
+/*
+ * DistributedMatrix::random() should give the same matrix as
+ * DenseMatrix::random(), for any process grid and any block size.
+ * Every process compares its local part to the sequential fill, no
+ * communication is needed.
+ */
+template<typename scalar_t> int test_grids(const MPIComm& c, int m, int n) {
+  DenseMatrix<scalar_t> A(m, n);
+  A.random();
+  int err = 0;
+  for (int P=1; P<=c.size(); P++) {
+    BLACSGrid grid(c, P);
+    for (int nb : {1, 3, 32}) {
+      DistributedMatrix<scalar_t> dA(&grid, m, n, nb, nb);
+      dA.random();
+      if (!dA.active()) continue;
+      for (int lc=0; lc<dA.lcols(); lc++)
+        for (int lr=0; lr<dA.lrows(); lr++)
+          if (dA(lr,lc) != A(dA.rowl2g(lr),dA.coll2g(lc))) {
+            cout << "# ERROR: DistributedMatrix::random differs from"
+                 << " DenseMatrix::random on a " << grid.nprows()
+                 << "x" << grid.npcols() << " grid, block size "
+                 << nb << endl;
+            err++;
+            lc = dA.lcols();
+            break;
+          }
+    }
+  }
+  return c.all_reduce(err, MPI_SUM);
+}
+
+int main(int argc, char* argv[]) {
+  MPI_Init(&argc, &argv);
+  int err = 0;
+  {
+    MPIComm c;
+    err += test_grids<double>(c, 100, 37);
+    err += test_grids<complex<float>>(c, 57, 61);
+    if (!err && !c.rank())
+      cout << "# DistributedMatrix::random does not depend on the grid"
+           << endl;
+  }
+  scalapack::Cblacs_exit(1);
+  MPI_Finalize();
+  return err ? 1 : 0;
+}
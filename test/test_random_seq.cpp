@@ -0,0 +1,139 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <vector>
+#include <cstdio>
+using namespace std;
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+#include "dense/DenseMatrix.hpp"
+#include "misc/RandomWrapper.hpp"
+using namespace strumpack;
+using namespace strumpack::random;
+
+
+/*
+ * Known answers for Philox4x32-10, from the Random123 distribution
+ * (kat_vectors), for the counter, key and expected output.
+ */
+int test_known_answers() {
+  using words4_t = array<uint32_t,4>;
+  using words2_t = array<uint32_t,2>;
+  struct { words4_t ctr; words2_t key; words4_t out; } kat[] = {
+    {{{0, 0, 0, 0}}, {{0, 0}},
+     {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}}},
+    {{{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+     {{0xffffffff, 0xffffffff}},
+     {{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}}},
+    {{{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+     {{0xa4093822, 0x299f31d0}},
+     {{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}}};
+  int err = 0;
+  for (auto& t : kat) {
+    auto out = PhiloxGenerator<double>::philox(t.ctr, t.key);
+    if (out != t.out) {
+      cout << "# ERROR: Philox4x32-10 known answer test failed for key "
+           << hex << t.key[0] << " " << t.key[1] << dec << endl;
+      err++;
+    }
+  }
+  return err;
+}
+
+/*
+ * get(), get_at(k) and get_at(k, n, x) should all give the same
+ * numbers of the stream, also after a discard or when not starting
+ * at the first number of a counter.
+ */
+template<typename real_t> int test_stream(RandomDistribution d) {
+  const std::size_t n = 103;
+  PhiloxGenerator<real_t> rgen(7, d);
+  rgen.discard(3);
+  vector<real_t> at(n), block(n), seq(n);
+  for (size_t i=0; i<n; i++) at[i] = rgen.get_at(i);
+  rgen.get_at(0, n, block.data());
+  for (size_t i=0; i<n; i++) seq[i] = rgen.get();
+  int err = 0;
+  for (size_t i=0; i<n; i++) {
+    if (at[i] != seq[i] || block[i] != seq[i]) err++;
+    if (d == RandomDistribution::UNIFORM &&
+        (seq[i] < real_t(0.) || seq[i] >= real_t(1.))) err++;
+  }
+  // the block starting at an offset in a counter
+  rgen.get_at(5, n-10, block.data());
+  PhiloxGenerator<real_t> rgen2(7, d);
+  rgen2.discard(3 + n + 5);
+  for (size_t i=0; i<n-10; i++)
+    if (block[i] != rgen2.get()) err++;
+  if (err)
+    cout << "# ERROR: inconsistent Philox stream for "
+         << (is_same<real_t,float>() ? "float " : "double ")
+         << get_name(d) << endl;
+  return err;
+}
+
+/*
+ * DenseMatrix::random() with a counter-based generator should not
+ * depend on the number of threads.
+ */
+template<typename scalar_t> int test_threads(int m, int n) {
+#if defined(_OPENMP)
+  int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  DenseMatrix<scalar_t> A1(m, n);
+  A1.random();
+  omp_set_num_threads(std::max(4, threads));
+  DenseMatrix<scalar_t> A4(m, n);
+  A4.random();
+  omp_set_num_threads(threads);
+  for (int j=0; j<n; j++)
+    for (int i=0; i<m; i++)
+      if (A1(i,j) != A4(i,j)) {
+        cout << "# ERROR: DenseMatrix::random depends on the"
+             << " number of threads" << endl;
+        return 1;
+      }
+#endif
+  return 0;
+}
+
+int main() {
+  int err = test_known_answers();
+  err += test_stream<float>(RandomDistribution::UNIFORM);
+  err += test_stream<float>(RandomDistribution::NORMAL);
+  err += test_stream<double>(RandomDistribution::UNIFORM);
+  err += test_stream<double>(RandomDistribution::NORMAL);
+  err += test_threads<double>(1000, 37);
+  err += test_threads<std::complex<float>>(333, 41);
+  if (err) return 1;
+  cout << "# all random number tests passed" << endl;
+  return 0;
+}
@@ -0,0 +1,201 @@
+/*
+ * STRUMPACK -- STRUctured Matrices PACKage, Copyright (c) 2014, The
+ * Regents of the University of California, through Lawrence Berkeley
+ * National Laboratory (subject to receipt of any required approvals
+ * from the U.S. Dept. of Energy).  All rights reserved.
+ *
+ * If you have questions about your rights to use or distribute this
+ * software, please contact Berkeley Lab's Technology Transfer
+ * Department at TTD@lbl.gov.
+ *
+ * NOTICE. This software is owned by the U.S. Department of Energy. As
+ * such, the U.S. Government has been granted for itself and others
+ * acting on its behalf a paid-up, nonexclusive, irrevocable,
+ * worldwide license in the Software to reproduce, prepare derivative
+ * works, and perform publicly and display publicly.  Beginning five
+ * (5) years after the date permission to assert copyright is obtained
+ * from the U.S. Department of Energy, and subject to any subsequent
+ * five (5) year renewals, the U.S. Government is granted for itself
+ * and others acting on its behalf a paid-up, nonexclusive,
+ * irrevocable, worldwide license in the Software to reproduce,
+ * prepare derivative works, distribute copies to the public, perform
+ * publicly and display publicly, and to permit others to do so.
+ *
+ * Developers: Pieter Ghysels, Francois-Henry Rouet, Xiaoye S. Li.
+ *             (Lawrence Berkeley National Lab, Computational Research
+ *             Division).
+ *
+ */
+#include <iostream>
+#include <random>
+using namespace std;
+
+#include "StrumpackSparseSolver.hpp"
+#include "sparse/CSRMatrix.hpp"
+#include "sparse/FrontalMatrixDense.hpp"
+#include "sparse/FrontalMatrixHSS.hpp"
+using namespace strumpack;
+
+#define ERROR_TOLERANCE 1e2
+
+using F_t = FrontalMatrix<double,int>;
+using FHSS_t = FrontalMatrixHSS<double,int>;
+
+/**
+ * The initial number of random samples of an HSS front is taken
+ * from the HSS ranks of its children, rounded up to a multiple of
+ * dd, or is d0 if no child is HSS compressed.
+ */
+int test_initial_samples() {
+  HSS::HSSOptions<double> opts;
+  opts.set_verbose(false);
+  opts.set_leaf_size(16);
+  opts.set_d0(40);
+  opts.set_dd(8);
+
+  vector<int> upd;
+  FHSS_t F(2, 0, 0, upd);
+  if (F.initial_samples(opts) != opts.d0()) {
+    cout << "ERROR: wrong initial samples without children" << endl;
+    return 1;
+  }
+  F.set_lchild
+    (unique_ptr<F_t>(new FrontalMatrixDense<double,int>(0, 0, 0, upd)));
+  if (F.initial_samples(opts) != opts.d0()) {
+    cout << "ERROR: wrong initial samples with dense children" << endl;
+    return 1;
+  }
+
+  // HSS children, compressed from random matrices of known rank
+  int n = 200, r[2] = {5, 19};
+  mt19937 gen(1);
+  normal_distribution<double> nd;
+  int rmax = 0;
+  for (int c=0; c<2; c++) {
+    DenseMatrix<double> U(n, r[c]), V(r[c], n), A(n, n);
+    for (int j=0; j<r[c]; j++)
+      for (int i=0; i<n; i++) {
+        U(i, j) = nd(gen);
+        V(j, i) = nd(gen);
+      }
+    gemm(Trans::N, Trans::N, 1., U, V, 0., A);
+    for (int i=0; i<n; i++) A(i, i) += 1.;
+    unique_ptr<FHSS_t> ch(new FHSS_t(c, 0, 0, upd));
+    ch->_H = HSS::HSSMatrix<double>(A, opts);
+    if (!ch->_H.is_compressed()) {
+      cout << "ERROR: compression of child " << c << " failed" << endl;
+      return 1;
+    }
+    rmax = std::max(rmax, ch->front_rank());
+    if (c == 0) F.set_lchild(std::move(ch));
+    else F.set_rchild(std::move(ch));
+  }
+  auto d0 = F.initial_samples(opts);
+  cout << "# children ranks " << F.lchild()->front_rank() << ", "
+       << F.rchild()->front_rank() << ", initial samples " << d0 << endl;
+  if (d0 % opts.dd() || d0 < rmax || d0 >= rmax + opts.dd()) {
+    cout << "ERROR: initial samples not estimated from the children"
+         << endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Solve with HSS fronts, with the initial sample count estimated per
+ * front and with the global d0 (the default). Both should reach the
+ * same accuracy.
+ */
+int test_rank_estimate
+(int argc, char* argv[], CSRMatrix<double,int>& A) {
+  int N = A.size();
+  vector<double> b(N), x(N), x_exact(N, 1./sqrt(N));
+  A.spmv(x_exact.data(), b.data());
+  for (bool estimate : {true, false}) {
+    StrumpackSparseSolver<double,int> spss;
+    spss.options().enable_HSS();
+    spss.options().set_HSS_min_sep_size(20);
+    spss.options().HSS_options().set_leaf_size(8);
+    spss.options().set_from_command_line(argc, argv);
+    if (estimate) spss.options().enable_HSS_rank_estimate();
+    else spss.options().disable_HSS_rank_estimate();
+    spss.set_matrix(A);
+    if (spss.reorder() != ReturnCode::SUCCESS ||
+        spss.factor() != ReturnCode::SUCCESS) {
+      cout << "problem during factorization of the matrix." << endl;
+      return 1;
+    }
+    spss.solve(b.data(), x.data());
+    auto res = A.max_scaled_residual(x.data(), b.data());
+    cout << "# COMPONENTWISE SCALED RESIDUAL (rank estimate "
+         << (estimate ? "on" : "off") << ") = " << res
+         << ", max rank " << spss.maximum_rank() << endl;
+    if (res > ERROR_TOLERANCE*spss.options().rel_tol()) return 1;
+  }
+  return 0;
+}
+
+/**
+ * With indirect sampling, the random vectors used to sample a front
+ * can be regenerated when sampling the parent, instead of being
+ * stored. The generator is counter based, so this should give
+ * exactly the same factors, and solution, as storing them.
+ */
+int test_regenerate_random
+(int argc, char* argv[], CSRMatrix<double,int>& A) {
+  int N = A.size();
+  vector<double> b(N), x_exact(N, 1./sqrt(N));
+  vector<vector<double>> x(2, vector<double>(N));
+  A.spmv(x_exact.data(), b.data());
+  for (int regen=0; regen<2; regen++) {
+    StrumpackSparseSolver<double,int> spss;
+    spss.options().enable_HSS();
+    spss.options().set_HSS_min_sep_size(10);
+    spss.options().HSS_options().set_leaf_size(8);
+    spss.options().set_from_command_line(argc, argv);
+    spss.options().enable_indirect_sampling();
+    if (regen) spss.options().enable_HSS_regenerate_random();
+    else spss.options().disable_HSS_regenerate_random();
+    spss.set_matrix(A);
+    if (spss.reorder() != ReturnCode::SUCCESS ||
+        spss.factor() != ReturnCode::SUCCESS) {
+      cout << "problem during factorization of the matrix." << endl;
+      return 1;
+    }
+    spss.solve(b.data(), x[regen].data());
+  }
+  double diff = 0.;
+  for (int i=0; i<N; i++)
+    diff = std::max(diff, std::abs(x[0][i] - x[1][i]));
+  cout << "# max difference with regenerated random vectors = "
+       << diff << endl;
+  if (diff != 0.) {
+    cout << "ERROR: regenerating the random vectors changed the solution"
+         << endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    cout << "Usage: \n\t./test_sparse_HSS_seq pde900.mtx" << endl;
+    return 1;
+  }
+  cout << "# Running with:\n# ";
+#if defined(_OPENMP)
+  cout << "OMP_NUM_THREADS=" << omp_get_max_threads() << " ";
+#endif
+  for (int i=0; i<argc; i++) cout << argv[i] << " ";
+  cout << endl;
+
+  CSRMatrix<double,int> A;
+  if (A.read_matrix_market(argv[1])) {
+    cout << "could not read " << argv[1] << endl;
+    return 1;
+  }
+  if (test_initial_samples()) return 1;
+  if (test_rank_estimate(argc, argv, A)) return 1;
+  if (test_regenerate_random(argc, argv, A)) return 1;
+  return 0;
+}
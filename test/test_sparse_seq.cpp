@@ -37,6 +37,312 @@ using namespace strumpack;
 #define ERROR_TOLERANCE 1e2
 #define SOLVE_TOLERANCE 1e-12
 
+/*
+ * Solve with the exact solution x_exact = 1/sqrt(N), and check the
+ * componentwise scaled residual.
+ */
+template<typename scalar_t,typename integer_t> int
+test_solve(StrumpackSparseSolver<scalar_t,integer_t>& spss,
+           const CSRMatrix<scalar_t,integer_t>& A, const string& what) {
+  int N = A.size();
+  vector<scalar_t> b(N), x(N), x_exact(N, scalar_t(1.)/sqrt(N));
+  A.spmv(x_exact.data(), b.data());
+  spss.solve(b.data(), x.data());
+
+  auto comp_scal_res = A.max_scaled_residual(x.data(), b.data());
+  cout << "# COMPONENTWISE SCALED RESIDUAL" << what << " = "
+       << comp_scal_res << endl;
+
+  blas::axpy(N, scalar_t(-1.), x_exact.data(), 1, x.data(), 1);
+  auto nrm_error = blas::nrm2(N, x.data(), 1);
+  auto nrm_x_exact = blas::nrm2(N, x_exact.data(), 1);
+  cout << "# RELATIVE ERROR" << what << " = "
+       << (nrm_error/nrm_x_exact) << endl;
+
+  if (comp_scal_res > ERROR_TOLERANCE*spss.options().rel_tol()) return 1;
+  return 0;
+}
+
+/*
+ * Change the values, keep the sparsity pattern, and refactor,
+ * reusing the reordering and symbolic factorization.
+ */
+template<typename scalar_t,typename integer_t> int
+test_refactor(StrumpackSparseSolver<scalar_t,integer_t>& spss,
+              CSRMatrix<scalar_t,integer_t>& A) {
+  integer_t N = A.size();
+  for (integer_t r=0; r<N; r++)
+    for (integer_t j=A.ptr(r); j<A.ptr(r+1); j++)
+      if (A.ind(j) == r) A.val(j) *= scalar_t(2.);
+  spss.update_matrix_values(A);
+  if (spss.factor() != ReturnCode::SUCCESS) {
+    cout << "problem during refactorization of the matrix." << endl;
+    return 1;
+  }
+  return test_solve(spss, A, " (refactored)");
+}
+
+/*
+ * Right-hand sides b, shifted and scaled per column, as used in the
+ * tests with multiple right-hand sides.
+ */
+template<typename scalar_t,typename integer_t> DenseMatrix<scalar_t>
+test_rhs(const CSRMatrix<scalar_t,integer_t>& A, int nrhs) {
+  int N = A.size();
+  vector<scalar_t> b(N), x_exact(N, scalar_t(1.)/sqrt(N));
+  A.spmv(x_exact.data(), b.data());
+  DenseMatrix<scalar_t> B(N, nrhs);
+  for (int c=0; c<nrhs; c++)
+    for (int i=0; i<N; i++)
+      B(i, c) = b[(i+c) % N] * scalar_t(c+1);
+  return B;
+}
+
+/*
+ * Submit a number of right-hand sides from different threads, to be
+ * solved in batches.
+ */
+template<typename scalar_t,typename integer_t> int
+test_batched_solve(StrumpackSparseSolver<scalar_t,integer_t>& spss,
+                   const CSRMatrix<scalar_t,integer_t>& A) {
+  int N = A.size(), nrhs = 6;
+  spss.options().set_solve_batch_size(4);
+  auto B = test_rhs(A, nrhs);
+  DenseMatrix<scalar_t> X(N, nrhs);
+  vector<future<ReturnCode>> solved(nrhs);
+#pragma omp parallel for
+  for (int c=0; c<nrhs; c++)
+    solved[c] = spss.submit_solve(B.ptr(0, c), X.ptr(0, c));
+  spss.flush_solves();
+  for (int c=0; c<nrhs; c++)
+    if (solved[c].get() != ReturnCode::SUCCESS) {
+      cout << "problem during batched solve." << endl;
+      return 1;
+    }
+  auto comp_scal_res = A.max_scaled_residual(X, B);
+  cout << "# COMPONENTWISE SCALED RESIDUAL (batched) = "
+       << comp_scal_res << endl;
+  if (comp_scal_res > ERROR_TOLERANCE*spss.options().rel_tol()) return 1;
+  return 0;
+}
+
+/*
+ * Solves called from different threads at the same time share the
+ * workspace of the solver, which is rebuilt when the task recursion
+ * cutoff level changes.
+ */
+template<typename scalar_t,typename integer_t> int
+test_concurrent_solve(StrumpackSparseSolver<scalar_t,integer_t>& spss,
+                      const CSRMatrix<scalar_t,integer_t>& A) {
+  int N = A.size(), nrhs = 6;
+  auto B = test_rhs(A, nrhs);
+  DenseMatrix<scalar_t> X(N, nrhs);
+  auto cutoff = params::task_recursion_cutoff_level;
+  params::task_recursion_cutoff_level = cutoff + 1;
+  spss.solve(B.ptr(0, 0), X.ptr(0, 0));
+  params::task_recursion_cutoff_level = cutoff;
+  vector<ReturnCode> ierr(nrhs);
+#pragma omp parallel for
+  for (int c=0; c<nrhs; c++)
+    ierr[c] = spss.solve(B.ptr(0, c), X.ptr(0, c));
+  for (int c=0; c<nrhs; c++)
+    if (ierr[c] != ReturnCode::SUCCESS) {
+      cout << "problem during concurrent solve." << endl;
+      return 1;
+    }
+  auto comp_scal_res = A.max_scaled_residual(X, B);
+  cout << "# COMPONENTWISE SCALED RESIDUAL (concurrent) = "
+       << comp_scal_res << endl;
+  if (comp_scal_res > ERROR_TOLERANCE*spss.options().rel_tol()) return 1;
+  return 0;
+}
+
+/*
+ * Direct solve (without iterative refinement or Krylov solver) of x
+ * with a single right-hand side b. The other solves use the same
+ * factors, so this is the reference for comparing them.
+ */
+template<typename scalar_t,typename integer_t> void
+direct_solve(StrumpackSparseSolver<scalar_t,integer_t>& spss,
+             const scalar_t* b, scalar_t* x) {
+  auto krylov = spss.options().Krylov_solver();
+  spss.options().set_Krylov_solver(KrylovSolver::DIRECT);
+  spss.solve(b, x);
+  spss.options().set_Krylov_solver(krylov);
+}
+
+/*
+ * The pruned solve only skips zero blocks, so the difference with
+ * the direct solve should be well below the error of the compressed
+ * or single precision factors.
+ */
+template<typename scalar_t,typename integer_t> double
+same_factors_tolerance(const StrumpackSparseSolver<scalar_t,integer_t>& spss) {
+  auto& opts = spss.options();
+  double tol = 1e-10;
+  if (opts.mixed_precision()) tol = 1e-5;
+  if (opts.use_HSS())
+    tol = std::max(tol, 1e-3 * opts.HSS_options().rel_tol());
+  if (opts.use_BLR())
+    tol = std::max(tol, 1e-3 * opts.BLR_options().rel_tol());
+  return tol;
+}
+
+/*
+ * Sparse right-hand sides, computing only some of the components of
+ * the solution. The sparse solve does not use iterative refinement,
+ * so compare with a direct solve using the same (compressed)
+ * factors.
+ */
+template<typename scalar_t,typename integer_t> int
+test_sparse_solve(StrumpackSparseSolver<scalar_t,integer_t>& spss,
+                  const CSRMatrix<scalar_t,integer_t>& A) {
+  integer_t N = A.size();
+  int nrhs = 6;
+  spss.options().set_solve_batch_size(4);
+  vector<integer_t> b_ptr(nrhs+1), b_ind, sol;
+  vector<scalar_t> b_val;
+  for (int c=0; c<nrhs; c++) {
+    b_ptr[c] = b_ind.size();
+    for (integer_t i=(c*N)/nrhs; i<N; i+=N/2+c) {
+      b_ind.push_back(i);
+      b_val.push_back(scalar_t(c+1));
+    }
+  }
+  b_ptr[nrhs] = b_ind.size();
+  for (integer_t i=0; i<N; i+=7) sol.push_back(i);
+  vector<scalar_t> X(N*nrhs), b(N), x(N);
+  if (spss.sparse_solve
+      (nrhs, b_ptr.data(), b_ind.data(), b_val.data(), X.data(), N,
+       sol.size(), sol.data()) != ReturnCode::SUCCESS) {
+    cout << "problem during sparse solve." << endl;
+    return 1;
+  }
+  double sp_err = 0., sp_nrm = 0.;
+  for (int c=0; c<nrhs; c++) {
+    std::fill(b.begin(), b.end(), scalar_t(0.));
+    for (integer_t k=b_ptr[c]; k<b_ptr[c+1]; k++)
+      b[b_ind[k]] = b_val[k];
+    direct_solve(spss, b.data(), x.data());
+    for (integer_t i=0, s=0; i<N; i++) {
+      bool requested = s < integer_t(sol.size()) && sol[s] == i;
+      if (requested) s++;
+      sp_err = std::max
+        (sp_err, double(std::abs((requested ? x[i] : 0.) - X[i+c*N])));
+      sp_nrm = std::max(sp_nrm, double(std::abs(x[i])));
+    }
+  }
+  cout << "# SPARSE SOLVE ERROR = " << sp_err / sp_nrm << endl;
+  if (sp_err > same_factors_tolerance(spss) * sp_nrm) return 1;
+  return 0;
+}
+
+/*
+ * Selected inversion, compare the diagonal and the entries on the
+ * sparsity pattern of A with a few columns of inv(A).
+ */
+template<typename scalar_t,typename integer_t> int
+test_selected_inversion(StrumpackSparseSolver<scalar_t,integer_t>& spss,
+                        const CSRMatrix<scalar_t,integer_t>& A) {
+  integer_t N = A.size();
+  vector<scalar_t> Ainv_diag(N), Ainv_A(A.nnz()), e(N), x(N);
+  auto ierr = spss.inverse_diagonal(Ainv_diag.data());
+  if (ierr == ReturnCode::SUCCESS)
+    ierr = spss.inverse_on_pattern(A.ptr(), A.ind(), Ainv_A.data());
+  if (ierr == ReturnCode::NOT_SUPPORTED) {
+    cout << "# selected inversion not supported with these options" << endl;
+    return 0;
+  }
+  if (ierr != ReturnCode::SUCCESS) {
+    cout << "problem during selected inversion." << endl;
+    return 1;
+  }
+  if (spss.options().use_HSS() || spss.options().use_BLR()) return 0;
+  double inv_err = 0., inv_nrm = 0.;
+  for (integer_t c=0; c<N; c+=std::max(1, N/5)) {
+    std::fill(e.begin(), e.end(), scalar_t(0.));
+    e[c] = scalar_t(1.);
+    spss.solve(e.data(), x.data());
+    inv_err = std::max(inv_err, double(std::abs(x[c] - Ainv_diag[c])));
+    inv_nrm = std::max(inv_nrm, double(std::abs(x[c])));
+    for (integer_t r=0; r<N; r++)
+      for (integer_t j=A.ptr(r); j<A.ptr(r+1); j++)
+        if (A.ind(j) == c)
+          inv_err = std::max
+            (inv_err, double(std::abs(x[r] - Ainv_A[j])));
+  }
+  cout << "# SELECTED INVERSION ERROR = " << inv_err / inv_nrm << endl;
+  // with mixed precision, this is the inverse of the single
+  // precision factors, while the solve uses iterative refinement
+  auto inv_tol = spss.options().mixed_precision() ? 1e-5 : 1e-10;
+  if (inv_err > inv_tol * inv_nrm) return 1;
+  return 0;
+}
+
+/*
+ * The solve applies the matching permutation and scaling and the
+ * fill reducing ordering to the right-hand side and the solution in
+ * one pass, see StrumpackSparseSolver::setup_solve_plan. Solve
+ * with multiple right-hand sides, stored with a leading dimension
+ * larger than N, and compare with single right-hand side solves. When
+ * matching is enabled, the rows of A are first reversed and scaled,
+ * so the matching permutation is not the identity and the scaling is
+ * not trivial.
+ */
+template<typename scalar_t,typename integer_t> int
+test_solve_plan(const SPOptions<scalar_t>& opts,
+                const CSRMatrix<scalar_t,integer_t>& A) {
+  StrumpackSparseSolver<scalar_t,integer_t> spss;
+  spss.options() = opts;
+  spss.options().set_Krylov_solver(KrylovSolver::DIRECT);
+  integer_t N = A.size();
+  bool reverse = spss.options().matching() != MatchingJob::NONE;
+  vector<integer_t> ptr(N+1), ind;
+  vector<scalar_t> val;
+  for (integer_t i=0; i<N; i++) {
+    auto r = reverse ? N-1-i : i;
+    ptr[i] = ind.size();
+    for (integer_t j=A.ptr(r); j<A.ptr(r+1); j++) {
+      ind.push_back(A.ind(j));
+      val.push_back(reverse ? scalar_t(1 + i % 7) * A.val(j) : A.val(j));
+    }
+  }
+  ptr[N] = ind.size();
+  CSRMatrix<scalar_t,integer_t> Ar(N, ptr.data(), ind.data(), val.data());
+  spss.set_matrix(Ar);
+  if (spss.factor() != ReturnCode::SUCCESS) {
+    cout << "problem during factorization for the solve plan test." << endl;
+    return 1;
+  }
+  int nrhs = 5;
+  auto Bs = test_rhs(Ar, nrhs);
+  DenseMatrix<scalar_t> Bbig(N+3, nrhs), Xbig(N+4, nrhs);
+  DenseMatrixWrapper<scalar_t> B(N, nrhs, Bbig, 3, 0), X(N, nrhs, Xbig, 1, 0);
+  B.copy(Bs);
+  // solve a single column first, so the workspace has to be resized
+  vector<scalar_t> x(N), X1(N*nrhs);
+  direct_solve(spss, B.ptr(0, 0), x.data());
+  spss.solve(B, X);
+  for (int c=0; c<nrhs; c++)
+    direct_solve(spss, B.ptr(0, c), &X1[c*N]);
+  double err = 0., nrm = 0.;
+  for (int c=0; c<nrhs; c++)
+    for (integer_t i=0; i<N; i++) {
+      err = std::max(err, double(std::abs(X(i, c) - X1[i+c*N])));
+      nrm = std::max(nrm, double(std::abs(X1[i+c*N])));
+    }
+  auto comp_scal_res = Ar.max_scaled_residual(X, B);
+  cout << "# SOLVE PLAN, MULTIPLE RHS ERROR = " << err / nrm
+       << ", COMPONENTWISE SCALED RESIDUAL = " << comp_scal_res << endl;
+  if (err > same_factors_tolerance(spss) * nrm) return 1;
+  // the direct solve is not refined, so only check the residual for
+  // the exact factorization
+  if (!spss.options().use_HSS() && !spss.options().use_BLR() &&
+      !spss.options().mixed_precision() &&
+      comp_scal_res > ERROR_TOLERANCE*SOLVE_TOLERANCE) return 1;
+  return 0;
+}
+
 template<typename scalar_t,typename integer_t> int
 test(int argc, char* argv[], CSRMatrix<scalar_t,integer_t>& A) {
   StrumpackSparseSolver<scalar_t,integer_t> spss;
@@ -44,10 +350,6 @@ test(int argc, char* argv[], CSRMatrix<scalar_t,integer_t>& A) {
 
   TaskTimer::t_begin = GET_TIME_NOW();
 
-  int N = A.size();
-  vector<scalar_t> b(N), x(N), x_exact(N, scalar_t(1.)/sqrt(N));
-  A.spmv(x_exact.data(), b.data());
-
   spss.set_matrix(A);
   if (spss.reorder() != ReturnCode::SUCCESS) {
     cout << "problem with reordering of the matrix." << endl;
@@ -57,19 +359,13 @@ test(int argc, char* argv[], CSRMatrix<scalar_t,integer_t>& A) {
     cout << "problem during factorization of the matrix." << endl;
     return 1;
   }
-  spss.solve(b.data(), x.data());
-
-  auto comp_scal_res = A.max_scaled_residual(x.data(), b.data());
-  cout << "# COMPONENTWISE SCALED RESIDUAL = "
-       << comp_scal_res << endl;
-
-  blas::axpy(N, scalar_t(-1.), x_exact.data(), 1, x.data(), 1);
-  auto nrm_error = blas::nrm2(N, x.data(), 1);
-  auto nrm_x_exact = blas::nrm2(N, x_exact.data(), 1);
-  cout << "# RELATIVE ERROR = " << (nrm_error/nrm_x_exact) << endl;
-
-  if (comp_scal_res > ERROR_TOLERANCE*spss.options().rel_tol()) return 1;
-  else return 0;
+  if (test_solve(spss, A, "")) return 1;
+  if (test_refactor(spss, A)) return 1;
+  if (test_batched_solve(spss, A)) return 1;
+  if (test_concurrent_solve(spss, A)) return 1;
+  if (test_sparse_solve(spss, A)) return 1;
+  if (test_selected_inversion(spss, A)) return 1;
+  return test_solve_plan(spss.options(), A);
 }
 
 int main(int argc, char* argv[]) {